@@ -0,0 +1,415 @@
+//
+// bench_engine.cpp
+//
+// Host benchmark of the synthesis cost: Dexed::getSamples() with N playing
+// voices for every algorithm, feedback level and engine (EngineType=1..3),
+// and the stages after the TGs (AudioStereoMixer, the plate reverb and the
+// output converters) at chunk sizes from 64 to 1024 frames. Prints tables
+// and optionally writes the results as JSON, to compare releases.
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <synth_dexed.h>
+#include "common.h"
+#include "effect_mixer.hpp"
+#include "effect_platervbstereo.h"
+#include "arm_scale_zip_q23.h"
+#include "config.h"
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SAMPLE_RATE	48000
+#define ALGORITHMS	32
+#define FEEDBACKS	8
+#define MAX_FRAMES	1024
+
+static const unsigned ChunkFrames[] = {64, 128, 256, 512, 1024};
+static const unsigned MixerChannels = 8;
+
+static const struct
+{
+	unsigned nType;
+	const char *pName;
+}
+Engines[] =
+{
+	{MSFA,	"msfa"},		// EngineType=1 (Modern)
+	{MKI,	"mki"},			// EngineType=2 (Mark I)
+	{OPL,	"opl"}			// EngineType=3 (OPL)
+};
+
+static unsigned s_nMinNanos = 20000000;		// per case, see -m
+
+static unsigned long long Nanos (void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds> (
+		std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+// returns nanoseconds per call
+static double Measure (std::function<void (void)> Func)
+{
+	Func ();					// warm up the caches
+
+	unsigned long long nIterations = 0;
+	unsigned long long nStart = Nanos ();
+	unsigned long long nElapsed;
+
+	do
+	{
+		for (unsigned i = 0; i < 10; i++)
+		{
+			Func ();
+		}
+
+		nIterations += 10;
+		nElapsed = Nanos () - nStart;
+	}
+	while (nElapsed < s_nMinNanos);
+
+	return (double) nElapsed / nIterations;
+}
+
+// A voice, which keeps all six operators at full level, while the keys are
+// held, so that every voice is rendered completely in each block.
+static void InitVoice (uint8_t *pVoice, unsigned nAlgorithm, unsigned nFeedback)
+{
+	static const uint8_t OP[21] =
+	{
+		99, 99, 99, 99,		// EG rates
+		99, 99, 99, 0,		// EG levels
+		39, 0, 0, 0, 0,		// keyboard level scaling
+		0, 0, 0,		// rate scaling, AM sensitivity, velocity sensitivity
+		99,			// output level
+		0, 1, 0, 7		// ratio mode, coarse, fine, detune
+	};
+
+	for (unsigned nOP = 0; nOP < 6; nOP++)
+	{
+		memcpy (pVoice + nOP*21, OP, sizeof OP);
+		pVoice[nOP*21 + 18] = nOP + 1;			// different ratios
+	}
+
+	static const uint8_t Global[30] =
+	{
+		99, 99, 99, 99, 50, 50, 50, 50,	// pitch EG
+		0, 0, 1,			// algorithm, feedback, oscillator key sync
+		35, 0, 0, 0, 1, 0, 3,		// LFO
+		24,				// transpose
+		'B', 'E', 'N', 'C', 'H', ' ', ' ', ' ', ' ', ' '
+	};
+
+	memcpy (pVoice + DEXED_VOICE_OFFSET, Global, sizeof Global);
+	pVoice[DEXED_VOICE_OFFSET + DEXED_ALGORITHM] = nAlgorithm;
+	pVoice[DEXED_VOICE_OFFSET + DEXED_FEEDBACK] = nFeedback;
+}
+
+// returns ns per sample and voice
+static double BenchEngine (unsigned nEngine, unsigned nAlgorithm, unsigned nFeedback,
+			   unsigned nVoices, unsigned nFrames, unsigned *pPlaying)
+{
+	static float32_t Buffer[MAX_FRAMES];
+
+	uint8_t Voice[156];
+	InitVoice (Voice, nAlgorithm, nFeedback);
+
+	Dexed *pDexed = new Dexed (nVoices, SAMPLE_RATE);
+	pDexed->setEngineType (nEngine);
+	pDexed->activate ();
+	pDexed->loadVoiceParameters (Voice);
+
+	for (unsigned i = 0; i < nVoices; i++)
+	{
+		pDexed->keydown (24 + i*3, 100);
+	}
+
+	// let the attack pass
+	for (unsigned i = 0; i < SAMPLE_RATE/10; i += nFrames)
+	{
+		pDexed->getSamples (Buffer, nFrames);
+	}
+
+	*pPlaying = pDexed->getNumNotesPlaying ();
+
+	double fNanos = Measure ([pDexed, nFrames] { pDexed->getSamples (Buffer, nFrames); });
+
+	delete pDexed;
+
+	return fNanos / (nFrames * nVoices);
+}
+
+static float32_t Input[MixerChannels][MAX_FRAMES];
+
+// returns ns per input sample
+static double BenchMixer (unsigned nFrames, bool bWithSend)
+{
+	AudioStereoMixer<MixerChannels> Mixer (nFrames);
+	AudioStereoMixer<MixerChannels> SendMixer (nFrames);
+
+	for (unsigned i = 0; i < MixerChannels; i++)
+	{
+		Mixer.pan (i, (float32_t) i / (MixerChannels-1));
+		Mixer.gain (i, 0.7f);
+		SendMixer.gain (i, 0.5f);
+	}
+
+	double fNanos = Measure ([&Mixer, &SendMixer, bWithSend]
+		{
+			Mixer.zeroFill ();
+			if (bWithSend)
+			{
+				SendMixer.zeroFill ();
+			}
+
+			for (unsigned i = 0; i < MixerChannels; i++)
+			{
+				if (bWithSend)
+				{
+					Mixer.doAddMixWithSend (i, Input[i], &SendMixer);
+				}
+				else
+				{
+					Mixer.doAddMix (i, Input[i]);
+				}
+			}
+		});
+
+	return fNanos / (nFrames * MixerChannels);
+}
+
+// returns ns per frame
+static double BenchReverb (unsigned nFrames)
+{
+	static float32_t Output[2][MAX_FRAMES];
+
+	AudioEffectPlateReverb *pReverb = new AudioEffectPlateReverb (SAMPLE_RATE);
+	pReverb->size (0.7f);
+	pReverb->level (0.5f);
+
+	double fNanos = Measure ([pReverb, nFrames]
+		{
+			pReverb->doReverb (Input[0], Input[1], Output[0], Output[1], nFrames);
+		});
+
+	delete pReverb;
+
+	return fNanos / nFrames;
+}
+
+// returns ns per frame
+static double BenchOutput (unsigned nFrames, unsigned nChannels)
+{
+	static q23_t Output[MAX_FRAMES * MixerChannels];
+
+	const float32_t *pChannel[MixerChannels];
+	for (unsigned i = 0; i < MixerChannels; i++)
+	{
+		pChannel[i] = Input[i];
+	}
+
+	double fNanos = Measure ([&pChannel, nFrames, nChannels]
+		{
+			if (nChannels == 2)
+			{
+				arm_scale_zip_q23 (Input[0], Input[1], 0.5f, Output, nFrames);
+			}
+			else
+			{
+				arm_scale_zip8_q23 (pChannel, 0.5f, Output, nFrames);
+			}
+		});
+
+	return fNanos / nFrames;
+}
+
+static void Usage (const char *pProgram)
+{
+	fprintf (stderr, "Usage: %s [-v voices] [-c frames] [-m ms] [-j file.json]\n"
+			 "\t-v  playing voices per TG (default: polyphony of a TG)\n"
+			 "\t-c  frames per getSamples() call (default 128)\n"
+			 "\t-m  measuring time per case in ms (default 20)\n"
+			 "\t-j  write the results as JSON\n", pProgram);
+}
+
+int main (int argc, char **argv)
+{
+	unsigned nVoices = CConfig::DefaultNotes;
+	unsigned nFrames = 128;			// per TG with the default ChunkSize=256
+	const char *pJSONFileName = 0;
+
+	int nOption;
+	while ((nOption = getopt (argc, argv, "v:c:m:j:")) != -1)
+	{
+		switch (nOption)
+		{
+		case 'v':	nVoices = atoi (optarg);		break;
+		case 'c':	nFrames = atoi (optarg);		break;
+		case 'm':	s_nMinNanos = atoi (optarg) * 1000000U;	break;
+		case 'j':	pJSONFileName = optarg;			break;
+
+		default:
+			Usage (argv[0]);
+			return 1;
+		}
+	}
+
+	if (   nVoices < 1 || nVoices > CConfig::MaxNotes
+	    || nFrames < 1 || nFrames > MAX_FRAMES)
+	{
+		Usage (argv[0]);
+		return 1;
+	}
+
+	// noise at -6 dB
+	srand (1);
+	for (unsigned i = 0; i < MixerChannels; i++)
+	{
+		for (unsigned j = 0; j < MAX_FRAMES; j++)
+		{
+			Input[i][j] = (float32_t) rand () / RAND_MAX - 0.5f;
+		}
+	}
+
+#if defined (ARM_MATH_NEON)
+	const char *pSIMD = "neon";
+#else
+	const char *pSIMD = "scalar";
+#endif
+
+	std::string JSON;
+	char Line[200];
+
+	snprintf (Line, sizeof Line, "{\n\t\"simd\": \"%s\",\n\t\"sample_rate\": %u,\n"
+				     "\t\"voices\": %u,\n\t\"frames\": %u,\n",
+		  pSIMD, SAMPLE_RATE, nVoices, nFrames);
+	JSON += Line;
+
+	printf ("Engine benchmark (%s), %u voices, %u frames per call, ns/sample/voice\n",
+		pSIMD, nVoices, nFrames);
+
+	JSON += "\t\"engines\": [";
+	bool bFirst = true;
+	for (const auto &rEngine : Engines)
+	{
+		printf ("\n%-4s %4s", rEngine.pName, "alg");
+		for (unsigned nFeedback = 0; nFeedback < FEEDBACKS; nFeedback++)
+		{
+			printf ("   fb=%u", nFeedback);
+		}
+		printf ("\n");
+
+		double fSum = 0.0;
+		for (unsigned nAlgorithm = 0; nAlgorithm < ALGORITHMS; nAlgorithm++)
+		{
+			printf ("     %4u", nAlgorithm+1);
+
+			for (unsigned nFeedback = 0; nFeedback < FEEDBACKS; nFeedback++)
+			{
+				unsigned nPlaying;
+				double fNanos = BenchEngine (rEngine.nType, nAlgorithm, nFeedback,
+							     nVoices, nFrames, &nPlaying);
+				fSum += fNanos;
+
+				printf (" %7.2f", fNanos);
+				if (nPlaying != nVoices)
+				{
+					printf ("*");		// voice stealing or not sustained
+				}
+				fflush (stdout);
+
+				snprintf (Line, sizeof Line, "%s\n\t\t{\"engine\": \"%s\", \"algorithm\": %u, "
+							     "\"feedback\": %u, \"playing\": %u, "
+							     "\"ns_per_sample_voice\": %.3f}",
+					  bFirst ? "" : ",", rEngine.pName, nAlgorithm+1, nFeedback,
+					  nPlaying, fNanos);
+				JSON += Line;
+				bFirst = false;
+			}
+
+			printf ("\n");
+		}
+
+		printf ("%-4s mean %.2f\n", rEngine.pName, fSum / (ALGORITHMS * FEEDBACKS));
+	}
+	JSON += "\n\t],\n";
+
+	printf ("\n%-32s", "frames");
+	for (unsigned nChunk : ChunkFrames)
+	{
+		printf (" %8u", nChunk);
+	}
+	printf ("\n");
+
+	static const struct
+	{
+		const char *pName;
+		const char *pUnit;
+		std::function<double (unsigned)> Func;
+	}
+	Stages[] =
+	{
+		{"mixer",		"ns_per_sample",	[] (unsigned n) { return BenchMixer (n, false); }},
+		{"mixer_with_send",	"ns_per_sample",	[] (unsigned n) { return BenchMixer (n, true); }},
+		{"reverb",		"ns_per_frame",		BenchReverb},
+		{"scale_zip_q23",	"ns_per_frame",		[] (unsigned n) { return BenchOutput (n, 2); }},
+		{"scale_zip8_q23",	"ns_per_frame",		[] (unsigned n) { return BenchOutput (n, 8); }}
+	};
+
+	JSON += "\t\"stages\": [";
+	bFirst = true;
+	for (const auto &rStage : Stages)
+	{
+		snprintf (Line, sizeof Line, "%s (%s)", rStage.pName, rStage.pUnit);
+		printf ("%-32s", Line);
+
+		for (unsigned nChunk : ChunkFrames)
+		{
+			double fNanos = rStage.Func (nChunk);
+			printf (" %8.2f", fNanos);
+			fflush (stdout);
+
+			snprintf (Line, sizeof Line, "%s\n\t\t{\"stage\": \"%s\", \"frames\": %u, \"%s\": %.3f}",
+				  bFirst ? "" : ",", rStage.pName, nChunk, rStage.pUnit, fNanos);
+			JSON += Line;
+			bFirst = false;
+		}
+
+		printf ("\n");
+	}
+	JSON += "\n\t]\n}\n";
+
+	if (pJSONFileName)
+	{
+		FILE *pFile = fopen (pJSONFileName, "w");
+		if (!pFile)
+		{
+			perror (pJSONFileName);
+			return 1;
+		}
+
+		fputs (JSON.c_str (), pFile);
+		fclose (pFile);
+	}
+
+	return 0;
+}
@@ -0,0 +1,182 @@
+//
+// bench_output.c
+//
+// Host benchmark for the output stage: compares the two stage conversion
+// (arm_scale_zip_f32 + arm_float_to_q23, resp. the scalar 8-channel
+// interleave) with the fused arm_scale_zip_q23 / arm_scale_zip8_q23 kernels
+// across chunk sizes and checks that both produce identical samples.
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "arm_float_to_q23.h"
+#include "arm_scale_zip_f32.h"
+#include "arm_scale_zip_q23.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_FRAMES	2048
+#define CHANNELS_8	8
+#define MIN_NANOS	200000000ULL		// measure each case at least 0.2s
+
+static float32_t Input[CHANNELS_8][MAX_FRAMES];
+static float32_t TmpFloat[MAX_FRAMES * CHANNELS_8];
+static q23_t OutputRef[MAX_FRAMES * CHANNELS_8];
+static q23_t OutputFused[MAX_FRAMES * CHANNELS_8];
+
+static unsigned long long Nanos (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void TwoStageStereo (unsigned nFrames, float32_t fScale)
+{
+	arm_scale_zip_f32 (Input[0], Input[1], fScale, TmpFloat, nFrames);
+	arm_float_to_q23 (TmpFloat, OutputRef, nFrames*2);
+
+	if (OutputRef[nFrames*2 - 1] == 0)
+	{
+		OutputRef[nFrames*2 - 1]++;
+	}
+}
+
+static void FusedStereo (unsigned nFrames, float32_t fScale)
+{
+	arm_scale_zip_q23 (Input[0], Input[1], fScale, OutputFused, nFrames);
+}
+
+static void TwoStage8Chan (unsigned nFrames, float32_t fScale)
+{
+	for (unsigned i = 0; i < nFrames; i++)
+	{
+		for (unsigned tg = 0; tg < CHANNELS_8; tg++)
+		{
+			TmpFloat[i*CHANNELS_8 + tg] = Input[tg][i] * fScale;
+		}
+	}
+
+	arm_float_to_q23 (TmpFloat, OutputRef, nFrames*CHANNELS_8);
+
+	for (unsigned tg = 0; tg < CHANNELS_8; tg++)
+	{
+		if (OutputRef[(nFrames-1)*CHANNELS_8 + tg] == 0)
+		{
+			OutputRef[(nFrames-1)*CHANNELS_8 + tg]++;
+		}
+	}
+}
+
+static void Fused8Chan (unsigned nFrames, float32_t fScale)
+{
+	const float32_t *pChannel[CHANNELS_8];
+	for (unsigned tg = 0; tg < CHANNELS_8; tg++)
+	{
+		pChannel[tg] = Input[tg];
+	}
+
+	arm_scale_zip8_q23 (pChannel, fScale, OutputFused, nFrames);
+}
+
+// returns nanoseconds per call
+static double Measure (void (*pFunc) (unsigned, float32_t), unsigned nFrames)
+{
+	unsigned long long nIterations = 0;
+	unsigned long long nStart = Nanos ();
+	unsigned long long nElapsed;
+
+	do
+	{
+		for (unsigned i = 0; i < 1000; i++)
+		{
+			(*pFunc) (nFrames, 0.5f);
+		}
+
+		nIterations += 1000;
+		nElapsed = Nanos () - nStart;
+	}
+	while (nElapsed < MIN_NANOS);
+
+	return (double) nElapsed / nIterations;
+}
+
+static int Compare (const char *pMode, unsigned nFrames, unsigned nChannels)
+{
+	if (memcmp (OutputRef, OutputFused, nFrames*nChannels * sizeof (q23_t)) != 0)
+	{
+		fprintf (stderr, "%s: output mismatch at %u frames\n", pMode, nFrames);
+
+		return 0;
+	}
+
+	return 1;
+}
+
+int main (void)
+{
+	static const unsigned ChunkFrames[] = {16, 32, 64, 128, 256, 512, 1024, 2048};
+	int bOK = 1;
+
+	// noise with some overdriven samples, the last frame of each chunk is
+	// silent to exercise the PCM510x mute prevention
+	srand (1);
+	for (unsigned tg = 0; tg < CHANNELS_8; tg++)
+	{
+		for (unsigned i = 0; i < MAX_FRAMES; i++)
+		{
+			Input[tg][i] = (i+1) % 16 ? 5.0f * ((float32_t) rand () / RAND_MAX - 0.5f) : 0.0f;
+		}
+	}
+
+#if defined(ARM_MATH_NEON_EXPERIMENTAL)
+	printf ("Output stage benchmark (NEON)\n\n");
+#else
+	printf ("Output stage benchmark (scalar)\n\n");
+#endif
+	printf ("%-8s %8s %14s %14s %9s\n", "mode", "frames", "2-stage ns", "fused ns", "speedup");
+
+	for (unsigned i = 0; i < sizeof ChunkFrames / sizeof ChunkFrames[0]; i++)
+	{
+		unsigned nFrames = ChunkFrames[i];
+
+		TwoStageStereo (nFrames, 0.5f);
+		FusedStereo (nFrames, 0.5f);
+		bOK &= Compare ("stereo", nFrames, 2);
+
+		double fTwoStage = Measure (TwoStageStereo, nFrames);
+		double fFused = Measure (FusedStereo, nFrames);
+		printf ("%-8s %8u %14.1f %14.1f %8.2fx\n", "stereo", nFrames, fTwoStage, fFused, fTwoStage / fFused);
+	}
+
+	for (unsigned i = 0; i < sizeof ChunkFrames / sizeof ChunkFrames[0]; i++)
+	{
+		unsigned nFrames = ChunkFrames[i];
+
+		TwoStage8Chan (nFrames, 0.5f);
+		Fused8Chan (nFrames, 0.5f);
+		bOK &= Compare ("8-chan", nFrames, CHANNELS_8);
+
+		double fTwoStage = Measure (TwoStage8Chan, nFrames);
+		double fFused = Measure (Fused8Chan, nFrames);
+		printf ("%-8s %8u %14.1f %14.1f %8.2fx\n", "8-chan", nFrames, fTwoStage, fFused, fTwoStage / fFused);
+	}
+
+	return bOK ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+//
+// midi2wav.cpp
+//
+// Renders a Standard MIDI File to a 24-bit WAV file with the MiniDexed synth
+// core as fast as possible, e.g. to pre-render backing tracks with the sound
+// of the hardware. The current working directory (or the directory given
+// with -C) takes the place of the SD card (minidexed.ini, performance.ini,
+// sysex/, performance/). The TGs are rendered on all cores (CORES, see the
+// Makefile).
+//
+// The output is deterministic, so that it can be compared with a reference
+// rendering in regression tests: The clock is virtual and the sound device
+// is paced by this program. Before a chunk is released for rendering, the
+// MIDI events falling into it are sent to the serial MIDI device with the
+// virtual clock set to their time, so that they are applied at their
+// position in the chunk with MIDIEventTiming=1, or at its start otherwise.
+// Events, which are not applied through the TG event queue (e.g. volume or
+// pan changes), take effect in between chunks only with AudioPipelineDepth=1
+// (as in the default minidexed.ini).
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "minidexed.h"
+#include "config.h"
+#include "midifile.h"
+#include <circle/logger.h>
+#include <circle/timer.h>
+#include <circle/interrupt.h>
+#include <circle/gpiomanager.h>
+#include <circle/i2cmaster.h>
+#include <circle/serial.h>
+#include <circle/sound/soundbasedevice.h>
+#include <fatfs/ff.h>
+#include <chrono>
+#include <string>
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <hostfs.h>
+
+LOGMODULE ("midi2wav");
+
+static void Usage (const char *pProgram)
+{
+	fprintf (stderr, "Usage: %s [-C dir] [-p performance.ini] [-t seconds] [-d] file.mid file.wav\n"
+			 "\t-C  directory with the SD card files (default .)\n"
+			 "\t-p  performance file to load instead of performance.ini\n"
+			 "\t-t  tail after the end of the file in seconds (default 3)\n"
+			 "\t-d  enable debug messages\n", pProgram);
+}
+
+// the files given on the command line are relative to the original directory
+static std::string AbsolutePath (const char *pPath)
+{
+	char Directory[PATH_MAX];
+	if (*pPath == '/' || !getcwd (Directory, sizeof Directory))
+	{
+		return pPath;
+	}
+
+	return std::string (Directory) + "/" + pPath;
+}
+
+// virtual clock ticks (microseconds) at the start of the given frame, rounded
+// up, so that an event at frame n always falls before the ticks of frame n+1
+static u64 FrameToTicks (u64 nFrame, unsigned nSampleRate)
+{
+	return (nFrame * CLOCKHZ + nSampleRate - 1) / nSampleRate;
+}
+
+int main (int argc, char **argv)
+{
+	const char *pSDDirectory = 0;
+	const char *pPerformanceFile = 0;
+	unsigned nTailSeconds = 3;
+	bool bDebug = false;
+
+	int nOption;
+	while ((nOption = getopt (argc, argv, "C:p:t:d")) != -1)
+	{
+		switch (nOption)
+		{
+		case 'C':	pSDDirectory = optarg;		break;
+		case 'p':	pPerformanceFile = optarg;	break;
+		case 't':	nTailSeconds = atoi (optarg);	break;
+		case 'd':	bDebug = true;			break;
+
+		default:
+			Usage (argv[0]);
+			return 1;
+		}
+	}
+
+	if (argc - optind != 2)
+	{
+		Usage (argv[0]);
+		return 1;
+	}
+
+	std::string MIDIFileName = AbsolutePath (argv[optind]);
+	std::string WAVFileName = AbsolutePath (argv[optind+1]);
+	std::string PerformanceFileName = pPerformanceFile ? AbsolutePath (pPerformanceFile) : "";
+
+	if (pSDDirectory && chdir (pSDDirectory) != 0)
+	{
+		perror (pSDDirectory);
+		return 1;
+	}
+
+	if (pPerformanceFile)
+	{
+		HostMapFile ("performance.ini", PerformanceFileName.c_str ());
+	}
+
+	CLogger Logger (bDebug ? LogDebug : LogNotice);
+
+	CMIDIFile MIDIFile;
+	if (!MIDIFile.Load (MIDIFileName.c_str ()))
+	{
+		return 1;
+	}
+
+	// from here on, the time only advances as the song is rendered
+	CTimer::SetVirtualClock (0);
+
+	FATFS FileSystem;
+	CInterruptSystem Interrupt;
+	CGPIOManager GPIOManager (&Interrupt);
+	CI2CMaster I2CMaster (1, TRUE);
+
+	CConfig Config (&FileSystem);
+	Config.Load ();
+
+	unsigned nSampleRate = Config.GetSampleRate ();
+	u64 nTotalFrames = (MIDIFile.GetDuration () * nSampleRate + CLOCKHZ - 1) / CLOCKHZ
+			   + (u64) nTailSeconds * nSampleRate;
+	CSoundBaseDevice::SetOutput (WAVFileName.c_str (), SoundPacingExternal, nTotalFrames, 24);
+
+	if (Config.GetAudioPipelineDepth () > 1)
+	{
+		LOGNOTE ("AudioPipelineDepth > 1, volume and pan changes may be applied one chunk early or late");
+	}
+
+	CMiniDexed *pMiniDexed = new CMiniDexed (&Config, &Interrupt, &GPIOManager, &I2CMaster,
+						 nullptr, &FileSystem);
+	if (!pMiniDexed->Initialize ())
+	{
+		LOGERR ("Initialization failed");
+
+		return 1;
+	}
+
+	CSoundBaseDevice *pSound = CSoundBaseDevice::Get ();
+	assert (pSound);
+
+	// ProcessSound() renders half of the queue at once
+	unsigned nChunkFrames = pSound->GetQueueSizeFrames () / 2;
+	assert (nChunkFrames > 0);
+
+	const std::vector<CMIDIFile::TEvent> &rEvents = MIDIFile.GetEvents ();
+	size_t nNextEvent = 0;
+
+	u64 nFrame = 0;
+	u64 nVoiceFrames = 0;
+
+	auto StartTime = std::chrono::steady_clock::now ();
+
+	while (pSound->IsActive ())
+	{
+		u64 nChunkEnd = nFrame + nChunkFrames;
+		u64 nChunkEndTicks = FrameToTicks (nChunkEnd, nSampleRate);
+
+		for (; nNextEvent < rEvents.size () && rEvents[nNextEvent].nTime < nChunkEndTicks; nNextEvent++)
+		{
+			const CMIDIFile::TEvent &rEvent = rEvents[nNextEvent];
+
+			CTimer::SetVirtualClock (rEvent.nTime);
+			CSerialDevice::HostInput (rEvent.Message.data (), rEvent.Message.size ());
+
+			while (CSerialDevice::GetHostInputPending ())
+			{
+				pMiniDexed->Process (false);
+			}
+		}
+
+		// UI, performance loading etc.
+		CTimer::SetVirtualClock (nChunkEndTicks);
+		pMiniDexed->Process (false);
+
+		pSound->ReleaseFrames (nChunkFrames);
+		pSound->WaitFramesWritten (nChunkEnd);
+
+		nVoiceFrames += (u64) pMiniDexed->GetActiveVoices () * nChunkFrames;
+		nFrame = nChunkEnd;
+	}
+
+	double fElapsed = std::chrono::duration<double> (std::chrono::steady_clock::now () - StartTime).count ();
+	double fSeconds = (double) pSound->GetFramesWritten () / nSampleRate;
+	double fVoiceSeconds = (double) nVoiceFrames / nSampleRate;
+
+	LOGNOTE ("%.2fs rendered in %.2fs (%.1fx real time) on %u cores",
+		 fSeconds, fElapsed, fSeconds / fElapsed, CORES);
+	LOGNOTE ("%.1f voice-seconds, %.1f voice-seconds per second",
+		 fVoiceSeconds, fVoiceSeconds / fElapsed);
+
+	delete pMiniDexed;
+
+	return 0;
+}
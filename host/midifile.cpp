@@ -0,0 +1,354 @@
+//
+// midifile.cpp
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "midifile.h"
+#include <circle/logger.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+LOGMODULE ("midifile");
+
+static const unsigned DefaultTempo = 500000;		// 120 BPM
+
+static const uint8_t MetaEvent = 0xFF;
+static const uint8_t MetaEndOfTrack = 0x2F;
+static const uint8_t MetaSetTempo = 0x51;
+
+static uint32_t GetBE (const uint8_t *pData, unsigned nBytes)
+{
+	uint32_t nValue = 0;
+	while (nBytes--)
+	{
+		nValue = nValue << 8 | *pData++;
+	}
+
+	return nValue;
+}
+
+CMIDIFile::CMIDIFile (void)
+:	m_nDivision (0),
+	m_nTicksPer100s (0),
+	m_nLastTick (0),
+	m_nDuration (0)
+{
+}
+
+CMIDIFile::~CMIDIFile (void)
+{
+}
+
+bool CMIDIFile::Load (const char *pFileName)
+{
+	assert (pFileName);
+
+	FILE *pFile = fopen (pFileName, "rb");
+	if (!pFile)
+	{
+		LOGERR ("%s: Cannot open", pFileName);
+
+		return false;
+	}
+
+	std::vector<uint8_t> File;
+	uint8_t Buffer[4096];
+	size_t nRead;
+	while ((nRead = fread (Buffer, 1, sizeof Buffer, pFile)) > 0)
+	{
+		File.insert (File.end (), Buffer, Buffer + nRead);
+	}
+
+	fclose (pFile);
+
+	const uint8_t *pData = File.data ();
+	const uint8_t *pEnd = pData + File.size ();
+
+	if (   File.size () < 14
+	    || memcmp (pData, "MThd", 4) != 0
+	    || GetBE (pData+4, 4) < 6)
+	{
+		LOGERR ("%s: Not a Standard MIDI File", pFileName);
+
+		return false;
+	}
+
+	unsigned nFormat = GetBE (pData+8, 2);
+	unsigned nTracks = GetBE (pData+10, 2);
+	unsigned nDivision = GetBE (pData+12, 2);
+
+	if (nFormat > 1)
+	{
+		LOGERR ("%s: Format %u is not supported", pFileName, nFormat);
+
+		return false;
+	}
+
+	if (nDivision & 0x8000)
+	{
+		// SMPTE frames per second (negative) and ticks per frame, -29 is 29.97 fps
+		int nFPS = -(int8_t) (nDivision >> 8);
+		unsigned nFPS100 = nFPS == 29 ? 2997 : nFPS * 100;
+		m_nTicksPer100s = nFPS100 * (nDivision & 0xFF);
+	}
+	else
+	{
+		m_nDivision = nDivision;
+	}
+
+	if (!m_nDivision && !m_nTicksPer100s)
+	{
+		LOGERR ("%s: Invalid time division", pFileName);
+
+		return false;
+	}
+
+	pData += 8 + GetBE (pData+4, 4);
+
+	m_TrackEvents.clear ();
+	m_Tempo.clear ();
+	m_nLastTick = 0;
+
+	unsigned nTrack = 0;
+	while (nTrack < nTracks && pEnd - pData >= 8)
+	{
+		uint32_t nLength = GetBE (pData+4, 4);
+		if (nLength > (size_t) (pEnd - pData - 8))
+		{
+			LOGERR ("%s: Track %u is truncated", pFileName, nTrack);
+
+			return false;
+		}
+
+		// unknown chunks are skipped
+		if (memcmp (pData, "MTrk", 4) == 0)
+		{
+			if (!ParseTrack (pData+8, nLength))
+			{
+				LOGERR ("%s: Track %u is invalid", pFileName, nTrack);
+
+				return false;
+			}
+
+			nTrack++;
+		}
+
+		pData += 8 + nLength;
+	}
+
+	if (nTrack < nTracks)
+	{
+		LOGNOTE ("%s: %u of %u tracks found", pFileName, nTrack, nTracks);
+	}
+
+	ConvertTicks ();
+
+	return true;
+}
+
+bool CMIDIFile::ParseTrack (const uint8_t *pData, size_t nLength)
+{
+	const uint8_t *pEnd = pData + nLength;
+
+	// the events of this track follow those of the previous tracks,
+	// they are merged in ConvertTicks()
+	uint64_t nTick = 0;
+	uint8_t uchRunningStatus = 0;
+
+	while (pData < pEnd)
+	{
+		uint32_t nDelta;
+		if (!ReadVarLen (&pData, pEnd, &nDelta) || pData >= pEnd)
+		{
+			return false;
+		}
+
+		nTick += nDelta;
+
+		uint8_t uchStatus = *pData;
+		if (uchStatus & 0x80)
+		{
+			pData++;
+		}
+		else if (uchRunningStatus)
+		{
+			uchStatus = uchRunningStatus;
+		}
+		else
+		{
+			return false;
+		}
+
+		TTrackEvent Event;
+		Event.nTick = nTick;
+
+		if (uchStatus == MetaEvent)
+		{
+			if (pData >= pEnd)
+			{
+				return false;
+			}
+
+			uint8_t uchType = *pData++;
+
+			uint32_t nDataLength;
+			if (   !ReadVarLen (&pData, pEnd, &nDataLength)
+			    || nDataLength > (size_t) (pEnd - pData))
+			{
+				return false;
+			}
+
+			if (uchType == MetaSetTempo && nDataLength == 3)
+			{
+				TTempo Tempo = {nTick, GetBE (pData, 3)};
+				m_Tempo.push_back (Tempo);
+			}
+
+			pData += nDataLength;
+			uchRunningStatus = 0;
+
+			if (uchType == MetaEndOfTrack)
+			{
+				break;
+			}
+
+			continue;
+		}
+
+		if (uchStatus == 0xF0 || uchStatus == 0xF7)
+		{
+			// SysEx (F0 <length> <data>) or escaped raw bytes (F7 <length> <bytes>)
+			uint32_t nDataLength;
+			if (   !ReadVarLen (&pData, pEnd, &nDataLength)
+			    || nDataLength > (size_t) (pEnd - pData))
+			{
+				return false;
+			}
+
+			if (uchStatus == 0xF0)
+			{
+				Event.Message.push_back (uchStatus);
+			}
+			Event.Message.insert (Event.Message.end (), pData, pData + nDataLength);
+
+			pData += nDataLength;
+			uchRunningStatus = 0;
+		}
+		else if (uchStatus >= 0xF0)
+		{
+			return false;			// system messages are not allowed in a file
+		}
+		else
+		{
+			unsigned nDataBytes = (uchStatus & 0xE0) == 0xC0 ? 1 : 2;	// program change, channel pressure
+			if (nDataBytes > (size_t) (pEnd - pData))
+			{
+				return false;
+			}
+
+			Event.Message.push_back (uchStatus);
+			Event.Message.insert (Event.Message.end (), pData, pData + nDataBytes);
+
+			pData += nDataBytes;
+			uchRunningStatus = uchStatus;
+		}
+
+		if (!Event.Message.empty ())
+		{
+			m_TrackEvents.push_back (std::move (Event));
+		}
+	}
+
+	if (nTick > m_nLastTick)
+	{
+		m_nLastTick = nTick;
+	}
+
+	return true;
+}
+
+// The events of all tracks are merged by their tick, events at the same tick
+// keep the order of the tracks. Ticks are converted with integer arithmetic,
+// so that the times do not depend on the floating point environment.
+void CMIDIFile::ConvertTicks (void)
+{
+	auto ByTick = [] (const auto &rA, const auto &rB) { return rA.nTick < rB.nTick; };
+	std::stable_sort (m_TrackEvents.begin (), m_TrackEvents.end (), ByTick);
+	std::stable_sort (m_Tempo.begin (), m_Tempo.end (), ByTick);
+
+	m_Events.clear ();
+	m_Events.reserve (m_TrackEvents.size ());
+
+	// the time at tick t is (nScaled + (t - nSegmentTick) * nTempo) / m_nDivision
+	uint64_t nScaled = 0;
+	uint64_t nSegmentTick = 0;
+	unsigned nTempo = DefaultTempo;
+	size_t nNextTempo = 0;
+
+	auto TickToMicros = [&] (uint64_t nTick) -> uint64_t
+	{
+		if (m_nTicksPer100s)
+		{
+			return nTick * 100000000ULL / m_nTicksPer100s;
+		}
+
+		for (; nNextTempo < m_Tempo.size () && m_Tempo[nNextTempo].nTick <= nTick; nNextTempo++)
+		{
+			nScaled += (m_Tempo[nNextTempo].nTick - nSegmentTick) * nTempo;
+			nSegmentTick = m_Tempo[nNextTempo].nTick;
+			nTempo = m_Tempo[nNextTempo].nMicrosPerQuarter;
+		}
+
+		return (nScaled + (nTick - nSegmentTick) * nTempo) / m_nDivision;
+	};
+
+	for (auto &rEvent : m_TrackEvents)
+	{
+		TEvent Event = {TickToMicros (rEvent.nTick), std::move (rEvent.Message)};
+		m_Events.push_back (std::move (Event));
+	}
+
+	m_nDuration = TickToMicros (m_nLastTick);
+
+	m_TrackEvents.clear ();
+}
+
+bool CMIDIFile::ReadVarLen (const uint8_t **ppData, const uint8_t *pEnd, uint32_t *pValue)
+{
+	uint32_t nValue = 0;
+	for (unsigned i = 0; i < 4; i++)
+	{
+		if (*ppData >= pEnd)
+		{
+			return false;
+		}
+
+		uint8_t uchByte = *(*ppData)++;
+		nValue = nValue << 7 | (uchByte & 0x7F);
+
+		if (!(uchByte & 0x80))
+		{
+			*pValue = nValue;
+
+			return true;
+		}
+	}
+
+	return false;
+}
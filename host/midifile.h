@@ -0,0 +1,81 @@
+//
+// midifile.h
+//
+// Reader for Standard MIDI Files (format 0 and 1). The events of all tracks
+// are merged and timed in microseconds according to the tempo map.
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _midifile_h
+#define _midifile_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class CMIDIFile
+{
+public:
+	struct TEvent
+	{
+		uint64_t nTime;				// microseconds from the start
+		std::vector<uint8_t> Message;		// as sent on a MIDI cable
+	};
+
+public:
+	CMIDIFile (void);
+	~CMIDIFile (void);
+
+	bool Load (const char *pFileName);
+
+	// channel messages and SysEx in the order to be sent, meta events are not included
+	const std::vector<TEvent> &GetEvents (void) const	{ return m_Events; }
+
+	uint64_t GetDuration (void) const		{ return m_nDuration; }	// microseconds
+
+private:
+	struct TTrackEvent
+	{
+		uint64_t nTick;
+		std::vector<uint8_t> Message;
+	};
+
+	struct TTempo
+	{
+		uint64_t nTick;
+		unsigned nMicrosPerQuarter;
+	};
+
+	bool ParseTrack (const uint8_t *pData, size_t nLength);
+
+	void ConvertTicks (void);			// m_TrackEvents to m_Events
+
+	static bool ReadVarLen (const uint8_t **ppData, const uint8_t *pEnd, uint32_t *pValue);
+
+private:
+	unsigned m_nDivision;				// ticks per quarter note
+	unsigned m_nTicksPer100s;			// SMPTE time division, else 0
+
+	std::vector<TTrackEvent> m_TrackEvents;		// all tracks, tick order per track
+	std::vector<TTempo> m_Tempo;
+	uint64_t m_nLastTick;
+
+	std::vector<TEvent> m_Events;
+	uint64_t m_nDuration;
+};
+
+#endif
@@ -0,0 +1,190 @@
+//
+// minidexed_host.cpp
+//
+// Runs MiniDexed as a Linux/macOS process on top of the POSIX shim, to
+// profile and debug the synth core with the usual host tools (perf,
+// valgrind, sanitizers). The current working directory takes the place of
+// the SD card (minidexed.ini, performance.ini, sysex/, performance/).
+// As there is no MIDI input, a chord pattern is played on all TGs.
+//
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "minidexed.h"
+#include "config.h"
+#include "trace.h"
+#include <circle/logger.h>
+#include <circle/timer.h>
+#include <circle/interrupt.h>
+#include <circle/gpiomanager.h>
+#include <circle/i2cmaster.h>
+#include <circle/sound/soundbasedevice.h>
+#include <fatfs/ff.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+LOGMODULE ("host");
+
+static void Usage (const char *pProgram)
+{
+	fprintf (stderr, "Usage: %s [-t seconds] [-o file.wav] [-T file.trace] [-f] [-d]\n"
+			 "\t-t  run time in seconds (default 10)\n"
+			 "\t-o  write the output to a WAV file\n"
+			 "\t-T  write the audio trace to a file (build with TRACE=1),\n"
+			 "\t    convert it with trace2json.py\n"
+			 "\t-f  render as fast as possible instead of in real time\n"
+			 "\t-d  enable debug messages\n", pProgram);
+}
+
+static void WriteTracePacket (const void *pPacket, unsigned nLength, void *pParam)
+{
+	fwrite (pPacket, nLength, 1, (FILE *) pParam);
+}
+
+int main (int argc, char **argv)
+{
+	unsigned nSeconds = 10;
+	const char *pWAVFileName = 0;
+	const char *pTraceFileName = 0;
+	bool bRealTime = true;
+	bool bDebug = false;
+
+	int nOption;
+	while ((nOption = getopt (argc, argv, "t:o:T:fd")) != -1)
+	{
+		switch (nOption)
+		{
+		case 't':	nSeconds = atoi (optarg);	break;
+		case 'o':	pWAVFileName = optarg;		break;
+		case 'T':	pTraceFileName = optarg;	break;
+		case 'f':	bRealTime = false;		break;
+		case 'd':	bDebug = true;			break;
+
+		default:
+			Usage (argv[0]);
+			return 1;
+		}
+	}
+
+	CLogger Logger (bDebug ? LogDebug : LogNotice);
+
+	FILE *pTraceFile = 0;
+	if (pTraceFileName)
+	{
+		pTraceFile = fopen (pTraceFileName, "wb");
+		if (!pTraceFile)
+		{
+			perror (pTraceFileName);
+			return 1;
+		}
+
+		if (!CTrace::Drain (WriteTracePacket, pTraceFile))
+		{
+			LOGERR ("Tracing is not built in (make TRACE=1)");
+
+			return 1;
+		}
+	}
+
+	FATFS FileSystem;
+	CInterruptSystem Interrupt;
+	CGPIOManager GPIOManager (&Interrupt);
+	CI2CMaster I2CMaster (1, TRUE);
+
+	CConfig Config (&FileSystem);
+	Config.Load ();
+
+	u64 nFrames = (u64) nSeconds * Config.GetSampleRate ();
+	CSoundBaseDevice::SetOutput (pWAVFileName,
+				     bRealTime ? SoundPacingRealTime : SoundPacingFreeRunning, nFrames);
+
+	CMiniDexed *pMiniDexed = new CMiniDexed (&Config, &Interrupt, &GPIOManager, &I2CMaster,
+						 nullptr, &FileSystem);
+	if (!pMiniDexed->Initialize ())
+	{
+		LOGERR ("Initialization failed");
+
+		return 1;
+	}
+
+	CSoundBaseDevice *pSound = CSoundBaseDevice::Get ();
+	assert (pSound);
+
+	// chord pattern, a new chord every 500ms, held for 400ms
+	static const int Chord[] = {48, 55, 60, 64, 67, 72};
+	static const unsigned ChordCount = sizeof Chord / sizeof Chord[0];
+	unsigned nStep = 0;
+	bool bKeysDown = false;
+
+	u64 nStartTicks = CTimer::GetClockTicks64 ();
+
+	while (pSound->IsActive ())
+	{
+		unsigned nMillis = (unsigned) (pSound->GetFramesWritten () * 1000 / Config.GetSampleRate ());
+		if (nMillis >= nStep * 500 + (bKeysDown ? 400 : 0))
+		{
+			for (unsigned nTG = 0; nTG < Config.GetToneGenerators (); nTG++)
+			{
+				for (unsigned i = 0; i < ChordCount; i++)
+				{
+					int nPitch = Chord[i] + (int) (nStep % 4) * 2;
+					if (!bKeysDown)
+					{
+						pMiniDexed->keydown (nPitch, 100, nTG);
+					}
+					else
+					{
+						pMiniDexed->keyup (nPitch, nTG);
+					}
+				}
+			}
+
+			if (bKeysDown)
+			{
+				nStep++;
+			}
+			bKeysDown = !bKeysDown;
+		}
+
+		pMiniDexed->Process (false);
+
+		if (pTraceFile)
+		{
+			CTrace::Drain (WriteTracePacket, pTraceFile);
+		}
+
+		CTimer::SimpleMsDelay (1);
+	}
+
+	double fElapsed = (double) (CTimer::GetClockTicks64 () - nStartTicks) / CLOCKHZ;
+
+	LOGNOTE ("%llu frames in %.2fs (%.1fx real time), %llu underruns",
+		 (unsigned long long) pSound->GetFramesWritten (), fElapsed,
+		 nSeconds / fElapsed, (unsigned long long) pSound->GetUnderruns ());
+
+	delete pMiniDexed;
+
+	if (pTraceFile)
+	{
+		CTrace::Drain (WriteTracePacket, pTraceFile);
+		fclose (pTraceFile);
+	}
+
+	return 0;
+}
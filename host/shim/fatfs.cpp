@@ -0,0 +1,337 @@
+//
+// fatfs.cpp
+//
+// Host (POSIX) shim of the FatFs API, the current working directory is the
+// root of the SD card. Also the path mapping for hostfs.h.
+//
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <hostfs.h>
+#include <fatfs/ff.h>
+#include <assert.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <string.h>
+#include <string>
+#include <map>
+#include <sys/stat.h>
+
+#undef DIR		// the POSIX one from here on
+#undef fopen
+#undef opendir
+#undef readdir
+
+static std::map<std::string, std::string> s_FileMap;	// see HostMapFile()
+
+static std::string HostPath (const char *pPath)
+{
+	assert (pPath);
+
+	if (strncmp (pPath, "SD:", 3) == 0)
+	{
+		pPath += 3;
+	}
+
+	while (*pPath == '/')
+	{
+		pPath++;
+	}
+
+	auto Mapped = s_FileMap.find (pPath);
+	if (Mapped != s_FileMap.end ())
+	{
+		return Mapped->second;
+	}
+
+	return *pPath ? pPath : ".";
+}
+
+static FRESULT ErrnoResult (void)
+{
+	switch (errno)
+	{
+	case ENOENT:	return FR_NO_FILE;
+	case ENOTDIR:	return FR_NO_PATH;
+	case EEXIST:	return FR_EXIST;
+	case EACCES:
+	case EPERM:
+	case ENOTEMPTY:	return FR_DENIED;
+	default:	return FR_DISK_ERR;
+	}
+}
+
+static void FillInfo (const std::string &rDirPath, const char *pName, FILINFO *fno)
+{
+	struct stat Stat;
+	std::string Path = rDirPath + "/" + pName;
+
+	strncpy (fno->fname, pName, FF_MAX_LFN);
+	fno->fname[FF_MAX_LFN] = '\0';
+	fno->fsize = 0;
+	fno->fattrib = pName[0] == '.' ? AM_HID : 0;
+
+	if (stat (Path.c_str (), &Stat) == 0)
+	{
+		fno->fsize = Stat.st_size;
+
+		if (S_ISDIR (Stat.st_mode))
+		{
+			fno->fattrib |= AM_DIR;
+		}
+	}
+}
+
+FILE *HostFOpen (const char *pPath, const char *pMode)
+{
+	return fopen (HostPath (pPath).c_str (), pMode);
+}
+
+DIR *HostOpenDir (const char *pPath)
+{
+	return opendir (HostPath (pPath).c_str ());
+}
+
+struct dirent *HostReadDir (DIR *pDir)
+{
+	struct dirent *pEntry;
+	while (   (pEntry = readdir (pDir)) != 0
+	       && (strcmp (pEntry->d_name, ".") == 0 || strcmp (pEntry->d_name, "..") == 0))
+	{
+		// skip
+	}
+
+	return pEntry;
+}
+
+void HostMapFile (const char *pPath, const char *pHostPath)
+{
+	assert (pPath && *pPath != '/');
+	assert (pHostPath);
+
+	s_FileMap[pPath] = pHostPath;
+}
+
+FRESULT f_mount (FATFS *fs, const char *path, BYTE opt)
+{
+	return FR_OK;
+}
+
+FRESULT f_open (FIL *fp, const char *path, BYTE mode)
+{
+	assert (fp);
+	std::string Path = HostPath (path);
+
+	const char *pMode = "rb";
+	if (mode & FA_WRITE)
+	{
+		if ((mode & FA_OPEN_APPEND) == FA_OPEN_APPEND)
+		{
+			pMode = "ab";
+		}
+		else if (mode & (FA_CREATE_ALWAYS | FA_CREATE_NEW))
+		{
+			struct stat Stat;
+			if ((mode & FA_CREATE_NEW) && stat (Path.c_str (), &Stat) == 0)
+			{
+				return FR_EXIST;
+			}
+
+			pMode = mode & FA_READ ? "w+b" : "wb";
+		}
+		else
+		{
+			pMode = "r+b";
+		}
+	}
+
+	fp->pFile = fopen (Path.c_str (), pMode);
+	if (!fp->pFile)
+	{
+		return ErrnoResult ();
+	}
+
+	return FR_OK;
+}
+
+FRESULT f_close (FIL *fp)
+{
+	assert (fp);
+	assert (fp->pFile);
+
+	int nResult = fclose (fp->pFile);
+	fp->pFile = 0;
+
+	return nResult == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_read (FIL *fp, void *buff, UINT btr, UINT *br)
+{
+	assert (fp);
+	assert (fp->pFile);
+
+	*br = fread (buff, 1, btr, fp->pFile);
+
+	return ferror (fp->pFile) ? FR_DISK_ERR : FR_OK;
+}
+
+FRESULT f_write (FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+	assert (fp);
+	assert (fp->pFile);
+
+	*bw = fwrite (buff, 1, btw, fp->pFile);
+
+	return ferror (fp->pFile) ? FR_DISK_ERR : FR_OK;
+}
+
+FRESULT f_unlink (const char *path)
+{
+	std::string Path = HostPath (path);
+
+	if (remove (Path.c_str ()) != 0)
+	{
+		return ErrnoResult ();
+	}
+
+	return FR_OK;
+}
+
+FRESULT f_mkdir (const char *path)
+{
+	std::string Path = HostPath (path);
+
+	if (mkdir (Path.c_str (), 0777) != 0)
+	{
+		return ErrnoResult ();
+	}
+
+	return FR_OK;
+}
+
+FRESULT f_stat (const char *path, FILINFO *fno)
+{
+	std::string Path = HostPath (path);
+
+	struct stat Stat;
+	if (stat (Path.c_str (), &Stat) != 0)
+	{
+		return ErrnoResult ();
+	}
+
+	if (fno)
+	{
+		size_t nSlash = Path.find_last_of ('/');
+		std::string Dir = nSlash == std::string::npos ? "." : Path.substr (0, nSlash);
+		std::string Name = nSlash == std::string::npos ? Path : Path.substr (nSlash + 1);
+
+		FillInfo (Dir, Name.c_str (), fno);
+	}
+
+	return FR_OK;
+}
+
+FRESULT f_opendir (FF_DIR *dp, const char *path)
+{
+	assert (dp);
+	std::string Path = HostPath (path);
+
+	dp->pDir = opendir (Path.c_str ());
+	if (!dp->pDir)
+	{
+		return errno == ENOENT ? FR_NO_PATH : ErrnoResult ();
+	}
+
+	strncpy (dp->Path, Path.c_str (), FF_MAX_LFN);
+	dp->Path[FF_MAX_LFN] = '\0';
+	strcpy (dp->Pattern, "*");
+
+	return FR_OK;
+}
+
+FRESULT f_closedir (FF_DIR *dp)
+{
+	assert (dp);
+
+	if (dp->pDir)
+	{
+		closedir (dp->pDir);
+		dp->pDir = 0;
+	}
+
+	return FR_OK;
+}
+
+// returns the next entry matching the pattern, fno->fname[0] == 0 at the end
+FRESULT f_readdir (FF_DIR *dp, FILINFO *fno)
+{
+	assert (dp);
+	assert (dp->pDir);
+	assert (fno);
+
+	struct dirent *pEntry;
+	while ((pEntry = readdir (dp->pDir)) != 0)
+	{
+		if (   strcmp (pEntry->d_name, ".") == 0
+		    || strcmp (pEntry->d_name, "..") == 0
+		    || fnmatch (dp->Pattern, pEntry->d_name, 0) != 0)
+		{
+			continue;
+		}
+
+		FillInfo (dp->Path, pEntry->d_name, fno);
+
+		return FR_OK;
+	}
+
+	fno->fname[0] = '\0';
+
+	return FR_OK;
+}
+
+FRESULT f_findfirst (FF_DIR *dp, FILINFO *fno, const char *path, const char *pattern)
+{
+	FRESULT Result = f_opendir (dp, path);
+	if (Result != FR_OK)
+	{
+		return Result;
+	}
+
+	strncpy (dp->Pattern, pattern, FF_MAX_LFN);
+	dp->Pattern[FF_MAX_LFN] = '\0';
+
+	return f_readdir (dp, fno);
+}
+
+FRESULT f_findnext (FF_DIR *dp, FILINFO *fno)
+{
+	return f_readdir (dp, fno);
+}
+
+FSIZE_t f_size (FIL *fp)
+{
+	assert (fp);
+	assert (fp->pFile);
+
+	struct stat Stat;
+	if (fstat (fileno (fp->pFile), &Stat) != 0)
+	{
+		return 0;
+	}
+
+	return Stat.st_size;
+}
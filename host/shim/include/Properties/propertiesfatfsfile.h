@@ -0,0 +1,54 @@
+//
+// propertiesfatfsfile.h
+//
+// Host (POSIX) shim of Circle's <Properties/propertiesfatfsfile.h>
+// Reads and writes "name=value" files, '#' starts a comment line.
+//
+#ifndef _Properties_propertiesfatfsfile_h
+#define _Properties_propertiesfatfsfile_h
+
+#include <fatfs/ff.h>
+#include <circle/types.h>
+#include <string>
+#include <vector>
+
+class CPropertiesFatFsFile
+{
+public:
+	CPropertiesFatFsFile (const char *pFileName, FATFS *pFileSystem);
+	~CPropertiesFatFsFile (void);
+
+	boolean Load (void);
+	boolean Save (void);
+
+	void RemoveAll (void);
+
+	boolean IsSet (const char *pPropertyName) const;
+
+	const char *GetString (const char *pPropertyName, const char *pDefault = 0) const;
+	unsigned GetNumber (const char *pPropertyName, unsigned nDefault = 0) const;
+	int GetSignedNumber (const char *pPropertyName, int nDefault = 0) const;
+	const u8 *GetIPAddress (const char *pPropertyName) const;	// 4 bytes or 0
+
+	void SetString (const char *pPropertyName, const char *pValue);
+	void SetNumber (const char *pPropertyName, unsigned nValue, unsigned nBase = 10);
+	void SetSignedNumber (const char *pPropertyName, int nValue);
+
+private:
+	struct TProperty
+	{
+		std::string Name;
+		std::string Value;
+	};
+
+	const TProperty *Find (const char *pPropertyName) const;
+
+private:
+	std::string m_FileName;
+
+	std::vector<TProperty> m_Properties;
+
+	mutable u8 m_IPAddress[4];
+};
+
+#endif
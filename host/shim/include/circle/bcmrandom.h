@@ -0,0 +1,18 @@
+//
+// bcmrandom.h
+//
+// Host (POSIX) shim of Circle's <circle/bcmrandom.h>
+//
+#ifndef _circle_bcmrandom_h
+#define _circle_bcmrandom_h
+
+#include <circle/types.h>
+#include <stdlib.h>
+
+class CBcmRandomNumberGenerator
+{
+public:
+	u32 GetNumber (void)	{ return (u32) random (); }
+};
+
+#endif
@@ -0,0 +1,15 @@
+//
+// chardevice.h
+//
+// Host (POSIX) shim of Circle's <circle/chardevice.h>
+//
+#ifndef _circle_chardevice_h
+#define _circle_chardevice_h
+
+#include <circle/device.h>
+
+class CCharDevice : public CDevice
+{
+};
+
+#endif
@@ -0,0 +1,20 @@
+//
+// device.h
+//
+// Host (POSIX) shim of Circle's <circle/device.h>
+//
+#ifndef _circle_device_h
+#define _circle_device_h
+
+#include <circle/types.h>
+
+class CDevice
+{
+public:
+	virtual ~CDevice (void) {}
+
+	virtual int Read (void *pBuffer, size_t nCount)		{ return 0; }
+	virtual int Write (const void *pBuffer, size_t nCount)	{ return (int) nCount; }
+};
+
+#endif
@@ -0,0 +1,26 @@
+//
+// devicenameservice.h
+//
+// Host (POSIX) shim of Circle's <circle/devicenameservice.h>
+// There are no USB devices on the host, so no device is ever found.
+//
+#ifndef _circle_devicenameservice_h
+#define _circle_devicenameservice_h
+
+#include <circle/device.h>
+
+class CDeviceNameService
+{
+public:
+	static CDeviceNameService *Get (void)
+	{
+		static CDeviceNameService s_DeviceNameService;
+
+		return &s_DeviceNameService;
+	}
+
+	CDevice *GetDevice (const char *pName, boolean bBlockDevice)			{ return nullptr; }
+	CDevice *GetDevice (const char *pPrefix, unsigned nIndex, boolean bBlockDevice)	{ return nullptr; }
+};
+
+#endif
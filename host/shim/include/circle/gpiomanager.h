@@ -0,0 +1,20 @@
+//
+// gpiomanager.h
+//
+// Host (POSIX) shim of Circle's <circle/gpiomanager.h>
+//
+#ifndef _circle_gpiomanager_h
+#define _circle_gpiomanager_h
+
+#include <circle/interrupt.h>
+#include <circle/types.h>
+
+class CGPIOManager
+{
+public:
+	CGPIOManager (CInterruptSystem *pInterrupt) {}
+
+	boolean Initialize (void)	{ return TRUE; }
+};
+
+#endif
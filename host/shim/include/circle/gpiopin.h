@@ -0,0 +1,68 @@
+//
+// gpiopin.h
+//
+// Host (POSIX) shim of Circle's <circle/gpiopin.h>
+// There is no GPIO on the host, inputs read as their idle (pulled) level.
+//
+#ifndef _circle_gpiopin_h
+#define _circle_gpiopin_h
+
+#include <circle/types.h>
+
+#define LOW		0
+#define HIGH		1
+
+enum TGPIOMode
+{
+	GPIOModeInput,
+	GPIOModeOutput,
+	GPIOModeInputPullUp,
+	GPIOModeInputPullDown,
+	GPIOModeAlternateFunction0,
+	GPIOModeUnknown
+};
+
+enum TGPIOInterrupt
+{
+	GPIOInterruptOnRisingEdge,
+	GPIOInterruptOnFallingEdge,
+	GPIOInterruptOnHighLevel,
+	GPIOInterruptOnLowLevel,
+	GPIOInterruptUnknown
+};
+
+typedef void TGPIOInterruptHandler (void *pParam);
+
+class CGPIOManager;
+
+class CGPIOPin
+{
+public:
+	CGPIOPin (void) : m_nValue (LOW) {}
+	CGPIOPin (unsigned nPin, TGPIOMode Mode, CGPIOManager *pManager = 0)
+	:	m_nValue (LOW)
+	{
+		SetMode (Mode);
+	}
+
+	void AssignPin (unsigned nPin) {}
+
+	void SetMode (TGPIOMode Mode, boolean bInitPin = TRUE)
+	{
+		m_nValue = Mode == GPIOModeInputPullUp ? HIGH : LOW;
+	}
+
+	unsigned Read (void) const		{ return m_nValue; }
+	void Write (unsigned nValue)		{ m_nValue = nValue; }
+	void Invert (void)			{ m_nValue ^= 1; }
+
+	void ConnectInterrupt (TGPIOInterruptHandler *pHandler, void *pParam, boolean bAutoAck = TRUE) {}
+	void DisconnectInterrupt (void) {}
+	void EnableInterrupt (TGPIOInterrupt Interrupt) {}
+	void DisableInterrupt (void) {}
+
+private:
+	unsigned m_nValue;
+};
+
+#endif
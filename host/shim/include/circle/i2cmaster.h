@@ -0,0 +1,19 @@
+//
+// i2cmaster.h
+//
+// Host (POSIX) shim of Circle's <circle/i2cmaster.h>
+//
+#ifndef _circle_i2cmaster_h
+#define _circle_i2cmaster_h
+
+#include <circle/types.h>
+
+class CI2CMaster
+{
+public:
+	CI2CMaster (unsigned nDevice, boolean bFastMode = FALSE, unsigned nConfig = 0) {}
+
+	boolean Initialize (void)	{ return TRUE; }
+};
+
+#endif
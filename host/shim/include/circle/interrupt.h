@@ -0,0 +1,13 @@
+//
+// interrupt.h
+//
+// Host (POSIX) shim of Circle's <circle/interrupt.h>
+//
+#ifndef _circle_interrupt_h
+#define _circle_interrupt_h
+
+class CInterruptSystem
+{
+};
+
+#endif
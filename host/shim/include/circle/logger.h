@@ -0,0 +1,51 @@
+//
+// logger.h
+//
+// Host (POSIX) shim of Circle's <circle/logger.h>, writes to stderr
+//
+#ifndef _circle_logger_h
+#define _circle_logger_h
+
+#include <circle/types.h>
+#include <mutex>
+
+enum TLogSeverity
+{
+	LogPanic,
+	LogError,
+	LogWarning,
+	LogNotice,
+	LogDebug
+};
+
+class CDevice;
+class CTimer;
+
+class CLogger
+{
+public:
+	CLogger (unsigned nLogLevel, CTimer *pTimer = 0, boolean bOverwriteOldest = TRUE);
+	~CLogger (void);
+
+	boolean Initialize (CDevice *pTarget);
+
+	void Write (const char *pSource, TLogSeverity Severity, const char *pMessage, ...);
+
+	static CLogger *Get (void);		// creates a default logger, if none exists
+
+private:
+	unsigned m_nLogLevel;
+
+	std::mutex m_Mutex;
+
+	static CLogger *s_pThis;
+};
+
+#define LOGMODULE(name)	static const char From[] = name
+#define LOGPANIC(...)	CLogger::Get ()->Write (From, LogPanic, __VA_ARGS__)
+#define LOGERR(...)	CLogger::Get ()->Write (From, LogError, __VA_ARGS__)
+#define LOGWARN(...)	CLogger::Get ()->Write (From, LogWarning, __VA_ARGS__)
+#define LOGNOTE(...)	CLogger::Get ()->Write (From, LogNotice, __VA_ARGS__)
+#define LOGDBG(...)	CLogger::Get ()->Write (From, LogDebug, __VA_ARGS__)
+
+#endif
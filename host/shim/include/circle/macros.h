@@ -0,0 +1,19 @@
+//
+// macros.h
+//
+// Host (POSIX) shim of Circle's <circle/macros.h>
+//
+#ifndef _circle_macros_h
+#define _circle_macros_h
+
+#define PACKED		__attribute__ ((packed))
+#define ALIGN(n)	__attribute__ ((aligned (n)))
+#define MAXALIGN	__attribute__ ((aligned))
+#define NORETURN	__attribute__ ((noreturn))
+#define NOOPT		__attribute__ ((optimize (0)))
+#define WEAK		__attribute__ ((weak))
+
+#define likely(exp)	__builtin_expect (!!(exp), 1)
+#define unlikely(exp)	__builtin_expect (!!(exp), 0)
+
+#endif
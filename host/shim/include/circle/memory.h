@@ -0,0 +1,20 @@
+//
+// memory.h
+//
+// Host (POSIX) shim of Circle's <circle/memory.h>
+//
+#ifndef _circle_memory_h
+#define _circle_memory_h
+
+class CMemorySystem
+{
+public:
+	static CMemorySystem *Get (void)
+	{
+		static CMemorySystem s_Memory;
+
+		return &s_Memory;
+	}
+};
+
+#endif
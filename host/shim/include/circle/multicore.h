@@ -0,0 +1,38 @@
+//
+// multicore.h
+//
+// Host (POSIX) shim of Circle's <circle/multicore.h>
+// The secondary cores are std::threads running Run(nCore). They cannot be
+// stopped from outside, Run() has to return on its own.
+//
+#ifndef _circle_multicore_h
+#define _circle_multicore_h
+
+#include <circle/sysconfig.h>
+#include <circle/memory.h>
+#include <circle/types.h>
+#include <thread>
+
+class CMultiCoreSupport
+{
+public:
+	CMultiCoreSupport (CMemorySystem *pMemorySystem);
+	virtual ~CMultiCoreSupport (void);
+
+	boolean Initialize (void);			// starts cores 1..CORES-1
+
+	virtual void Run (unsigned nCore) = 0;
+
+	virtual void IPIHandler (unsigned nCore, unsigned nIPI) {}
+
+	static unsigned ThisCore (void);
+
+	static void SendIPI (unsigned nCore, unsigned nIPI) {}
+
+	static void HaltAll (void);
+
+private:
+	std::thread m_Thread[CORES];
+};
+
+#endif
@@ -0,0 +1,14 @@
+//
+// in.h
+//
+// Host (POSIX) shim of Circle's <circle/net/in.h>
+//
+#ifndef _circle_net_in_h
+#define _circle_net_in_h
+
+#define IPPROTO_TCP	6
+#define IPPROTO_UDP	17
+
+#define MSG_DONTWAIT	0x40
+
+#endif
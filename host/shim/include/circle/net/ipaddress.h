@@ -0,0 +1,51 @@
+//
+// ipaddress.h
+//
+// Host (POSIX) shim of Circle's <circle/net/ipaddress.h>
+//
+#ifndef _circle_net_ipaddress_h
+#define _circle_net_ipaddress_h
+
+#include <circle/string.h>
+#include <circle/types.h>
+#include <string.h>
+
+#define IP_ADDRESS_SIZE	4
+
+class CIPAddress
+{
+public:
+	CIPAddress (void) : m_bValid (FALSE) {}
+	CIPAddress (u32 nAddress)		{ Set (nAddress); }
+	CIPAddress (const u8 *pAddress)		{ Set (pAddress); }
+
+	boolean operator== (const CIPAddress &rAddress2) const
+	{
+		return m_bValid == rAddress2.m_bValid && memcmp (m_Address, rAddress2.m_Address, IP_ADDRESS_SIZE) == 0;
+	}
+	boolean operator!= (const CIPAddress &rAddress2) const	{ return !operator== (rAddress2); }
+
+	void Set (u32 nAddress)			{ memcpy (m_Address, &nAddress, IP_ADDRESS_SIZE); m_bValid = TRUE; }
+	void Set (const u8 *pAddress)		{ memcpy (m_Address, pAddress, IP_ADDRESS_SIZE); m_bValid = TRUE; }
+	void Set (const CIPAddress &rAddress)	{ *this = rAddress; }
+	void SetBroadcast (void)		{ Set ((u32) 0xFFFFFFFF); }
+
+	operator u32 (void) const		{ u32 nAddress; memcpy (&nAddress, m_Address, IP_ADDRESS_SIZE); return nAddress; }
+	const u8 *Get (void) const		{ return m_Address; }
+	void CopyTo (u8 *pBuffer) const		{ memcpy (pBuffer, m_Address, IP_ADDRESS_SIZE); }
+
+	boolean IsSet (void) const		{ return m_bValid; }
+	boolean IsNull (void) const		{ return (u32) *this == 0; }
+	boolean IsBroadcast (void) const	{ return (u32) *this == 0xFFFFFFFF; }
+
+	void Format (CString *pString) const
+	{
+		pString->Format ("%u.%u.%u.%u", m_Address[0], m_Address[1], m_Address[2], m_Address[3]);
+	}
+
+private:
+	boolean m_bValid;
+	u8 m_Address[IP_ADDRESS_SIZE] = {0};
+};
+
+#endif
@@ -0,0 +1,56 @@
+//
+// netsubsystem.h
+//
+// Host (POSIX) shim of Circle's <circle/net/netsubsystem.h>
+// Initialize() always fails, so MiniDexed runs without network on the host.
+//
+#ifndef _circle_net_netsubsystem_h
+#define _circle_net_netsubsystem_h
+
+#include <circle/net/ipaddress.h>
+#include <circle/types.h>
+
+enum TNetDeviceType
+{
+	NetDeviceTypeEthernet,
+	NetDeviceTypeWLAN,
+	NetDeviceTypeAny,
+	NetDeviceTypeUnknown
+};
+
+class CNetDevice
+{
+public:
+	TNetDeviceType GetType (void)		{ return NetDeviceTypeUnknown; }
+	boolean IsLinkUp (void)			{ return FALSE; }
+
+	static CNetDevice *GetNetDevice (TNetDeviceType Type)	{ return nullptr; }
+};
+
+class CNetConfig
+{
+public:
+	const CIPAddress *GetIPAddress (void) const	{ return &m_IPAddress; }
+
+private:
+	CIPAddress m_IPAddress;
+};
+
+class CNetSubSystem
+{
+public:
+	CNetSubSystem (const u8 *pIPAddress = 0, const u8 *pNetMask = 0, const u8 *pDefaultGateway = 0,
+		       const u8 *pDNSServer = 0, const char *pHostname = "", TNetDeviceType DeviceType = NetDeviceTypeEthernet) {}
+
+	boolean Initialize (boolean bWaitForActivate = TRUE)	{ return FALSE; }
+	boolean IsRunning (void) const				{ return FALSE; }
+
+	CNetConfig *GetConfig (void)		{ return &m_Config; }
+
+	static CNetSubSystem *Get (void)	{ return nullptr; }
+
+private:
+	CNetConfig m_Config;
+};
+
+#endif
@@ -0,0 +1,39 @@
+//
+// socket.h
+//
+// Host (POSIX) shim of Circle's <circle/net/socket.h>
+// The network is never started on the host, so the sockets do nothing.
+//
+#ifndef _circle_net_socket_h
+#define _circle_net_socket_h
+
+#include <circle/net/ipaddress.h>
+#include <circle/net/in.h>
+#include <circle/types.h>
+
+#define FRAME_BUFFER_SIZE	1600
+
+class CNetSubSystem;
+
+class CSocket
+{
+public:
+	CSocket (CNetSubSystem *pNetSubSystem, int nProtocol) {}
+	virtual ~CSocket (void) {}
+
+	int Bind (u16 nOwnPort)							{ return -1; }
+	int Connect (const CIPAddress &rForeignIP, u16 nForeignPort)		{ return -1; }
+	int Listen (unsigned nBackLog = 4)					{ return -1; }
+	CSocket *Accept (CIPAddress *pForeignIP, u16 *pForeignPort)		{ return nullptr; }
+	int Send (const void *pBuffer, unsigned nLength, int nFlags)		{ return -1; }
+	int Receive (void *pBuffer, unsigned nLength, int nFlags)		{ return -1; }
+	int SendTo (const void *pBuffer, unsigned nLength, int nFlags,
+		    const CIPAddress &rForeignIP, u16 nForeignPort)		{ return -1; }
+	int ReceiveFrom (void *pBuffer, unsigned nLength, int nFlags,
+			 CIPAddress *pForeignIP, u16 *pForeignPort)		{ return -1; }
+	int SetOptionBroadcast (boolean bAllowed)				{ return -1; }
+	int SetOptionAddMembership (const CIPAddress &rGroupAddress)		{ return -1; }
+	const u8 *GetForeignIP (void) const					{ return nullptr; }
+};
+
+#endif
@@ -0,0 +1,19 @@
+//
+// syslogdaemon.h
+//
+// Host (POSIX) shim of Circle's <circle/net/syslogdaemon.h>
+//
+#ifndef _circle_net_syslogdaemon_h
+#define _circle_net_syslogdaemon_h
+
+#include <circle/net/netsubsystem.h>
+#include <circle/net/ipaddress.h>
+#include <circle/types.h>
+
+class CSysLogDaemon
+{
+public:
+	CSysLogDaemon (CNetSubSystem *pNetSubSystem, const CIPAddress &rServerIP, u16 usServerPort = 514) {}
+};
+
+#endif
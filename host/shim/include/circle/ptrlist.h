@@ -0,0 +1,47 @@
+//
+// ptrlist.h
+//
+// Host (POSIX) shim of Circle's <circle/ptrlist.h>
+//
+#ifndef _circle_ptrlist_h
+#define _circle_ptrlist_h
+
+#include <list>
+
+typedef void TPtrListElement;
+
+class CPtrList
+{
+public:
+	TPtrListElement *GetFirst (void)
+	{
+		return m_List.empty () ? nullptr : (TPtrListElement *) &*m_List.begin ();
+	}
+
+	TPtrListElement *GetNext (TPtrListElement *pElement)
+	{
+		for (auto it = m_List.begin (); it != m_List.end (); ++it)
+		{
+			if ((TPtrListElement *) &*it == pElement)
+			{
+				return ++it == m_List.end () ? nullptr : (TPtrListElement *) &*it;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void *GetPtr (TPtrListElement *pElement)	{ return *(void **) pElement; }
+
+	void AddElement (void *pPtr)			{ m_List.push_back (pPtr); }
+
+	void Remove (TPtrListElement *pElement)
+	{
+		m_List.remove_if ([pElement] (void *&rPtr) { return &rPtr == pElement; });
+	}
+
+private:
+	std::list<void *> m_List;
+};
+
+#endif
@@ -0,0 +1,21 @@
+//
+// mutex.h
+//
+// Host (POSIX) shim of Circle's <circle/sched/mutex.h>
+//
+#ifndef _circle_sched_mutex_h
+#define _circle_sched_mutex_h
+
+#include <mutex>
+
+class CMutex
+{
+public:
+	void Acquire (void)	{ m_Mutex.lock (); }
+	void Release (void)	{ m_Mutex.unlock (); }
+
+private:
+	std::mutex m_Mutex;
+};
+
+#endif
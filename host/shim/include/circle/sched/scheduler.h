@@ -0,0 +1,34 @@
+//
+// scheduler.h
+//
+// Host (POSIX) shim of Circle's <circle/sched/scheduler.h>
+// There is only the main task. Yield() polls the kernel timers.
+//
+#ifndef _circle_sched_scheduler_h
+#define _circle_sched_scheduler_h
+
+#include <circle/sched/task.h>
+#include <circle/logger.h>
+#include <circle/timer.h>
+#include <circle/types.h>
+
+class CScheduler
+{
+public:
+	void Yield (void)			{ CTimer::Get ()->PollKernelTimers (); }
+
+	void Sleep (unsigned nSeconds)		{ CTimer::SimpleMsDelay (nSeconds * 1000); }
+	void MsSleep (unsigned nMilliSeconds)	{ CTimer::SimpleMsDelay (nMilliSeconds); }
+	void usSleep (unsigned nMicroSeconds)	{ CTimer::SimpleusDelay (nMicroSeconds); }
+
+	CTask *GetCurrentTask (void)		{ return nullptr; }
+
+	static CScheduler *Get (void)
+	{
+		static CScheduler s_Scheduler;
+
+		return &s_Scheduler;
+	}
+};
+
+#endif
@@ -0,0 +1,26 @@
+//
+// synchronizationevent.h
+//
+// Host (POSIX) shim of Circle's <circle/sched/synchronizationevent.h>
+//
+#ifndef _circle_sched_synchronizationevent_h
+#define _circle_sched_synchronizationevent_h
+
+#include <circle/types.h>
+
+class CSynchronizationEvent
+{
+public:
+	CSynchronizationEvent (boolean bState = FALSE) : m_bState (bState) {}
+
+	boolean GetState (void)		{ return m_bState; }
+	void Clear (void)		{ m_bState = FALSE; }
+	void Set (void)			{ m_bState = TRUE; }
+	void Wait (void) {}
+	boolean WaitWithTimeout (unsigned nMicroSeconds)	{ return !m_bState; }
+
+private:
+	boolean m_bState;
+};
+
+#endif
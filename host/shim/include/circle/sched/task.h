@@ -0,0 +1,32 @@
+//
+// task.h
+//
+// Host (POSIX) shim of Circle's <circle/sched/task.h>
+// Tasks are never started on the host.
+//
+#ifndef _circle_sched_task_h
+#define _circle_sched_task_h
+
+#include <circle/string.h>
+#include <circle/types.h>
+
+class CTask
+{
+public:
+	CTask (unsigned nStackSize = 0x8000, boolean bCreateSuspended = FALSE) {}
+	virtual ~CTask (void) {}
+
+	virtual void Run (void) = 0;
+
+	void Start (void) {}
+	void Terminate (void) {}
+	boolean IsSuspended (void) const	{ return TRUE; }
+
+	void SetName (const char *pName)	{ m_Name = pName; }
+	const char *GetName (void) const	{ return m_Name; }
+
+private:
+	CString m_Name;
+};
+
+#endif
@@ -0,0 +1,68 @@
+//
+// serial.h
+//
+// Host (POSIX) shim of Circle's <circle/serial.h>
+// The serial port is not connected. Read() returns the data, which has been
+// given to HostInput() by the host program (e.g. MIDI messages from a file).
+//
+#ifndef _circle_serial_h
+#define _circle_serial_h
+
+#include <circle/device.h>
+#include <circle/interrupt.h>
+#include <circle/types.h>
+#include <deque>
+#include <mutex>
+
+#define SERIAL_OPTION_ONLCR	(1 << 0)
+
+class CSerialDevice : public CDevice
+{
+public:
+	CSerialDevice (CInterruptSystem *pInterruptSystem = 0, boolean bUseFIQ = FALSE, unsigned nDevice = 0) {}
+
+	boolean Initialize (unsigned nBaudrate = 115200, unsigned nDataBits = 8,
+			    unsigned nStopBits = 1, int Parity = 0)	{ return TRUE; }
+
+	int Read (void *pBuffer, size_t nCount) override
+	{
+		std::lock_guard<std::mutex> Lock (s_InputMutex);
+
+		u8 *pData = (u8 *) pBuffer;
+		size_t nResult = 0;
+		for (; nResult < nCount && !s_Input.empty (); nResult++)
+		{
+			pData[nResult] = s_Input.front ();
+			s_Input.pop_front ();
+		}
+
+		return (int) nResult;
+	}
+
+	int Write (const void *pBuffer, size_t nCount) override		{ return (int) nCount; }
+
+	unsigned GetOptions (void) const		{ return 0; }
+	void SetOptions (unsigned nOptions) {}
+
+	// host only
+	static void HostInput (const void *pBuffer, size_t nCount)
+	{
+		std::lock_guard<std::mutex> Lock (s_InputMutex);
+
+		const u8 *pData = (const u8 *) pBuffer;
+		s_Input.insert (s_Input.end (), pData, pData + nCount);
+	}
+
+	static size_t GetHostInputPending (void)	// bytes not read yet
+	{
+		std::lock_guard<std::mutex> Lock (s_InputMutex);
+
+		return s_Input.size ();
+	}
+
+private:
+	static inline std::deque<u8> s_Input;
+	static inline std::mutex s_InputMutex;
+};
+
+#endif
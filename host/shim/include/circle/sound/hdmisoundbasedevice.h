@@ -0,0 +1,22 @@
+//
+// hdmisoundbasedevice.h
+//
+// Host (POSIX) shim of Circle's <circle/sound/hdmisoundbasedevice.h>
+//
+#ifndef _circle_sound_hdmisoundbasedevice_h
+#define _circle_sound_hdmisoundbasedevice_h
+
+#include <circle/sound/soundbasedevice.h>
+#include <circle/interrupt.h>
+
+class CHDMISoundBaseDevice : public CSoundBaseDevice
+{
+public:
+	CHDMISoundBaseDevice (CInterruptSystem *pInterrupt, unsigned nSampleRate = 48000,
+			       unsigned nChunkSize = 384)
+	:	CSoundBaseDevice (nSampleRate, nChunkSize)
+	{
+	}
+};
+
+#endif
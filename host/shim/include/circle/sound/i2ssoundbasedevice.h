@@ -0,0 +1,35 @@
+//
+// i2ssoundbasedevice.h
+//
+// Host (POSIX) shim of Circle's <circle/sound/i2ssoundbasedevice.h>
+//
+#ifndef _circle_sound_i2ssoundbasedevice_h
+#define _circle_sound_i2ssoundbasedevice_h
+
+#include <circle/sound/soundbasedevice.h>
+#include <circle/interrupt.h>
+#include <circle/i2cmaster.h>
+
+class CI2SSoundBaseDevice : public CSoundBaseDevice
+{
+public:
+	enum TDeviceMode
+	{
+		DeviceModeTXOnly,
+		DeviceModeRXOnly,
+		DeviceModeTXRX,
+		DeviceModeUnknown
+	};
+
+public:
+	CI2SSoundBaseDevice (CInterruptSystem *pInterrupt, unsigned nSampleRate = 192000,
+			     unsigned nChunkSize = 8192, bool bSlave = FALSE,
+			     CI2CMaster *pI2CMaster = 0, u8 ucI2CAddress = 0,
+			     TDeviceMode DeviceMode = DeviceModeTXOnly,
+			     unsigned nHWChannels = 2)
+	:	CSoundBaseDevice (nSampleRate, nChunkSize)
+	{
+	}
+};
+
+#endif
@@ -0,0 +1,22 @@
+//
+// pwmsoundbasedevice.h
+//
+// Host (POSIX) shim of Circle's <circle/sound/pwmsoundbasedevice.h>
+//
+#ifndef _circle_sound_pwmsoundbasedevice_h
+#define _circle_sound_pwmsoundbasedevice_h
+
+#include <circle/sound/soundbasedevice.h>
+#include <circle/interrupt.h>
+
+class CPWMSoundBaseDevice : public CSoundBaseDevice
+{
+public:
+	CPWMSoundBaseDevice (CInterruptSystem *pInterrupt, unsigned nSampleRate = 48000,
+			      unsigned nChunkSize = 384)
+	:	CSoundBaseDevice (nSampleRate, nChunkSize)
+	{
+	}
+};
+
+#endif
@@ -0,0 +1,110 @@
+//
+// soundbasedevice.h
+//
+// Host (POSIX) shim of Circle's <circle/sound/soundbasedevice.h>
+//
+// The written samples go to a null sink or to a WAV file. The queue is
+// drained either in real time (the writer is paced like by a DAC),
+// instantly (the writer renders as fast as it can) or under control of the
+// host program, which releases the frames to be written one by one chunk
+// (for deterministic offline rendering). The sink is selected with
+// SetOutput() before the device is created; output stops after the given
+// number of frames has been written.
+//
+#ifndef _circle_sound_soundbasedevice_h
+#define _circle_sound_soundbasedevice_h
+
+#include <circle/device.h>
+#include <circle/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include <stdio.h>
+
+enum TSoundFormat
+{
+	SoundFormatUnsigned8,
+	SoundFormatSigned16,
+	SoundFormatSigned24,
+	SoundFormatSigned24_32,
+	SoundFormatUnsigned32,
+	SoundFormatUnknown
+};
+
+enum TSoundPacing		// host only
+{
+	SoundPacingRealTime,
+	SoundPacingFreeRunning,
+	SoundPacingExternal		// see ReleaseFrames()
+};
+
+class CSoundBaseDevice : public CDevice
+{
+public:
+	CSoundBaseDevice (unsigned nSampleRate, unsigned nChunkSize);
+	virtual ~CSoundBaseDevice (void);
+
+	boolean AllocateQueueFrames (unsigned nSizeFrames);
+	void SetWriteFormat (TSoundFormat Format, unsigned nChannels = 2);
+
+	unsigned GetQueueSizeFrames (void);
+	unsigned GetQueueFramesAvail (void);		// frames still queued
+
+	int Write (const void *pBuffer, size_t nCount) override;
+
+	boolean Start (void);
+	void Cancel (void);
+	boolean IsActive (void) const;
+
+	// host only
+	static void SetOutput (const char *pWAVFileName,	// 0 for the null sink
+			       TSoundPacing Pacing,
+			       u64 nMaxFrames = 0,		// 0 for unlimited
+			       unsigned nWAVBits = 32);		// 24 or 32 for 24-bit formats
+
+	static CSoundBaseDevice *Get (void);		// the device created last
+
+	u64 GetFramesWritten (void) const;
+	u64 GetUnderruns (void) const;			// real-time mode only
+
+	// external pacing: the queue is reported full, until nFrames more have been
+	// released, so that the writer renders exactly these frames (in chunks of
+	// the half queue size)
+	void ReleaseFrames (unsigned nFrames);
+	// returns when nFrames have been written in total or the output has stopped
+	void WaitFramesWritten (u64 nFrames);
+
+private:
+	void WriteWAVHeader (void);
+
+private:
+	unsigned m_nSampleRate;
+	unsigned m_nChunkSize;
+	unsigned m_nQueueSizeFrames;
+	unsigned m_nChannels;
+	unsigned m_nBytesPerSample;
+	unsigned m_nWAVBytesPerSample;
+
+	std::atomic<bool> m_bActive;
+	std::atomic<u64> m_nFramesWritten;
+	u64 m_nFramesPlayed;				// real-time mode only
+	u64 m_nStartTicks;
+	u64 m_nUnderruns;
+
+	std::atomic<u64> m_nFramesReleased;		// external pacing only
+	std::mutex m_WrittenMutex;
+	std::condition_variable m_WrittenCondition;
+
+	FILE *m_pFile;
+	std::vector<u8> m_WAVBuffer;
+
+	static const char *s_pWAVFileName;
+	static TSoundPacing s_Pacing;
+	static u64 s_nMaxFrames;
+	static unsigned s_nWAVBits;
+
+	static CSoundBaseDevice *s_pThis;
+};
+
+#endif
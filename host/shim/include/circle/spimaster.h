@@ -0,0 +1,19 @@
+//
+// spimaster.h
+//
+// Host (POSIX) shim of Circle's <circle/spimaster.h>
+//
+#ifndef _circle_spimaster_h
+#define _circle_spimaster_h
+
+#include <circle/types.h>
+
+class CSPIMaster
+{
+public:
+	CSPIMaster (unsigned nClockSpeed = 500000, unsigned CPOL = 0, unsigned CPHA = 0, unsigned nDevice = 0) {}
+
+	boolean Initialize (void)	{ return FALSE; }
+};
+
+#endif
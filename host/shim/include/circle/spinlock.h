@@ -0,0 +1,31 @@
+//
+// spinlock.h
+//
+// Host (POSIX) shim of Circle's <circle/spinlock.h>, based on std::mutex
+//
+#ifndef _circle_spinlock_h
+#define _circle_spinlock_h
+
+#include <circle/types.h>
+#include <mutex>
+
+#define TASK_LEVEL	0
+#define IRQ_LEVEL	1
+#define FIQ_LEVEL	2
+
+class CSpinLock
+{
+public:
+	CSpinLock (unsigned nTargetLevel = IRQ_LEVEL) {}
+
+	CSpinLock (const CSpinLock &) = delete;
+	CSpinLock &operator= (const CSpinLock &) = delete;
+
+	void Acquire (void)	{ m_Mutex.lock (); }
+	void Release (void)	{ m_Mutex.unlock (); }
+
+private:
+	std::mutex m_Mutex;
+};
+
+#endif
@@ -0,0 +1,16 @@
+//
+// startup.h
+//
+// Host (POSIX) shim of Circle's <circle/startup.h>
+//
+#ifndef _circle_startup_h
+#define _circle_startup_h
+
+#include <stdlib.h>
+
+#define EXIT_HALT	0
+#define EXIT_REBOOT	1
+
+static inline void reboot (void)	{ exit (EXIT_REBOOT); }
+
+#endif
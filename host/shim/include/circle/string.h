@@ -0,0 +1,52 @@
+//
+// string.h
+//
+// Host (POSIX) shim of Circle's <circle/string.h>
+//
+#ifndef _circle_string_h
+#define _circle_string_h
+
+#include <circle/types.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string>
+
+class CString
+{
+public:
+	CString (void) {}
+	CString (const char *pString) : m_String (pString) {}
+
+	operator const char *(void) const	{ return m_String.c_str (); }
+
+	const char *operator = (const char *pString)
+	{
+		m_String = pString;
+		return m_String.c_str ();
+	}
+
+	size_t GetLength (void) const		{ return m_String.length (); }
+
+	void Append (const char *pString)	{ m_String += pString; }
+	int Compare (const char *pString) const	{ return m_String.compare (pString); }
+
+	void Format (const char *pFormat, ...)
+	{
+		va_list var;
+		va_start (var, pFormat);
+		FormatV (pFormat, var);
+		va_end (var);
+	}
+
+	void FormatV (const char *pFormat, va_list Args)
+	{
+		char Buffer[1000];
+		vsnprintf (Buffer, sizeof Buffer, pFormat, Args);
+		m_String = Buffer;
+	}
+
+private:
+	std::string m_String;
+};
+
+#endif
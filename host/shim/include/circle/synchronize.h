@@ -0,0 +1,14 @@
+//
+// synchronize.h
+//
+// Host (POSIX) shim of Circle's <circle/synchronize.h>
+//
+#ifndef _circle_synchronize_h
+#define _circle_synchronize_h
+
+#include <atomic>
+
+#define DataMemBarrier()	std::atomic_thread_fence (std::memory_order_seq_cst)
+#define DataSyncBarrier()	std::atomic_thread_fence (std::memory_order_seq_cst)
+
+#endif
@@ -0,0 +1,16 @@
+//
+// sysconfig.h
+//
+// Host (POSIX) shim of Circle's <circle/sysconfig.h>
+//
+#ifndef _circle_sysconfig_h
+#define _circle_sysconfig_h
+
+#ifndef CORES
+#define CORES		4		// one std::thread per core
+#endif
+
+#define HZ		100		// kernel timer ticks per second
+#define MSEC2HZ(msec)	((msec) * HZ / 1000)
+
+#endif
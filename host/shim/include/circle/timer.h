@@ -0,0 +1,70 @@
+//
+// timer.h
+//
+// Host (POSIX) shim of Circle's <circle/timer.h>
+// The clock is std::chrono::steady_clock, or a virtual clock, which is set
+// explicitly by the host program (for offline rendering, see midi2wav.cpp).
+// Kernel timers do not fire asynchronously, they are polled from
+// CScheduler::Yield() on core 0.
+//
+#ifndef _circle_timer_h
+#define _circle_timer_h
+
+#include <circle/types.h>
+#include <circle/sysconfig.h>
+#include <circle/spinlock.h>
+
+#define CLOCKHZ		1000000
+
+typedef uintptr TKernelTimerHandle;
+
+typedef void TKernelTimerHandler (TKernelTimerHandle hTimer, void *pParam, void *pContext);
+
+class CInterruptSystem;
+
+class CTimer
+{
+public:
+	CTimer (CInterruptSystem *pInterruptSystem = 0);
+	~CTimer (void);
+
+	unsigned GetTicks (void) const;			// 1/HZ seconds since start
+	unsigned GetUptime (void) const;		// seconds since start
+
+	TKernelTimerHandle StartKernelTimer (unsigned nDelay,	// in HZ units
+					     TKernelTimerHandler *pHandler,
+					     void *pParam = 0, void *pContext = 0);
+	void CancelKernelTimer (TKernelTimerHandle hTimer);
+
+	void PollKernelTimers (void);			// calls the handlers of expired timers
+
+	void MsDelay (unsigned nMilliSeconds)		{ SimpleMsDelay (nMilliSeconds); }
+	void usDelay (unsigned nMicroSeconds)		{ SimpleusDelay (nMicroSeconds); }
+
+	static CTimer *Get (void);
+
+	static unsigned GetClockTicks (void);		// microseconds, wraps around
+	static u64 GetClockTicks64 (void);
+
+	static void SimpleMsDelay (unsigned nMilliSeconds);	// always in real time
+	static void SimpleusDelay (unsigned nMicroSeconds);
+
+	// host only: the clock stands still at nTicks from now on, until it is set again
+	static void SetVirtualClock (u64 nTicks);
+
+private:
+	static const unsigned MaxKernelTimers = 32;
+
+	struct TKernelTimer
+	{
+		TKernelTimerHandler *pHandler;		// 0 if unused
+		u64 nElapsesAt;				// in clock ticks
+		void *pParam;
+		void *pContext;
+	};
+
+	TKernelTimer m_KernelTimer[MaxKernelTimers];
+	CSpinLock m_TimerSpinLock;
+};
+
+#endif
@@ -0,0 +1,30 @@
+//
+// types.h
+//
+// Host (POSIX) shim of Circle's <circle/types.h>
+//
+#ifndef _circle_types_h
+#define _circle_types_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef uint8_t		u8;
+typedef uint16_t	u16;
+typedef uint32_t	u32;
+typedef uint64_t	u64;
+
+typedef int8_t		s8;
+typedef int16_t		s16;
+typedef int32_t		s32;
+typedef int64_t		s64;
+
+typedef uintptr_t	uintptr;
+typedef intptr_t	intptr;
+
+typedef bool		boolean;
+#define FALSE		false
+#define TRUE		true
+
+#endif
@@ -0,0 +1,23 @@
+//
+// usbkeyboard.h
+//
+// Host (POSIX) shim of Circle's <circle/usb/usbkeyboard.h>
+//
+#ifndef _circle_usb_usbkeyboard_h
+#define _circle_usb_usbkeyboard_h
+
+#include <circle/usb/usbmidi.h>
+#include <circle/device.h>
+#include <circle/types.h>
+
+typedef void TKeyStatusHandlerRaw (unsigned char ucModifiers, const unsigned char RawKeys[6]);
+
+class CUSBKeyboardDevice : public CDevice
+{
+public:
+	void RegisterKeyStatusHandlerRaw (TKeyStatusHandlerRaw *pKeyStatusHandlerRaw, boolean bMixedMode = FALSE) {}
+
+	void RegisterRemovedHandler (TDeviceRemovedHandler *pHandler, void *pContext = 0) {}
+};
+
+#endif
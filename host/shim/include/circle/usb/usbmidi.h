@@ -0,0 +1,28 @@
+//
+// usbmidi.h
+//
+// Host (POSIX) shim of Circle's <circle/usb/usbmidi.h>
+//
+#ifndef _circle_usb_usbmidi_h
+#define _circle_usb_usbmidi_h
+
+#include <circle/device.h>
+#include <circle/types.h>
+
+typedef void TMIDIPacketHandlerEx (unsigned nCable, u8 *pPacket, unsigned nLength,
+				   unsigned nDevice, void *pParam);
+
+typedef void TDeviceRemovedHandler (CDevice *pDevice, void *pContext);
+
+class CUSBMIDIDevice : public CDevice
+{
+public:
+	void RegisterPacketHandler (TMIDIPacketHandlerEx *pPacketHandler, void *pParam = 0) {}
+
+	boolean SendEventPackets (const u8 *pData, unsigned nLength)			{ return TRUE; }
+	boolean SendPlainMIDI (unsigned nCable, const u8 *pData, unsigned nLength)	{ return TRUE; }
+
+	void RegisterRemovedHandler (TDeviceRemovedHandler *pHandler, void *pContext = 0) {}
+};
+
+#endif
@@ -0,0 +1,12 @@
+//
+// util.h
+//
+// Host (POSIX) shim of Circle's <circle/util.h>
+//
+#ifndef _circle_util_h
+#define _circle_util_h
+
+#include <string.h>
+#include <stdlib.h>
+
+#endif
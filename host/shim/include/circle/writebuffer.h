@@ -0,0 +1,29 @@
+//
+// writebuffer.h
+//
+// Host (POSIX) shim of Circle's <circle/writebuffer.h>
+//
+#ifndef _circle_writebuffer_h
+#define _circle_writebuffer_h
+
+#include <circle/device.h>
+#include <assert.h>
+
+class CWriteBufferDevice : public CDevice
+{
+public:
+	CWriteBufferDevice (CDevice *pDevice) : m_pDevice (pDevice) {}
+
+	int Write (const void *pBuffer, size_t nCount) override
+	{
+		assert (m_pDevice);
+		return m_pDevice->Write (pBuffer, nCount);
+	}
+
+	void Update (unsigned nMaxDelayMicros = 0) {}
+
+private:
+	CDevice *m_pDevice;
+};
+
+#endif
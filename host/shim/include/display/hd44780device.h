@@ -0,0 +1,31 @@
+//
+// hd44780device.h
+//
+// Host (POSIX) shim of Circle's <display/hd44780device.h>
+// The display output is discarded.
+//
+#ifndef _display_hd44780device_h
+#define _display_hd44780device_h
+
+#include <circle/chardevice.h>
+#include <circle/i2cmaster.h>
+#include <circle/types.h>
+
+class CHD44780Device : public CCharDevice
+{
+public:
+	CHD44780Device (unsigned nColumns, unsigned nRows,
+			unsigned nD4Pin, unsigned nD5Pin, unsigned nD6Pin, unsigned nD7Pin,
+			unsigned nENPin, unsigned nRSPin, unsigned nRWPin = 0,
+			boolean bBlockCursor = FALSE) {}
+
+	CHD44780Device (CI2CMaster *pI2CMaster, u8 nAddress,
+			unsigned nColumns, unsigned nRows,
+			boolean bBlockCursor = FALSE) {}
+
+	boolean Initialize (void)	{ return TRUE; }
+
+	void DefineCharFont (char chChar, const u8 FontData[8]) {}
+};
+
+#endif
@@ -0,0 +1,50 @@
+//
+// st7789device.h
+//
+// Host (POSIX) shim of Circle's <display/st7789device.h>
+// The display output is discarded.
+//
+#ifndef _display_st7789device_h
+#define _display_st7789device_h
+
+#include <circle/chardevice.h>
+#include <circle/spimaster.h>
+#include <circle/types.h>
+
+struct TFont
+{
+	unsigned width;
+	unsigned height;
+};
+
+static const TFont Font8x16 = {8, 16};
+
+class CST7789Display
+{
+public:
+	CST7789Display (CSPIMaster *pSPIMaster,
+			unsigned nDCPin, unsigned nResetPin = 0, unsigned nBackLightPin = 0,
+			unsigned nWidth = 240, unsigned nHeight = 240,
+			unsigned CPOL = 0, unsigned CPHA = 0, unsigned nClockSpeed = 15000000,
+			unsigned nChipSelect = 0, boolean bSwapColorBytes = TRUE) {}
+
+	boolean Initialize (void)		{ return TRUE; }
+
+	void SetRotation (unsigned nRot) {}
+	void On (void) {}
+	void Off (void) {}
+	void Clear (void) {}
+};
+
+class CST7789Device : public CCharDevice
+{
+public:
+	CST7789Device (CSPIMaster *pSPIMaster, CST7789Display *pST7789Display,
+		       unsigned nColumns, unsigned nRows, const TFont &rFont = Font8x16,
+		       boolean bDoubleWidth = TRUE, boolean bDoubleHeight = TRUE,
+		       boolean bBlockCursor = FALSE) {}
+
+	boolean Initialize (void)	{ return TRUE; }
+};
+
+#endif
@@ -0,0 +1,97 @@
+//
+// ff.h
+//
+// Host (POSIX) shim of the FatFs API used by MiniDexed. The current working
+// directory takes the place of the SD card, a leading "SD:" is ignored.
+//
+#ifndef _fatfs_ff_h
+#define _fatfs_ff_h
+
+#include <stdio.h>
+#include <dirent.h>
+
+#define FF_MAX_LFN	255
+
+typedef unsigned int	UINT;
+typedef unsigned char	BYTE;
+typedef unsigned long	FSIZE_t;
+
+typedef struct
+{
+	int nDummy;
+} FATFS;
+
+typedef struct
+{
+	FILE *pFile;
+} FIL;
+
+typedef struct
+{
+	DIR *pDir;
+	char Path[FF_MAX_LFN + 1];
+	char Pattern[FF_MAX_LFN + 1];
+} FF_DIR;
+
+typedef struct
+{
+	FSIZE_t	fsize;
+	BYTE	fattrib;
+	char	fname[FF_MAX_LFN + 1];
+} FILINFO;
+
+typedef enum
+{
+	FR_OK = 0,
+	FR_DISK_ERR,
+	FR_INT_ERR,
+	FR_NOT_READY,
+	FR_NO_FILE,
+	FR_NO_PATH,
+	FR_INVALID_NAME,
+	FR_DENIED,
+	FR_EXIST,
+	FR_INVALID_OBJECT
+} FRESULT;
+
+#define FA_READ			0x01
+#define FA_WRITE		0x02
+#define FA_OPEN_EXISTING	0x00
+#define FA_CREATE_NEW		0x04
+#define FA_CREATE_ALWAYS	0x08
+#define FA_OPEN_ALWAYS		0x10
+#define FA_OPEN_APPEND		0x30
+
+#define AM_RDO			0x01
+#define AM_HID			0x02
+#define AM_SYS			0x04
+#define AM_DIR			0x10
+#define AM_ARC			0x20
+
+// FatFs calls its directory object DIR, which collides with <dirent.h>
+#define DIR	FF_DIR
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+FRESULT f_mount (FATFS *fs, const char *path, BYTE opt);
+FRESULT f_open (FIL *fp, const char *path, BYTE mode);
+FRESULT f_close (FIL *fp);
+FRESULT f_read (FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write (FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_unlink (const char *path);
+FRESULT f_mkdir (const char *path);
+FRESULT f_stat (const char *path, FILINFO *fno);
+FRESULT f_opendir (DIR *dp, const char *path);
+FRESULT f_closedir (DIR *dp);
+FRESULT f_readdir (DIR *dp, FILINFO *fno);
+FRESULT f_findfirst (DIR *dp, FILINFO *fno, const char *path, const char *pattern);
+FRESULT f_findnext (DIR *dp, FILINFO *fno);
+FSIZE_t f_size (FIL *fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
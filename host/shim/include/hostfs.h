@@ -0,0 +1,36 @@
+//
+// hostfs.h
+//
+// Force-included into the MiniDexed sources of the host build. Maps the
+// absolute paths, which the sources use with the POSIX file functions for
+// the SD card (e.g. "/sysex/voice"), to the current working directory, like
+// the FatFs shim does for "SD:/". Like FatFs, readdir() does not return
+// the "." and ".." entries. Single files can be mapped elsewhere with
+// HostMapFile() (e.g. another performance.ini).
+//
+#ifndef _hostfs_h
+#define _hostfs_h
+
+#include <stdio.h>
+#include <dirent.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+FILE *HostFOpen (const char *pPath, const char *pMode);
+DIR *HostOpenDir (const char *pPath);
+struct dirent *HostReadDir (DIR *pDir);
+
+// pPath is relative to the SD card root (e.g. "performance.ini")
+void HostMapFile (const char *pPath, const char *pHostPath);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define fopen(path, mode)	HostFOpen (path, mode)
+#define opendir(path)		HostOpenDir (path)
+#define readdir(dir)		HostReadDir (dir)
+
+#endif
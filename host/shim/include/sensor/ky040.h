@@ -0,0 +1,42 @@
+//
+// ky040.h
+//
+// Host (POSIX) shim of Circle's <sensor/ky040.h>
+// The rotary encoder never generates events on the host.
+//
+#ifndef _sensor_ky040_h
+#define _sensor_ky040_h
+
+#include <circle/gpiomanager.h>
+#include <circle/types.h>
+
+class CKY040
+{
+public:
+	enum TEvent
+	{
+		EventClockwise,
+		EventCounterclockwise,
+		EventSwitchDown,
+		EventSwitchUp,
+		EventSwitchClick,
+		EventSwitchDoubleClick,
+		EventSwitchTripleClick,
+		EventSwitchHold,
+		EventUnknown
+	};
+
+	typedef void TEventHandler (TEvent Event, void *pParam);
+
+public:
+	CKY040 (unsigned nCLKPin, unsigned nDTPin, unsigned nSWPin,
+		CGPIOManager *pGPIOManager = 0, unsigned nDetents = 1) {}
+
+	boolean Initialize (void)	{ return TRUE; }
+
+	void RegisterEventHandler (TEventHandler *pHandler, void *pParam = 0) {}
+
+	unsigned GetHoldSeconds (void) const	{ return 0; }
+};
+
+#endif
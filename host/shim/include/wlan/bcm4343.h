@@ -0,0 +1,19 @@
+//
+// bcm4343.h
+//
+// Host (POSIX) shim of Circle's <wlan/bcm4343.h>
+//
+#ifndef _wlan_bcm4343_h
+#define _wlan_bcm4343_h
+
+#include <circle/types.h>
+
+class CBcm4343Device
+{
+public:
+	CBcm4343Device (const char *pFirmwarePath) {}
+
+	boolean Initialize (void)	{ return FALSE; }
+};
+
+#endif
@@ -0,0 +1,20 @@
+//
+// wpasupplicant.h
+//
+// Host (POSIX) shim of Circle's <wlan/hostap/wpa_supplicant/wpasupplicant.h>
+//
+#ifndef _wlan_hostap_wpa_supplicant_wpasupplicant_h
+#define _wlan_hostap_wpa_supplicant_wpasupplicant_h
+
+#include <circle/types.h>
+
+class CWPASupplicant
+{
+public:
+	CWPASupplicant (const char *pConfigFile) {}
+
+	boolean Initialize (void)		{ return FALSE; }
+	boolean IsConnected (void) const	{ return FALSE; }
+};
+
+#endif
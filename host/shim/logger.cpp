@@ -0,0 +1,82 @@
+//
+// logger.cpp
+//
+// Host (POSIX) shim of Circle's CLogger, writes to stderr
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <circle/logger.h>
+#include <circle/timer.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+CLogger *CLogger::s_pThis = 0;
+
+CLogger::CLogger (unsigned nLogLevel, CTimer *pTimer, boolean bOverwriteOldest)
+:	m_nLogLevel (nLogLevel)
+{
+	s_pThis = this;
+}
+
+CLogger::~CLogger (void)
+{
+	s_pThis = 0;
+}
+
+boolean CLogger::Initialize (CDevice *pTarget)
+{
+	return TRUE;
+}
+
+void CLogger::Write (const char *pSource, TLogSeverity Severity, const char *pMessage, ...)
+{
+	if ((unsigned) Severity > m_nLogLevel)
+	{
+		return;
+	}
+
+	static const char *Prefix[] = {"!", "*", "?", " ", " "};
+
+	char Buffer[1000];
+	va_list var;
+	va_start (var, pMessage);
+	vsnprintf (Buffer, sizeof Buffer, pMessage, var);
+	va_end (var);
+
+	unsigned nTicks = CTimer::GetClockTicks ();
+
+	m_Mutex.lock ();
+	fprintf (stderr, "%u.%06u %s%s: %s\n", nTicks / CLOCKHZ, nTicks % CLOCKHZ,
+		 Prefix[Severity], pSource, Buffer);
+	m_Mutex.unlock ();
+
+	if (Severity == LogPanic)
+	{
+		abort ();
+	}
+}
+
+CLogger *CLogger::Get (void)
+{
+	if (!s_pThis)
+	{
+		static CLogger s_DefaultLogger (LogNotice);
+	}
+
+	return s_pThis;
+}
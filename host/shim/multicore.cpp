@@ -0,0 +1,65 @@
+//
+// multicore.cpp
+//
+// Host (POSIX) shim of Circle's CMultiCoreSupport, one std::thread per core
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <circle/multicore.h>
+#include <stdlib.h>
+
+static thread_local unsigned s_nThisCore = 0;
+
+CMultiCoreSupport::CMultiCoreSupport (CMemorySystem *pMemorySystem)
+{
+}
+
+CMultiCoreSupport::~CMultiCoreSupport (void)
+{
+	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	{
+		if (m_Thread[nCore].joinable ())
+		{
+			m_Thread[nCore].join ();
+		}
+	}
+}
+
+boolean CMultiCoreSupport::Initialize (void)
+{
+	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	{
+		m_Thread[nCore] = std::thread ([this, nCore] (void)
+			{
+				s_nThisCore = nCore;
+
+				Run (nCore);
+			});
+	}
+
+	return TRUE;
+}
+
+unsigned CMultiCoreSupport::ThisCore (void)
+{
+	return s_nThisCore;
+}
+
+void CMultiCoreSupport::HaltAll (void)
+{
+	exit (EXIT_FAILURE);
+}
@@ -0,0 +1,121 @@
+//
+// netstub.cpp
+//
+// Null implementations of MiniDexed's network services for the host build.
+// The network subsystem of the shim never comes up, so these are only
+// needed to link.
+//
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "udpmididevice.h"
+#include "net/ftpdaemon.h"
+#include "net/mdnspublisher.h"
+
+CUDPMIDIDevice::CUDPMIDIDevice (CMiniDexed *pSynthesizer,
+				      CConfig *pConfig, CUserInterface *pUI)
+:	CMIDIDevice (pSynthesizer, pConfig, pUI),
+	m_pSynthesizer (pSynthesizer),
+	m_pConfig (pConfig),
+	m_pAppleMIDIParticipant (nullptr),
+	m_pUDPMIDIReceiver (nullptr)
+{
+}
+
+CUDPMIDIDevice::~CUDPMIDIDevice (void)
+{
+}
+
+boolean CUDPMIDIDevice::Initialize (void)
+{
+	return FALSE;
+}
+
+void CUDPMIDIDevice::OnAppleMIDIDataReceived (const u8 *pData, size_t nSize)
+{
+}
+
+void CUDPMIDIDevice::OnAppleMIDIConnect (const CIPAddress *pIPAddress, const char *pName)
+{
+}
+
+void CUDPMIDIDevice::OnAppleMIDIDisconnect (const CIPAddress *pIPAddress, const char *pName)
+{
+}
+
+void CUDPMIDIDevice::OnUDPMIDIDataReceived (const u8 *pData, size_t nSize)
+{
+}
+
+void CUDPMIDIDevice::Send (const u8 *pMessage, size_t nLength, unsigned nCable)
+{
+}
+
+CFTPDaemon::CFTPDaemon (const char *pUser, const char *pPassword,
+			CmDNSPublisher *pMDNSPublisher, CConfig *pConfig)
+:	m_pListenSocket (nullptr),
+	m_pUser (pUser),
+	m_pPassword (pPassword),
+	m_pmDNSPublisher (pMDNSPublisher),
+	m_pConfig (pConfig)
+{
+}
+
+CFTPDaemon::~CFTPDaemon (void)
+{
+}
+
+bool CFTPDaemon::Initialize (void)
+{
+	return false;
+}
+
+void CFTPDaemon::Run (void)
+{
+}
+
+CmDNSPublisher::CmDNSPublisher (CNetSubSystem *pNet)
+:	m_pNet (pNet),
+	m_pSocket (nullptr),
+	m_bRunning (FALSE)
+{
+}
+
+CmDNSPublisher::~CmDNSPublisher (void)
+{
+}
+
+boolean CmDNSPublisher::PublishService (const char *pServiceName, const char *pServiceType,
+					 u16 usServicePort, const char *ppText[])
+{
+	return FALSE;
+}
+
+boolean CmDNSPublisher::UnpublishService (const char *pServiceName)
+{
+	return FALSE;
+}
+
+boolean CmDNSPublisher::UnpublishService (const char *pServiceName, const char *pServiceType,
+					   u16 usServicePort)
+{
+	return FALSE;
+}
+
+void CmDNSPublisher::Run (void)
+{
+}
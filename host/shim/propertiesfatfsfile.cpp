@@ -0,0 +1,253 @@
+//
+// propertiesfatfsfile.cpp
+//
+// Host (POSIX) shim of Circle's CPropertiesFatFsFile
+//
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <Properties/propertiesfatfsfile.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+CPropertiesFatFsFile::CPropertiesFatFsFile (const char *pFileName, FATFS *pFileSystem)
+:	m_FileName (pFileName)
+{
+}
+
+CPropertiesFatFsFile::~CPropertiesFatFsFile (void)
+{
+}
+
+boolean CPropertiesFatFsFile::Load (void)
+{
+	RemoveAll ();
+
+	FIL File;
+	if (f_open (&File, m_FileName.c_str (), FA_READ | FA_OPEN_EXISTING) != FR_OK)
+	{
+		return FALSE;
+	}
+
+	std::string Content;
+	char Buffer[1024];
+	UINT nBytesRead;
+	while (f_read (&File, Buffer, sizeof Buffer, &nBytesRead) == FR_OK && nBytesRead > 0)
+	{
+		Content.append (Buffer, nBytesRead);
+	}
+
+	f_close (&File);
+
+	size_t nPos = 0;
+	while (nPos < Content.length ())
+	{
+		size_t nEnd = Content.find ('\n', nPos);
+		if (nEnd == std::string::npos)
+		{
+			nEnd = Content.length ();
+		}
+
+		std::string Line = Content.substr (nPos, nEnd - nPos);
+		nPos = nEnd + 1;
+
+		size_t nFirst = Line.find_first_not_of (" \t");
+		size_t nLast = Line.find_last_not_of (" \t\r");
+		if (nFirst == std::string::npos || Line[nFirst] == '#')
+		{
+			continue;
+		}
+		Line = Line.substr (nFirst, nLast - nFirst + 1);
+
+		size_t nEqual = Line.find ('=');
+		if (nEqual == std::string::npos || nEqual == 0)
+		{
+			continue;
+		}
+
+		std::string Name = Line.substr (0, nEqual);
+		Name.erase (Name.find_last_not_of (" \t") + 1);
+		std::string Value = Line.substr (nEqual + 1);
+		Value.erase (0, Value.find_first_not_of (" \t") == std::string::npos
+				? Value.length () : Value.find_first_not_of (" \t"));
+
+		SetString (Name.c_str (), Value.c_str ());
+	}
+
+	return TRUE;
+}
+
+boolean CPropertiesFatFsFile::Save (void)
+{
+	FIL File;
+	if (f_open (&File, m_FileName.c_str (), FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+	{
+		return FALSE;
+	}
+
+	boolean bOK = TRUE;
+	for (const TProperty &rProperty : m_Properties)
+	{
+		std::string Line = rProperty.Name + "=" + rProperty.Value + "\n";
+
+		UINT nBytesWritten;
+		if (   f_write (&File, Line.c_str (), Line.length (), &nBytesWritten) != FR_OK
+		    || nBytesWritten != Line.length ())
+		{
+			bOK = FALSE;
+
+			break;
+		}
+	}
+
+	if (f_close (&File) != FR_OK)
+	{
+		bOK = FALSE;
+	}
+
+	return bOK;
+}
+
+void CPropertiesFatFsFile::RemoveAll (void)
+{
+	m_Properties.clear ();
+}
+
+boolean CPropertiesFatFsFile::IsSet (const char *pPropertyName) const
+{
+	return Find (pPropertyName) != 0;
+}
+
+const char *CPropertiesFatFsFile::GetString (const char *pPropertyName, const char *pDefault) const
+{
+	const TProperty *pProperty = Find (pPropertyName);
+
+	return pProperty ? pProperty->Value.c_str () : pDefault;
+}
+
+unsigned CPropertiesFatFsFile::GetNumber (const char *pPropertyName, unsigned nDefault) const
+{
+	const TProperty *pProperty = Find (pPropertyName);
+	if (!pProperty || pProperty->Value.empty ())
+	{
+		return nDefault;
+	}
+
+	const char *pValue = pProperty->Value.c_str ();
+	unsigned nBase = 10;
+	if (strncmp (pValue, "0x", 2) == 0 || strncmp (pValue, "0X", 2) == 0)
+	{
+		pValue += 2;
+		nBase = 16;
+	}
+
+	char *pEnd;
+	unsigned long nValue = strtoul (pValue, &pEnd, nBase);
+
+	return *pEnd == '\0' ? (unsigned) nValue : nDefault;
+}
+
+int CPropertiesFatFsFile::GetSignedNumber (const char *pPropertyName, int nDefault) const
+{
+	const TProperty *pProperty = Find (pPropertyName);
+	if (!pProperty || pProperty->Value.empty ())
+	{
+		return nDefault;
+	}
+
+	char *pEnd;
+	long nValue = strtol (pProperty->Value.c_str (), &pEnd, 10);
+
+	return *pEnd == '\0' ? (int) nValue : nDefault;
+}
+
+const u8 *CPropertiesFatFsFile::GetIPAddress (const char *pPropertyName) const
+{
+	const TProperty *pProperty = Find (pPropertyName);
+	if (!pProperty)
+	{
+		return 0;
+	}
+
+	unsigned Byte[4];
+	char chEnd;
+	if (   sscanf (pProperty->Value.c_str (), "%u.%u.%u.%u%c", &Byte[0], &Byte[1], &Byte[2], &Byte[3], &chEnd) != 4
+	    || Byte[0] > 255 || Byte[1] > 255 || Byte[2] > 255 || Byte[3] > 255)
+	{
+		return 0;
+	}
+
+	for (unsigned i = 0; i < 4; i++)
+	{
+		m_IPAddress[i] = (u8) Byte[i];
+	}
+
+	return m_IPAddress;
+}
+
+void CPropertiesFatFsFile::SetString (const char *pPropertyName, const char *pValue)
+{
+	assert (pPropertyName);
+	assert (pValue);
+
+	for (TProperty &rProperty : m_Properties)
+	{
+		if (rProperty.Name == pPropertyName)
+		{
+			rProperty.Value = pValue;
+
+			return;
+		}
+	}
+
+	m_Properties.push_back ({pPropertyName, pValue});
+}
+
+void CPropertiesFatFsFile::SetNumber (const char *pPropertyName, unsigned nValue, unsigned nBase)
+{
+	assert (nBase == 10 || nBase == 16);
+
+	char Buffer[20];
+	snprintf (Buffer, sizeof Buffer, nBase == 16 ? "0x%X" : "%u", nValue);
+
+	SetString (pPropertyName, Buffer);
+}
+
+void CPropertiesFatFsFile::SetSignedNumber (const char *pPropertyName, int nValue)
+{
+	char Buffer[20];
+	snprintf (Buffer, sizeof Buffer, "%d", nValue);
+
+	SetString (pPropertyName, Buffer);
+}
+
+const CPropertiesFatFsFile::TProperty *CPropertiesFatFsFile::Find (const char *pPropertyName) const
+{
+	assert (pPropertyName);
+
+	for (const TProperty &rProperty : m_Properties)
+	{
+		if (rProperty.Name == pPropertyName)
+		{
+			return &rProperty;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,301 @@
+//
+// soundbasedevice.cpp
+//
+// Host (POSIX) shim of Circle's CSoundBaseDevice, writes to a null or WAV sink
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <circle/sound/soundbasedevice.h>
+#include <circle/logger.h>
+#include <circle/timer.h>
+#include <assert.h>
+#include <string.h>
+
+LOGMODULE ("sound");
+
+const char *CSoundBaseDevice::s_pWAVFileName = 0;
+TSoundPacing CSoundBaseDevice::s_Pacing = SoundPacingRealTime;
+u64 CSoundBaseDevice::s_nMaxFrames = 0;
+unsigned CSoundBaseDevice::s_nWAVBits = 32;
+CSoundBaseDevice *CSoundBaseDevice::s_pThis = 0;
+
+static void PutLE (u8 *pBuffer, u32 nValue, unsigned nBytes)
+{
+	for (unsigned i = 0; i < nBytes; i++, nValue >>= 8)
+	{
+		pBuffer[i] = nValue & 0xFF;
+	}
+}
+
+CSoundBaseDevice::CSoundBaseDevice (unsigned nSampleRate, unsigned nChunkSize)
+:	m_nSampleRate (nSampleRate),
+	m_nChunkSize (nChunkSize),
+	m_nQueueSizeFrames (0),
+	m_nChannels (2),
+	m_nBytesPerSample (4),
+	m_nWAVBytesPerSample (4),
+	m_bActive (false),
+	m_nFramesWritten (0),
+	m_nFramesPlayed (0),
+	m_nStartTicks (0),
+	m_nUnderruns (0),
+	m_nFramesReleased (0),
+	m_pFile (0)
+{
+	s_pThis = this;
+}
+
+CSoundBaseDevice::~CSoundBaseDevice (void)
+{
+	Cancel ();
+
+	s_pThis = 0;
+}
+
+boolean CSoundBaseDevice::AllocateQueueFrames (unsigned nSizeFrames)
+{
+	assert (nSizeFrames > 0);
+	m_nQueueSizeFrames = nSizeFrames;
+
+	return TRUE;
+}
+
+void CSoundBaseDevice::SetWriteFormat (TSoundFormat Format, unsigned nChannels)
+{
+	assert (Format == SoundFormatSigned16 || Format == SoundFormatSigned24_32);
+	assert (1 <= nChannels && nChannels <= 8);
+
+	m_nBytesPerSample = Format == SoundFormatSigned16 ? 2 : 4;
+	m_nWAVBytesPerSample = Format == SoundFormatSigned16 ? 2 : s_nWAVBits / 8;
+	m_nChannels = nChannels;
+}
+
+unsigned CSoundBaseDevice::GetQueueSizeFrames (void)
+{
+	return m_nQueueSizeFrames;
+}
+
+unsigned CSoundBaseDevice::GetQueueFramesAvail (void)
+{
+	// Without real-time pacing, the queue is reported half full, when the
+	// next chunk can be written, so that this is not taken for an underrun.
+	if (s_Pacing == SoundPacingExternal)
+	{
+		return   m_nFramesReleased.load (std::memory_order_acquire)
+		       > m_nFramesWritten.load (std::memory_order_relaxed) ? m_nQueueSizeFrames/2 : m_nQueueSizeFrames;
+	}
+
+	if (s_Pacing == SoundPacingFreeRunning)
+	{
+		return m_nQueueSizeFrames/2;
+	}
+
+	if (!m_nStartTicks)
+	{
+		return 0;
+	}
+
+	// frames the DAC would have consumed by now, including silence after an underrun
+	u64 nClock = (CTimer::GetClockTicks64 () - m_nStartTicks) * m_nSampleRate / CLOCKHZ;
+	u64 nWritten = m_nFramesWritten.load (std::memory_order_relaxed);
+
+	if (nClock - m_nFramesPlayed > nWritten)
+	{
+		m_nFramesPlayed = nClock - nWritten;
+		m_nUnderruns++;
+
+		return 0;
+	}
+
+	return (unsigned) (nWritten - (nClock - m_nFramesPlayed));
+}
+
+int CSoundBaseDevice::Write (const void *pBuffer, size_t nCount)
+{
+	if (!m_bActive)
+	{
+		return (int) nCount;			// discard output after the end
+	}
+
+	if (!m_nStartTicks)
+	{
+		m_nStartTicks = CTimer::GetClockTicks64 ();
+	}
+
+	unsigned nFrameSize = m_nBytesPerSample * m_nChannels;
+	assert (nCount % nFrameSize == 0);
+	u64 nFrames = nCount / nFrameSize;
+
+	u64 nWritten = m_nFramesWritten.load (std::memory_order_relaxed);
+	if (s_nMaxFrames && nWritten + nFrames >= s_nMaxFrames)
+	{
+		nFrames = s_nMaxFrames - nWritten;
+	}
+
+	if (m_pFile)
+	{
+		// 24-bit samples are written as 24-bit or left-aligned 32-bit PCM
+		m_WAVBuffer.resize (nFrames * m_nChannels * m_nWAVBytesPerSample);
+		u8 *pOut = m_WAVBuffer.data ();
+
+		const u8 *pSample = (const u8 *) pBuffer;
+		for (u64 i = 0; i < nFrames * m_nChannels; i++, pSample += m_nBytesPerSample)
+		{
+			if (m_nBytesPerSample == 2)
+			{
+				PutLE (pOut, *(const s16 *) pSample, 2);
+			}
+			else if (m_nWAVBytesPerSample == 3)
+			{
+				PutLE (pOut, *(const s32 *) pSample, 3);
+			}
+			else
+			{
+				PutLE (pOut, (u32) *(const s32 *) pSample << 8, 4);
+			}
+
+			pOut += m_nWAVBytesPerSample;
+		}
+
+		fwrite (m_WAVBuffer.data (), m_WAVBuffer.size (), 1, m_pFile);
+	}
+
+	m_nFramesWritten.store (nWritten + nFrames, std::memory_order_release);
+
+	if (s_nMaxFrames && nWritten + nFrames == s_nMaxFrames)
+	{
+		Cancel ();
+	}
+
+	if (s_Pacing == SoundPacingExternal)
+	{
+		std::lock_guard<std::mutex> Lock (m_WrittenMutex);
+		m_WrittenCondition.notify_all ();
+	}
+
+	return (int) nCount;
+}
+
+boolean CSoundBaseDevice::Start (void)
+{
+	assert (m_nQueueSizeFrames > 0);
+
+	if (s_pWAVFileName)
+	{
+		m_pFile = fopen (s_pWAVFileName, "wb");
+		if (!m_pFile)
+		{
+			LOGERR ("Cannot create %s", s_pWAVFileName);
+
+			return FALSE;
+		}
+
+		WriteWAVHeader ();
+	}
+
+	m_bActive = true;
+
+	return TRUE;
+}
+
+void CSoundBaseDevice::Cancel (void)
+{
+	m_bActive = false;
+
+	if (m_pFile)
+	{
+		WriteWAVHeader ();
+
+		fclose (m_pFile);
+		m_pFile = 0;
+	}
+}
+
+boolean CSoundBaseDevice::IsActive (void) const
+{
+	return m_bActive;
+}
+
+void CSoundBaseDevice::SetOutput (const char *pWAVFileName, TSoundPacing Pacing,
+				  u64 nMaxFrames, unsigned nWAVBits)
+{
+	assert (nWAVBits == 24 || nWAVBits == 32);
+
+	s_pWAVFileName = pWAVFileName;
+	s_Pacing = Pacing;
+	s_nMaxFrames = nMaxFrames;
+	s_nWAVBits = nWAVBits;
+}
+
+CSoundBaseDevice *CSoundBaseDevice::Get (void)
+{
+	return s_pThis;
+}
+
+u64 CSoundBaseDevice::GetFramesWritten (void) const
+{
+	return m_nFramesWritten.load (std::memory_order_relaxed);
+}
+
+u64 CSoundBaseDevice::GetUnderruns (void) const
+{
+	return m_nUnderruns;
+}
+
+void CSoundBaseDevice::ReleaseFrames (unsigned nFrames)
+{
+	assert (s_Pacing == SoundPacingExternal);
+
+	m_nFramesReleased.fetch_add (nFrames, std::memory_order_release);
+}
+
+void CSoundBaseDevice::WaitFramesWritten (u64 nFrames)
+{
+	assert (s_Pacing == SoundPacingExternal);
+
+	std::unique_lock<std::mutex> Lock (m_WrittenMutex);
+	m_WrittenCondition.wait (Lock, [this, nFrames]
+		{
+			return    m_nFramesWritten.load (std::memory_order_acquire) >= nFrames
+			       || !m_bActive;
+		});
+}
+
+void CSoundBaseDevice::WriteWAVHeader (void)
+{
+	assert (m_pFile);
+
+	u32 nDataSize = (u32) (m_nFramesWritten.load () * m_nChannels * m_nWAVBytesPerSample);
+
+	u8 Header[44];
+	memcpy (Header, "RIFF", 4);
+	PutLE (Header+4, 36 + nDataSize, 4);
+	memcpy (Header+8, "WAVEfmt ", 8);
+	PutLE (Header+16, 16, 4);				// fmt chunk size
+	PutLE (Header+20, 1, 2);				// PCM
+	PutLE (Header+22, m_nChannels, 2);
+	PutLE (Header+24, m_nSampleRate, 4);
+	PutLE (Header+28, m_nSampleRate * m_nChannels * m_nWAVBytesPerSample, 4);
+	PutLE (Header+32, m_nChannels * m_nWAVBytesPerSample, 2);
+	PutLE (Header+34, m_nWAVBytesPerSample * 8, 2);
+	memcpy (Header+36, "data", 4);
+	PutLE (Header+40, nDataSize, 4);
+
+	fseek (m_pFile, 0, SEEK_SET);
+	fwrite (Header, sizeof Header, 1, m_pFile);
+	fseek (m_pFile, 0, SEEK_END);
+}
@@ -0,0 +1,156 @@
+//
+// timer.cpp
+//
+// Host (POSIX) shim of Circle's CTimer
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <circle/timer.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <assert.h>
+
+static const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now ();
+
+static std::atomic<bool> s_bVirtualClock (false);
+static std::atomic<u64> s_nVirtualTicks (0);
+
+CTimer::CTimer (CInterruptSystem *pInterruptSystem)
+{
+	for (unsigned i = 0; i < MaxKernelTimers; i++)
+	{
+		m_KernelTimer[i].pHandler = 0;
+	}
+}
+
+CTimer::~CTimer (void)
+{
+}
+
+unsigned CTimer::GetTicks (void) const
+{
+	return (unsigned) (GetClockTicks64 () / (CLOCKHZ / HZ));
+}
+
+unsigned CTimer::GetUptime (void) const
+{
+	return (unsigned) (GetClockTicks64 () / CLOCKHZ);
+}
+
+TKernelTimerHandle CTimer::StartKernelTimer (unsigned nDelay, TKernelTimerHandler *pHandler,
+					     void *pParam, void *pContext)
+{
+	assert (pHandler);
+
+	m_TimerSpinLock.Acquire ();
+
+	unsigned i;
+	for (i = 0; i < MaxKernelTimers; i++)
+	{
+		if (!m_KernelTimer[i].pHandler)
+		{
+			m_KernelTimer[i].pHandler = pHandler;
+			m_KernelTimer[i].nElapsesAt = GetClockTicks64 () + (u64) nDelay * (CLOCKHZ / HZ);
+			m_KernelTimer[i].pParam = pParam;
+			m_KernelTimer[i].pContext = pContext;
+
+			break;
+		}
+	}
+
+	m_TimerSpinLock.Release ();
+
+	assert (i < MaxKernelTimers);
+
+	return i + 1;
+}
+
+void CTimer::CancelKernelTimer (TKernelTimerHandle hTimer)
+{
+	assert (1 <= hTimer && hTimer <= MaxKernelTimers);
+
+	m_TimerSpinLock.Acquire ();
+
+	m_KernelTimer[hTimer-1].pHandler = 0;
+
+	m_TimerSpinLock.Release ();
+}
+
+void CTimer::PollKernelTimers (void)
+{
+	u64 nNow = GetClockTicks64 ();
+
+	for (unsigned i = 0; i < MaxKernelTimers; i++)
+	{
+		m_TimerSpinLock.Acquire ();
+
+		TKernelTimer Timer = m_KernelTimer[i];
+		if (!Timer.pHandler || Timer.nElapsesAt > nNow)
+		{
+			m_TimerSpinLock.Release ();
+
+			continue;
+		}
+
+		m_KernelTimer[i].pHandler = 0;
+
+		m_TimerSpinLock.Release ();
+
+		// the handler may start a new timer
+		(*Timer.pHandler) (i + 1, Timer.pParam, Timer.pContext);
+	}
+}
+
+CTimer *CTimer::Get (void)
+{
+	static CTimer s_Timer;
+
+	return &s_Timer;
+}
+
+unsigned CTimer::GetClockTicks (void)
+{
+	return (unsigned) GetClockTicks64 ();
+}
+
+u64 CTimer::GetClockTicks64 (void)
+{
+	if (s_bVirtualClock.load (std::memory_order_acquire))
+	{
+		return s_nVirtualTicks.load (std::memory_order_acquire);
+	}
+
+	return std::chrono::duration_cast<std::chrono::microseconds> (
+		std::chrono::steady_clock::now () - StartTime).count ();
+}
+
+void CTimer::SimpleMsDelay (unsigned nMilliSeconds)
+{
+	std::this_thread::sleep_for (std::chrono::milliseconds (nMilliSeconds));
+}
+
+void CTimer::SimpleusDelay (unsigned nMicroSeconds)
+{
+	std::this_thread::sleep_for (std::chrono::microseconds (nMicroSeconds));
+}
+
+void CTimer::SetVirtualClock (u64 nTicks)
+{
+	s_nVirtualTicks.store (nTicks, std::memory_order_release);
+	s_bVirtualClock.store (true, std::memory_order_release);
+}
@@ -0,0 +1,176 @@
+#include "arm_scale_zip_q23.h"
+
+/**
+  Scale, convert to Q23 and interleave in a single pass. This replaces
+  arm_scale_zip_f32() followed by arm_float_to_q23() on the output path.
+  The results are the same as those of the two stage version.
+
+  <pre>
+      pDst[n*C+c] = SSAT24(pSrc[c][n] * scale * 8388608)   0 <= n < blockSize, C = 2 or 8
+  </pre>
+
+ */
+
+#if defined(ARM_MATH_NEON_EXPERIMENTAL)
+static inline int32x4_t scale_to_q23(float32x4_t inV, float32_t scale)
+{
+    int32x4_t cvt = vcvtq_n_s32_f32(vmulq_n_f32(inV, scale), 23);
+
+    /* saturate */
+    cvt = vminq_s32(cvt, vdupq_n_s32(0x007fffff));
+    return vmaxq_s32(cvt, vdupq_n_s32(0xff800000));
+}
+#endif
+
+/* Same result as __SSAT((q31_t) (in * scale * 8388608.0f), 24), but saturating
+** before the conversion lets the compiler vectorize the loops. */
+static inline q23_t scale_to_q23_scalar(float32_t in, float32_t scale)
+{
+    float32_t out = in * scale * 8388608.0f;
+
+    out = out < 8388607.0f ? out : 8388607.0f;
+    out = out > -8388608.0f ? out : -8388608.0f;
+
+    return (q23_t) out;
+}
+
+void arm_scale_zip_q23(
+  const float32_t * pSrc1,
+  const float32_t * pSrc2,
+        float32_t scale,
+        q23_t * pDst,
+        uint32_t blockSize)
+{
+    q23_t *pLast;
+    uint32_t blkCnt;                               /* Loop counter */
+
+    if (blockSize == 0U)
+    {
+        return;
+    }
+
+    pLast = pDst + 2 * blockSize - 1;
+
+#if defined(ARM_MATH_NEON_EXPERIMENTAL)
+    int32x4x2_t res;
+
+    /* Compute 4 output frames at a time */
+    blkCnt = blockSize >> 2U;
+
+    while (blkCnt > 0U)
+    {
+        res.val[0] = scale_to_q23(vld1q_f32(pSrc1), scale);
+        res.val[1] = scale_to_q23(vld1q_f32(pSrc2), scale);
+        vst2q_s32(pDst, res);
+
+        /* Increment pointers */
+        pSrc1 += 4;
+        pSrc2 += 4;
+        pDst += 8;
+
+        /* Decrement the loop counter */
+        blkCnt--;
+    }
+
+    /* If the blockSize is not a multiple of 4, compute any remaining output samples here.
+    ** No loop unrolling is used. */
+    blkCnt = blockSize & 3;
+#else
+    blkCnt = blockSize;
+#endif
+
+    while (blkCnt > 0U)
+    {
+        *pDst++ = scale_to_q23_scalar(*pSrc1++, scale);
+        *pDst++ = scale_to_q23_scalar(*pSrc2++, scale);
+
+        /* Decrement the loop counter */
+        blkCnt--;
+    }
+
+    /* Prevent PCM510x analog mute from kicking in */
+    if (*pLast == 0)
+    {
+        *pLast = 1;
+    }
+}
+
+void arm_scale_zip8_q23(
+  const float32_t * const pSrc[8],
+        float32_t scale,
+        q23_t * pDst,
+        uint32_t blockSize)
+{
+    q23_t *pLast;
+    uint32_t nFrame = 0;
+    uint32_t nChannel;
+
+    if (blockSize == 0U)
+    {
+        return;
+    }
+
+    pLast = pDst + 8 * (blockSize - 1);
+
+#if defined(ARM_MATH_NEON_EXPERIMENTAL)
+    /* Compute 4 output frames at a time, 4x4 transpose of each half of the channels */
+    for (; nFrame + 4 <= blockSize; nFrame += 4)
+    {
+        int32x4_t lo[4], hi[4];
+        int32x4x2_t ac, bd, r01, r23;
+
+        for (nChannel = 0; nChannel < 4; nChannel++)
+        {
+            lo[nChannel] = scale_to_q23(vld1q_f32(pSrc[nChannel] + nFrame), scale);
+            hi[nChannel] = scale_to_q23(vld1q_f32(pSrc[nChannel+4] + nFrame), scale);
+        }
+
+        ac = vzipq_s32(lo[0], lo[2]);
+        bd = vzipq_s32(lo[1], lo[3]);
+        r01 = vzipq_s32(ac.val[0], bd.val[0]);
+        r23 = vzipq_s32(ac.val[1], bd.val[1]);
+        lo[0] = r01.val[0]; lo[1] = r01.val[1];
+        lo[2] = r23.val[0]; lo[3] = r23.val[1];
+
+        ac = vzipq_s32(hi[0], hi[2]);
+        bd = vzipq_s32(hi[1], hi[3]);
+        r01 = vzipq_s32(ac.val[0], bd.val[0]);
+        r23 = vzipq_s32(ac.val[1], bd.val[1]);
+        hi[0] = r01.val[0]; hi[1] = r01.val[1];
+        hi[2] = r23.val[0]; hi[3] = r23.val[1];
+
+        for (nChannel = 0; nChannel < 4; nChannel++)
+        {
+            vst1q_s32(pDst, lo[nChannel]);
+            vst1q_s32(pDst + 4, hi[nChannel]);
+            pDst += 8;
+        }
+    }
+#endif
+
+    /* Compute any remaining output frames here, one channel after the other. */
+    for (nChannel = 0; nChannel < 8; nChannel++)
+    {
+        const float32_t *pIn = pSrc[nChannel] + nFrame;
+        q23_t *pOut = pDst + nChannel;
+        uint32_t blkCnt = blockSize - nFrame;
+
+        while (blkCnt > 0U)
+        {
+            *pOut = scale_to_q23_scalar(*pIn++, scale);
+            pOut += 8;
+
+            /* Decrement the loop counter */
+            blkCnt--;
+        }
+    }
+
+    /* Prevent PCM510x analog mute from kicking in */
+    for (nChannel = 0; nChannel < 8; nChannel++)
+    {
+        if (pLast[nChannel] == 0)
+        {
+            pLast[nChannel] = 1;
+        }
+    }
+}
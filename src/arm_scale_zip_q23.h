@@ -0,0 +1,34 @@
+#pragma once
+
+#include "arm_math_types.h"
+#include "arm_float_to_q23.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* @brief Scale two floating-point vectors with a scalar, convert to Q23 and zip (stereo output).
+*        If the last output sample is 0, it is set to 1 to prevent the PCM510x analog mute.
+* @param[in]  pSrc1      points to the input vector 1 (left)
+* @param[in]  pSrc2      points to the input vector 2 (right)
+* @param[in]  scale      scale scalar
+* @param[out] pDst       points to the Q23 output vector (2 * blockSize samples)
+* @param[in]  blockSize  number of samples in each input vector
+*/
+void arm_scale_zip_q23(const float32_t * pSrc1, const float32_t * pSrc2, float32_t scale, q23_t * pDst, uint32_t blockSize);
+
+/**
+* @brief Scale eight floating-point vectors with a scalar, convert to Q23 and interleave (8-channel output).
+*        If the last output sample of a channel is 0, it is set to 1 to prevent the PCM510x analog mute.
+* @param[in]  pSrc       points to the eight input vectors
+* @param[in]  scale      scale scalar
+* @param[out] pDst       points to the Q23 output vector (8 * blockSize samples)
+* @param[in]  blockSize  number of samples in each input vector
+*/
+void arm_scale_zip8_q23(const float32_t * const pSrc[8], float32_t scale, q23_t * pDst, uint32_t blockSize);
+
+#ifdef __cplusplus
+}
+#endif
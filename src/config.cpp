@@ -22,6 +22,9 @@
 //
 #include "config.h"
 #include "../Synth_Dexed/src/dexed.h"
+#include <circle/string.h>
+#include <stdlib.h>
+#include <assert.h>
 
 CConfig::CConfig (FATFS *pFileSystem)
 :	m_Properties ("minidexed.ini", pFileSystem)
@@ -39,9 +42,7 @@ void CConfig::Load (void)
 	// Number of Tone Generators and Polyphony
 	m_nToneGenerators = m_Properties.GetNumber ("ToneGenerators", DefToneGenerators);
 	m_nPolyphony = m_Properties.GetNumber ("Polyphony", DefaultNotes);
-	// At present there are only two options for tone generators: min or max
-	// and for the Pi 1,2,3 these are the same anyway.
-	if ((m_nToneGenerators != MinToneGenerators) && (m_nToneGenerators != AllToneGenerators))
+	if ((m_nToneGenerators < MinToneGenerators) || (m_nToneGenerators > AllToneGenerators))
 	{
 		m_nToneGenerators = DefToneGenerators;
 	}
@@ -49,6 +50,12 @@ void CConfig::Load (void)
 	{
 		m_nPolyphony = DefaultNotes;
 	}
+	m_bVoicePool = m_Properties.GetNumber ("VoicePool", 0) != 0;
+	m_nVoicePoolLoad = m_Properties.GetNumber ("VoicePoolLoad", 70);
+	if (m_nVoicePoolLoad < 10 || m_nVoicePoolLoad > 95)
+	{
+		m_nVoicePoolLoad = 70;
+	}
 	
 	m_bUSBGadget = m_Properties.GetNumber ("USBGadget", 0) != 0;
 	m_nUSBGadgetPin = m_Properties.GetNumber ("USBGadgetPin", 0); // Default OFF
@@ -72,6 +79,31 @@ void CConfig::Load (void)
 	m_nDACI2CAddress = m_Properties.GetNumber ("DACI2CAddress", 0);
 	m_bChannelsSwapped = m_Properties.GetNumber ("ChannelsSwapped", 0) != 0;
 
+	m_nAudioPipelineDepth = m_Properties.GetNumber ("AudioPipelineDepth", 1);
+	if (m_nAudioPipelineDepth < 1 || m_nAudioPipelineDepth > MaxAudioPipelineDepth)
+	{
+		m_nAudioPipelineDepth = 1;
+	}
+	m_bAudioCoreSleep = m_Properties.GetNumber ("AudioCoreSleep", 1) != 0;
+	m_bMIDIEventTiming = m_Properties.GetNumber ("MIDIEventTiming", 0) != 0;
+
+	m_bLoadGovernor = m_Properties.GetNumber ("LoadGovernor", 1) != 0;
+	m_nLoadGovernorHigh = m_Properties.GetNumber ("LoadGovernorHigh", 85);
+	m_nLoadGovernorLow = m_Properties.GetNumber ("LoadGovernorLow", 60);
+	if (   m_nLoadGovernorLow >= m_nLoadGovernorHigh
+	    || m_nLoadGovernorHigh > 100)
+	{
+		m_nLoadGovernorHigh = 85;
+		m_nLoadGovernorLow = 60;
+	}
+	m_nLoadGovernorHold = m_Properties.GetNumber ("LoadGovernorHold", 2000);
+	m_nLoadGovernorVoiceLimit = m_Properties.GetNumber ("LoadGovernorVoiceLimit", 50);
+	if (m_nLoadGovernorVoiceLimit < 1 || m_nLoadGovernorVoiceLimit > 100)
+	{
+		m_nLoadGovernorVoiceLimit = 50;
+	}
+	m_bLoadGovernorReverbOff = m_Properties.GetNumber ("LoadGovernorReverbOff", 0) != 0;
+
 	unsigned newEngineType = m_Properties.GetNumber ("EngineType", 1);
 	if (newEngineType == 2) {
   		m_EngineType = MKI;
@@ -83,49 +115,34 @@ void CConfig::Load (void)
 
 	m_nMIDIBaudRate = m_Properties.GetNumber ("MIDIBaudRate", 31250);
 
-	const char *pMIDIThru = m_Properties.GetString ("MIDIThru");
-	if (pMIDIThru)
+	// MIDI Thru routes: input,output[,channel[,messages]]
+	unsigned nIgnoreMask = 0;
+	if (m_Properties.GetNumber ("MIDIThruIgnoreClock", 0) != 0)
 	{
-		std::string Arg (pMIDIThru);
-
-		size_t nPos = Arg.find (',');
-		if (nPos != std::string::npos)
-		{
-			m_MIDIThruIn = Arg.substr (0, nPos);
-			m_MIDIThruOut = Arg.substr (nPos+1);
-
-			if (   m_MIDIThruIn.empty ()
-			    || m_MIDIThruOut.empty ())
-			{
-				m_MIDIThruIn.clear ();
-				m_MIDIThruOut.clear ();
-			}
-		}
+		nIgnoreMask |= MIDIMessageClock;
 	}
-	
-	const char *pMIDIThru2 = m_Properties.GetString ("MIDIThru2");
-	if (pMIDIThru2)
+	if (m_Properties.GetNumber ("MIDIThruIgnoreActiveSensing", 0) != 0)
 	{
-		std::string Arg (pMIDIThru2);
+		nIgnoreMask |= MIDIMessageActiveSensing;
+	}
 
-		size_t nPos = Arg.find (',');
-		if (nPos != std::string::npos)
+	m_nMIDIRoutes = 0;
+	for (unsigned i = 0; i < MaxMIDIRoutes; i++)
+	{
+		CString PropertyName ("MIDIThru");
+		if (i > 0)
 		{
-			m_MIDIThru2In = Arg.substr (0, nPos);
-			m_MIDIThru2Out = Arg.substr (nPos+1);
+			PropertyName.Format ("MIDIThru%u", i+1);
+		}
 
-			if (   m_MIDIThru2In.empty ()
-			    || m_MIDIThru2Out.empty ())
-			{
-				m_MIDIThru2In.clear ();
-				m_MIDIThru2Out.clear ();
-			}
+		const char *pMIDIThru = m_Properties.GetString (PropertyName);
+		if (   pMIDIThru
+		    && ParseMIDIRoute (pMIDIThru, &m_MIDIRoute[m_nMIDIRoutes]))
+		{
+			m_MIDIRoute[m_nMIDIRoutes++].nMessageMask &= ~nIgnoreMask;
 		}
 	}
 
-	m_bMIDIThruIgnoreClock = m_Properties.GetNumber ("MIDIThruIgnoreClock", 0) != 0;
-	m_bMIDIThruIgnoreActiveSensing = m_Properties.GetNumber ("MIDIThruIgnoreActiveSensing", 0) != 0;
-
 	m_bMIDIRXProgramChange = m_Properties.GetNumber ("MIDIRXProgramChange", 1) != 0;
 	m_bIgnoreAllNotesOff = m_Properties.GetNumber ("IgnoreAllNotesOff", 0) != 0;
 	m_bMIDIAutoVoiceDumpOnPC = m_Properties.GetNumber ("MIDIAutoVoiceDumpOnPC", 0) != 0;
@@ -241,6 +258,11 @@ void CConfig::Load (void)
 
 	m_bMIDIDumpEnabled  = m_Properties.GetNumber ("MIDIDumpEnabled", 0) != 0;
 	m_bProfileEnabled = m_Properties.GetNumber ("ProfileEnabled", 0) != 0;
+	m_nProfileWindow = m_Properties.GetNumber ("ProfileWindow", 0);
+	if (m_nProfileWindow > MaxProfileWindow)
+	{
+		m_nProfileWindow = MaxProfileWindow;
+	}
 	m_bPerformanceSelectToLoad = m_Properties.GetNumber ("PerformanceSelectToLoad", 0) != 0;
 	m_bPerformanceSelectChannel = m_Properties.GetNumber ("PerformanceSelectChannel", 0);
 	
@@ -262,6 +284,110 @@ void CConfig::Load (void)
 	m_nMasterVolume = m_Properties.GetNumber ("MasterVolume", 64);
 }
 
+// Format: input,output[,channel[,messages]]
+// The channel is 1 .. 16 or 0 for all channels (default). Messages is a list
+// of message classes, separated by '+' (e.g. "notes+bend"), default is all.
+bool CConfig::ParseMIDIRoute (const char *pString, TMIDIRoute *pRoute)
+{
+	static const struct
+	{
+		const char *pName;
+		unsigned nMask;
+	}
+	MessageClass[] =
+	{
+		{"notes",	MIDIMessageNotes},
+		{"cc",		MIDIMessageControl},
+		{"pc",		MIDIMessageProgram},
+		{"at",		MIDIMessageAftertouch},
+		{"bend",	MIDIMessagePitchBend},
+		{"sysex",	MIDIMessageSysEx},
+		{"clock",	MIDIMessageClock},
+		{"sensing",	MIDIMessageActiveSensing},
+		{"system",	MIDIMessageSystem}
+	};
+
+	assert (pString);
+	assert (pRoute);
+
+	std::string Field[4];
+	unsigned nFields = 0;
+	std::string Arg (pString);
+	size_t nStart = 0;
+	while (nFields < 4)
+	{
+		size_t nPos = Arg.find (',', nStart);
+		Field[nFields++] = Arg.substr (nStart, nPos == std::string::npos ? nPos : nPos - nStart);
+		if (nPos == std::string::npos)
+		{
+			break;
+		}
+
+		nStart = nPos+1;
+	}
+
+	if (   nFields < 2
+	    || Field[0].empty ()
+	    || Field[1].empty ())
+	{
+		return false;
+	}
+
+	pRoute->In = Field[0];
+	pRoute->Out = Field[1];
+
+	pRoute->nChannel = 0;
+	if (!Field[2].empty ())
+	{
+		char *pEnd;
+		unsigned long ulChannel = strtoul (Field[2].c_str (), &pEnd, 10);
+		if (   *pEnd != '\0'
+		    || ulChannel > 16)
+		{
+			return false;
+		}
+
+		pRoute->nChannel = ulChannel;
+	}
+
+	pRoute->nMessageMask = MIDIMessageAll;
+	if (!Field[3].empty ())
+	{
+		pRoute->nMessageMask = 0;
+
+		nStart = 0;
+		while (true)
+		{
+			size_t nPos = Field[3].find ('+', nStart);
+			std::string Name = Field[3].substr (nStart, nPos == std::string::npos ? nPos : nPos - nStart);
+
+			unsigned i;
+			for (i = 0; i < sizeof MessageClass / sizeof MessageClass[0]; i++)
+			{
+				if (Name == MessageClass[i].pName)
+				{
+					pRoute->nMessageMask |= MessageClass[i].nMask;
+					break;
+				}
+			}
+
+			if (i == sizeof MessageClass / sizeof MessageClass[0])
+			{
+				return false;
+			}
+
+			if (nPos == std::string::npos)
+			{
+				break;
+			}
+
+			nStart = nPos+1;
+		}
+	}
+
+	return true;
+}
+
 unsigned CConfig::GetToneGenerators (void) const
 {
 	return m_nToneGenerators;
@@ -272,36 +398,14 @@ unsigned CConfig::GetPolyphony (void) const
 	return m_nPolyphony;
 }
 
-unsigned CConfig::GetTGsCore1 (void) const
+bool CConfig::GetVoicePool (void) const
 {
-#ifndef ARM_ALLOW_MULTI_CORE
-	return 0;
-#else
-	if (m_nToneGenerators > MinToneGenerators)
-	{
-		return TGsCore1 + TGsCore1Opt;
-	}
-	else
-	{
-		return TGsCore1;
-	}
-#endif
+	return m_bVoicePool;
 }
 
-unsigned CConfig::GetTGsCore23 (void) const
+unsigned CConfig::GetVoicePoolLoad (void) const
 {
-#ifndef ARM_ALLOW_MULTI_CORE
-	return 0;
-#else
-	if (m_nToneGenerators > MinToneGenerators)
-	{
-		return TGsCore23 + TGsCore23Opt;
-	}
-	else
-	{
-		return TGsCore23;
-	}
-#endif
+	return m_nVoicePoolLoad;
 }
 
 bool CConfig::GetUSBGadget (void) const
@@ -359,39 +463,65 @@ bool CConfig::GetQuadDAC8Chan (void) const
 	return m_bQuadDAC8Chan;
 }
 
-unsigned CConfig::GetMIDIBaudRate (void) const
+unsigned CConfig::GetAudioPipelineDepth (void) const
 {
-	return m_nMIDIBaudRate;
+	return m_nAudioPipelineDepth;
+}
+
+bool CConfig::GetAudioCoreSleep (void) const
+{
+	return m_bAudioCoreSleep;
+}
+
+bool CConfig::GetMIDIEventTiming (void) const
+{
+	return m_bMIDIEventTiming;
+}
+
+bool CConfig::GetLoadGovernor (void) const
+{
+	return m_bLoadGovernor;
+}
+
+unsigned CConfig::GetLoadGovernorHigh (void) const
+{
+	return m_nLoadGovernorHigh;
+}
+
+unsigned CConfig::GetLoadGovernorLow (void) const
+{
+	return m_nLoadGovernorLow;
 }
 
-const char *CConfig::GetMIDIThruIn (void) const
+unsigned CConfig::GetLoadGovernorHold (void) const
 {
-	return m_MIDIThruIn.c_str ();
+	return m_nLoadGovernorHold;
 }
 
-const char *CConfig::GetMIDIThruOut (void) const
+unsigned CConfig::GetLoadGovernorVoiceLimit (void) const
 {
-	return m_MIDIThruOut.c_str ();
+	return m_nLoadGovernorVoiceLimit;
 }
 
-const char *CConfig::GetMIDIThru2In (void) const
+bool CConfig::GetLoadGovernorReverbOff (void) const
 {
-	return m_MIDIThru2In.c_str ();
+	return m_bLoadGovernorReverbOff;
 }
 
-const char *CConfig::GetMIDIThru2Out (void) const
+unsigned CConfig::GetMIDIBaudRate (void) const
 {
-	return m_MIDIThru2Out.c_str ();
+	return m_nMIDIBaudRate;
 }
 
-bool CConfig::GetMIDIThruIgnoreClock (void) const
+unsigned CConfig::GetMIDIRoutes (void) const
 {
-	return m_bMIDIThruIgnoreClock;
+	return m_nMIDIRoutes;
 }
 
-bool CConfig::GetMIDIThruIgnoreActiveSensing (void) const
+const CConfig::TMIDIRoute *CConfig::GetMIDIRoute (unsigned nRoute) const
 {
-	return m_bMIDIThruIgnoreActiveSensing;
+	assert (nRoute < m_nMIDIRoutes);
+	return &m_MIDIRoute[nRoute];
 }
 
 bool CConfig::GetMIDIRXProgramChange (void) const
@@ -798,6 +928,11 @@ bool CConfig::GetProfileEnabled (void) const
 	return m_bProfileEnabled;
 }
 
+unsigned CConfig::GetProfileWindow (void) const
+{
+	return m_nProfileWindow;
+}
+
 bool CConfig::GetPerformanceSelectToLoad (void) const
 {
 	return m_bPerformanceSelectToLoad;
@@ -37,7 +37,8 @@ class CConfig		// Configuration for MiniDexed
 {
 public:
 // Set maximum, minimum and default numbers of tone generators, depending on Pi version.
-// Actual number in can be changed via config settings for some Pis.
+// Actual number can be changed via config settings up to the maximum. The per-TG arrays
+// are sized for the maximum, the TGs are handed to the audio cores by the render scheduler.
 #ifndef ARM_ALLOW_MULTI_CORE
 	// Pi V1 or Zero (single core)
 	static const unsigned MinToneGenerators = 1;
@@ -46,23 +47,14 @@ public:
 #else
 #if (RASPPI==4 || RASPPI==5)
 	// Pi 4 and 5 quad core
-	// These are max values, default is to support 8 in total with optional 16 TGs
-	static const unsigned TGsCore1 = 2;		// process 2 TGs on core 1
-	static const unsigned TGsCore23 = 3;		// process 3 TGs on core 2 and 3 each
-	static const unsigned TGsCore1Opt = 2;		// process optional additional 2 TGs on core 1
-	static const unsigned TGsCore23Opt = 3;		// process optional additional 3 TGs on core 2 and 3 each
-	static const unsigned MinToneGenerators = TGsCore1 + 2*TGsCore23;
-	static const unsigned AllToneGenerators = TGsCore1 + TGsCore1Opt + 2*TGsCore23 + 2*TGsCore23Opt;
-	static const unsigned DefToneGenerators = MinToneGenerators;
+	static const unsigned MinToneGenerators = 1;
+	static const unsigned AllToneGenerators = 32;
+	static const unsigned DefToneGenerators = 8;
 #else
 	// Pi 2 or 3 quad core
-	static const unsigned TGsCore1 = 2;		// process 2 TGs on core 1
-	static const unsigned TGsCore23 = 3;		// process 3 TGs on core 2 and 3 each
-	static const unsigned TGsCore1Opt = 0;
-	static const unsigned TGsCore23Opt = 0;
-	static const unsigned MinToneGenerators = TGsCore1 + 2*TGsCore23;
-	static const unsigned AllToneGenerators = MinToneGenerators;
-	static const unsigned DefToneGenerators = AllToneGenerators;
+	static const unsigned MinToneGenerators = 1;
+	static const unsigned AllToneGenerators = 16;
+	static const unsigned DefToneGenerators = 8;
 #endif
 #endif
 	
@@ -82,6 +74,8 @@ public:
 #endif
 
 	static const unsigned MaxChunkSize = 4096;
+	static const unsigned MaxAudioPipelineDepth = 2;	// render next chunk while mixing the current one
+	static const unsigned MaxProfileWindow = 60;		// seconds
 
 #if RASPPI <= 3
 	static const unsigned MaxUSBMIDIDevices = 2;
@@ -89,6 +83,31 @@ public:
 	static const unsigned MaxUSBMIDIDevices = 4;
 #endif
 
+	static const unsigned MaxMIDIRoutes = 8;		// MIDIThru, MIDIThru2 .. MIDIThru8
+
+	// classes of MIDI messages, which can be selected for a MIDI Thru route
+	enum TMIDIMessageClass
+	{
+		MIDIMessageNotes		= 1 << 0,	// note on/off, polyphonic aftertouch
+		MIDIMessageControl		= 1 << 1,
+		MIDIMessageProgram		= 1 << 2,
+		MIDIMessageAftertouch		= 1 << 3,	// channel aftertouch
+		MIDIMessagePitchBend		= 1 << 4,
+		MIDIMessageSysEx		= 1 << 5,
+		MIDIMessageClock		= 1 << 6,
+		MIDIMessageActiveSensing	= 1 << 7,
+		MIDIMessageSystem		= 1 << 8,	// other system common and real-time messages
+		MIDIMessageAll			= (1 << 9) - 1
+	};
+
+	struct TMIDIRoute
+	{
+		std::string In;				// device names
+		std::string Out;
+		unsigned nChannel;			// 1 .. 16, 0 for all channels
+		unsigned nMessageMask;			// TMIDIMessageClass bits
+	};
+
 	// TODO - Leave this for uimenu.cpp for now, but it will need to be dynamic at some point...
 	static const unsigned LCDColumns = 16;		// HD44780 LCD
 	static const unsigned LCDRows = 2;
@@ -102,8 +121,8 @@ public:
 	// TGs and Polyphony
 	unsigned GetToneGenerators (void) const;
 	unsigned GetPolyphony (void) const;
-	unsigned GetTGsCore1 (void) const;
-	unsigned GetTGsCore23 (void) const;
+	bool GetVoicePool (void) const;			// voices are shared between the TGs
+	unsigned GetVoicePoolLoad (void) const;		// target load in percent, 10 .. 95
 	
 	// USB Mode
 	bool GetUSBGadget (void) const;
@@ -119,15 +138,20 @@ public:
 	bool GetChannelsSwapped (void) const;
 	unsigned GetEngineType (void) const;
 	bool GetQuadDAC8Chan (void) const; // false if not specified
+	unsigned GetAudioPipelineDepth (void) const;	// 1 .. MaxAudioPipelineDepth
+	bool GetAudioCoreSleep (void) const;		// idle audio cores wait with WFE
+	bool GetMIDIEventTiming (void) const;		// apply MIDI events at their arrival time
+	bool GetLoadGovernor (void) const;
+	unsigned GetLoadGovernorHigh (void) const;	// load in percent of the chunk duration
+	unsigned GetLoadGovernorLow (void) const;	// load in percent, below high
+	unsigned GetLoadGovernorHold (void) const;	// milliseconds
+	unsigned GetLoadGovernorVoiceLimit (void) const; // percent of the polyphony
+	bool GetLoadGovernorReverbOff (void) const;
 
 	// MIDI
 	unsigned GetMIDIBaudRate (void) const;
-	const char *GetMIDIThruIn (void) const;	// "" if not specified
-	const char *GetMIDIThruOut (void) const;	// "" if not specified
-	const char *GetMIDIThru2In (void) const;	// "" if not specified
-	const char *GetMIDIThru2Out (void) const;	// "" if not specified
-	bool GetMIDIThruIgnoreClock (void) const;		// false if not specified
-	bool GetMIDIThruIgnoreActiveSensing (void) const;		// false if not specified
+	unsigned GetMIDIRoutes (void) const;		// number of valid MIDI Thru routes
+	const TMIDIRoute *GetMIDIRoute (unsigned nRoute) const;
 	bool GetMIDIRXProgramChange (void) const;	// true if not specified
 	bool GetIgnoreAllNotesOff (void) const;
 	bool GetMIDIAutoVoiceDumpOnPC (void) const; // false if not specified
@@ -240,6 +264,7 @@ public:
 	// Debug
 	bool GetMIDIDumpEnabled (void) const;
 	bool GetProfileEnabled (void) const;
+	unsigned GetProfileWindow (void) const;		// seconds, 0 for since start
 	
 	// Load performance mode. 0 for load just rotating encoder, 1 load just when Select is pushed
 	bool GetPerformanceSelectToLoad (void) const;
@@ -262,11 +287,16 @@ public:
 	bool GetUDPMIDIEnabled (void) const;
 	const CIPAddress& GetUDPMIDIIPAddress (void) const;
 
+private:
+	static bool ParseMIDIRoute (const char *pString, TMIDIRoute *pRoute);
+
 private:
 	CPropertiesFatFsFile m_Properties;
 	
 	unsigned m_nToneGenerators;
 	unsigned m_nPolyphony;
+	bool m_bVoicePool;
+	unsigned m_nVoicePoolLoad;
 	
 	bool m_bUSBGadget;
 	unsigned m_nUSBGadgetPin;
@@ -279,14 +309,19 @@ private:
 	bool m_bChannelsSwapped;
 	unsigned m_EngineType;
 	bool m_bQuadDAC8Chan;
+	unsigned m_nAudioPipelineDepth;
+	bool m_bAudioCoreSleep;
+	bool m_bMIDIEventTiming;
+	bool m_bLoadGovernor;
+	unsigned m_nLoadGovernorHigh;
+	unsigned m_nLoadGovernorLow;
+	unsigned m_nLoadGovernorHold;
+	unsigned m_nLoadGovernorVoiceLimit;
+	bool m_bLoadGovernorReverbOff;
 
 	unsigned m_nMIDIBaudRate;
-	std::string m_MIDIThruIn;
-	std::string m_MIDIThruOut;
-	std::string m_MIDIThru2In;
-	std::string m_MIDIThru2Out;
-	bool m_bMIDIThruIgnoreClock;
-	bool m_bMIDIThruIgnoreActiveSensing;
+	TMIDIRoute m_MIDIRoute[MaxMIDIRoutes];
+	unsigned m_nMIDIRoutes;
 	bool m_bMIDIRXProgramChange;
 	bool m_bIgnoreAllNotesOff;
 	bool m_bMIDIAutoVoiceDumpOnPC;
@@ -379,6 +414,7 @@ private:
 
 	bool m_bMIDIDumpEnabled;
 	bool m_bProfileEnabled;
+	unsigned m_nProfileWindow;
 	bool m_bPerformanceSelectToLoad;
 	unsigned m_bPerformanceSelectChannel;
 
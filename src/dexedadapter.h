@@ -23,65 +23,673 @@
 
 #include <synth_dexed.h>
 #include <circle/spinlock.h>
+#include <circle/timer.h>
 #include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <atomic>
+#include "spscring.h"
+#include "trace.h"
 
 #define DEXED_OP_ENABLE (DEXED_OP_OSC_DETUNE + 1)
 
 // Some Dexed methods require to be guarded from being interrupted
 // by other Dexed calls. This is done herein.
+//
+// Note events, pedals, controllers and voice loads are not applied
+// directly, but are put into a lock-free event queue, which is processed
+// by the core rendering this TG in getSamples(). So rendering never waits
+// for MIDI processing and the events are applied in their order. The data
+// of a voice is passed in a separate queue. Until it has been applied, the
+// voice data is read from the copy, which has been queued last.
+//
+// Events are timestamped on arrival. If getSamples() is given the time
+// window, in which the events for this chunk have arrived, each event is
+// applied at its position in the chunk (with a granularity of one Dexed
+// block), which delays events by one chunk, but without jitter. This is
+// enabled with MIDIEventTiming=1 in minidexed.ini.
+//
+// The number of playing voices is sampled after each block by the core
+// rendering this TG, so it can be read from other cores without walking
+// the Dexed voices. For the voice pool, a voice is stolen by cutting the
+// quietest voice in its release phase or, if there is none, by releasing
+// the oldest held note. Under overload, the quietest voice in its release
+// phase can be cut and the number of voices can be limited below the
+// polyphony.
 
 class CDexedAdapter : public Dexed
 {
 public:
 	CDexedAdapter (uint8_t maxnotes, int rate)
-	: Dexed (maxnotes, rate)
+	: Dexed (maxnotes, rate),
+	  m_nVoiceLoads (0),
+	  m_nVoiceLoadsApplied (0),
+	  m_nKeyDowns (0),
+	  m_nKeyDownsApplied (0),
+	  m_nVoices (0),
+	  m_nHeldNotes (0),
+	  m_nCutRequests (0),
+	  m_nVoiceLimit (0),
+	  m_bSilent (true)
 	{
 	}
 
 	void loadVoiceParameters (uint8_t* data)
 	{
-		m_SpinLock.Acquire ();
-		Dexed::loadVoiceParameters (data);
-		m_SpinLock.Release ();
+		TEvent Event = {EventLoadVoice, 0, 0, CTimer::GetClockTicks ()};
+
+		m_EventSpinLock.Acquire ();
+
+		memcpy (m_LastVoice.Data, data, VoiceDataSize);
+		m_nVoiceLoads.fetch_add (1, std::memory_order_release);
+
+		if (m_Voices.Put (m_LastVoice))
+		{
+			PutEventLocked (Event);
+		}
+		else
+		{
+			m_SpinLock.Acquire ();
+			ProcessEvents ();
+			ApplyVoice (m_LastVoice);
+			m_SpinLock.Release ();
+		}
+
+		m_EventSpinLock.Release ();
+	}
+
+	// The voice data getters return the voice, which has been loaded last,
+	// even if it has not been applied yet.
+	void getName (char *buffer)
+	{
+		if (IsVoicePending ())
+		{
+			memcpy (buffer, &m_LastVoice.Data[VoiceNameOffset], VoiceNameLength);
+			buffer[VoiceNameLength] = '\0';
+		}
+		else
+		{
+			Dexed::getName (buffer);
+		}
+	}
+
+	void getVoiceData (uint8_t *data_copy)
+	{
+		bool bPending = IsVoicePending ();
+		Dexed::getVoiceData (data_copy);
+		if (bPending)
+		{
+			memcpy (data_copy, m_LastVoice.Data, VoiceDataSize);
+		}
+	}
+
+	uint8_t getVoiceDataElement (uint8_t address)
+	{
+		if (   address < VoiceDataSize
+		    && IsVoicePending ())
+		{
+			return m_LastVoice.Data[address];
+		}
+
+		return Dexed::getVoiceDataElement (address);
+	}
+
+	// a pending voice load is applied first, so that the change is not lost
+	void setVoiceDataElement (uint8_t address, uint8_t value)
+	{
+		if (IsVoicePending ())
+		{
+			m_EventSpinLock.Acquire ();
+			m_SpinLock.Acquire ();
+			ProcessEvents ();
+			m_SpinLock.Release ();
+			m_EventSpinLock.Release ();
+		}
+
+		Dexed::setVoiceDataElement (address, value);
 	}
 
 	void keyup (int16_t pitch)
 	{
-		m_SpinLock.Acquire ();
-		Dexed::keyup (pitch);
-		m_SpinLock.Release ();
+		TRACE (TraceKeyUp, pitch);
+		TEvent Event = {EventKeyUp, pitch, 0, CTimer::GetClockTicks ()};
+		PutEvent (Event);
 	}
 
 	void keydown (int16_t pitch, uint8_t velo)
 	{
-		m_SpinLock.Acquire ();
-		Dexed::keydown (pitch, velo);
-		m_SpinLock.Release ();
+		TRACE (TraceKeyDown, pitch);
+		TEvent Event = {EventKeyDown, pitch, velo, CTimer::GetClockTicks ()};
+		m_nKeyDowns.fetch_add (1, std::memory_order_relaxed);
+		PutEvent (Event);
+	}
+
+	// cuts the quietest voice, whose key has been released, or releases
+	// the oldest held note, if there is none, even if the key is still down
+	void stealVoice (void)
+	{
+		TEvent Event = {EventStealVoice, 0, 0, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	// voices playing after the last block (including released notes, which
+	// are still sounding) and key downs, which have not been applied yet
+	unsigned getVoices (void) const
+	{
+		unsigned nPending =   m_nKeyDowns.load (std::memory_order_relaxed)
+				    - m_nKeyDownsApplied.load (std::memory_order_relaxed);
+
+		return m_nVoices + nPending;
+	}
+
+	unsigned getVoicesPlaying (void) const
+	{
+		return m_nVoices;
 	}
 
+	// cuts the quietest voice, whose key has been released and which is no
+	// longer audible, if any, before the next block is rendered (lock-free,
+	// does not use the event queue)
+	void cutReleasingVoice (void)
+	{
+		m_nCutRequests.fetch_add (1, std::memory_order_relaxed);
+	}
+
+	// a new note frees a voice first, if this number of voices is playing
+	// (0 for the polyphony)
+	void setVoiceLimit (unsigned nVoices)
+	{
+		m_nVoiceLimit.store (nVoices, std::memory_order_relaxed);
+	}
+
+	// apply all pending events at the start of the block
 	void getSamples (float32_t* buffer, uint16_t n_samples)
 	{
 		m_SpinLock.Acquire ();
+		ProcessCutRequests ();
+		ProcessEvents ();
 		Dexed::getSamples (buffer, n_samples);
+		UpdateSilent (buffer, n_samples);
 		m_SpinLock.Release ();
 	}
 
-	void ControllersRefresh (void)
+	// apply the events, which arrived in the window [nWindowStart, nWindowEnd)
+	// (in clock ticks), at their relative position in the block, later events
+	// remain queued
+	void getSamples (float32_t* buffer, uint16_t n_samples, unsigned nWindowStart, unsigned nWindowEnd)
 	{
+		unsigned nWindow = nWindowEnd - nWindowStart;
+
 		m_SpinLock.Acquire ();
-		Dexed::ControllersRefresh ();
+
+		ProcessCutRequests ();
+
+		unsigned nOffset = 0;
+		while (nOffset < n_samples)
+		{
+			unsigned nNextOffset = n_samples;
+
+			const TEvent *pEvent;
+			while ((pEvent = m_Events.Peek ()) != nullptr)
+			{
+				int nDelay = (int) (pEvent->nTimestamp - nWindowStart);
+				if (nDelay >= (int) nWindow)
+				{
+					break;				// for the next block
+				}
+
+				unsigned nEventOffset = 0;
+				if (nDelay > 0)
+				{
+					nEventOffset = (uint64_t) nDelay * n_samples / nWindow;
+					nEventOffset &= ~(EventGranularity-1);
+				}
+
+				if (nEventOffset > nOffset)
+				{
+					nNextOffset = nEventOffset;
+
+					break;
+				}
+
+				ProcessEvent (*pEvent);
+				m_Events.Remove ();
+			}
+
+			Dexed::getSamples (buffer + nOffset, nNextOffset - nOffset);
+			nOffset = nNextOffset;
+		}
+
+		UpdateSilent (buffer, n_samples);
+
 		m_SpinLock.Release ();
 	}
 
+	// true, if the TG does not produce any output until the next keydown()
+	bool isSilent (void) const
+	{
+		return m_bSilent && m_Events.IsEmpty ();
+	}
+
+	void ControllersRefresh (void)
+	{
+		TEvent Event = {EventControllersRefresh, 0, 0, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
 	void setSustain (bool sustain)
 	{
-		m_SpinLock.Acquire ();
-		Dexed::setSustain (sustain);
-		m_SpinLock.Release ();
+		TEvent Event = {EventSustain, 0, sustain, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	void setSostenuto (bool sostenuto)
+	{
+		TEvent Event = {EventSostenuto, 0, sostenuto, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	void setHold (bool hold)
+	{
+		TEvent Event = {EventHold, 0, hold, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	void panic (void)
+	{
+		TEvent Event = {EventPanic, 0, 0, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	void notesOff (void)
+	{
+		TEvent Event = {EventNotesOff, 0, 0, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	void setPitchbend (int16_t value)
+	{
+		TEvent Event = {EventPitchbend, value, 0, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	void setModWheel (uint8_t value)
+	{
+		TEvent Event = {EventModWheel, 0, value, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	void setBreathController (uint8_t value)
+	{
+		TEvent Event = {EventBreathController, 0, value, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	void setFootController (uint8_t value)
+	{
+		TEvent Event = {EventFootController, 0, value, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+	void setAftertouch (uint8_t value)
+	{
+		TEvent Event = {EventAftertouch, 0, value, CTimer::GetClockTicks ()};
+		PutEvent (Event);
+	}
+
+private:
+	enum TEventType : uint8_t
+	{
+		EventKeyDown,
+		EventKeyUp,
+		EventSustain,
+		EventSostenuto,
+		EventHold,
+		EventPanic,
+		EventNotesOff,
+		EventControllersRefresh,
+		EventStealVoice,
+		EventPitchbend,
+		EventModWheel,
+		EventBreathController,
+		EventFootController,
+		EventAftertouch,
+		EventLoadVoice			// the data is the next one in m_Voices
+	};
+
+	struct TEvent
+	{
+		TEventType Type;
+		int16_t nPitch;			// or the pitch bend value
+		uint8_t nValue;			// velocity, pedal state or controller value
+		unsigned nTimestamp;		// arrival time in clock ticks
+	};
+
+	static const unsigned EventQueueSize = 256;	// must be a power of 2
+	static const unsigned EventGranularity = 64;	// Dexed renders in blocks of 64 samples
+
+	static const unsigned VoiceDataSize = 155;
+	static const unsigned VoiceNameOffset = 145;
+	static const unsigned VoiceNameLength = 10;
+	static const unsigned VoiceQueueSize = 4;	// must be a power of 2
+
+	struct TVoice
+	{
+		uint8_t Data[VoiceDataSize];
+	};
+
+	void PutEvent (const TEvent &rEvent)
+	{
+		m_EventSpinLock.Acquire ();
+		PutEventLocked (rEvent);
+		m_EventSpinLock.Release ();
+	}
+
+	// m_EventSpinLock must be held
+	void PutEventLocked (const TEvent &rEvent)
+	{
+		if (!m_Events.Put (rEvent))
+		{
+			// The queue is full (the TG has not been rendered for a while),
+			// process it here to keep the order of events.
+			m_SpinLock.Acquire ();
+			ProcessEvents ();
+			ProcessEvent (rEvent);
+			m_SpinLock.Release ();
+		}
+	}
+
+	bool IsVoicePending (void) const
+	{
+		return    m_nVoiceLoads.load (std::memory_order_relaxed)
+		       != m_nVoiceLoadsApplied.load (std::memory_order_acquire);
+	}
+
+	// Loading a voice stops all voices of the TG. m_SpinLock must be held
+	void ApplyVoice (const TVoice &rVoice)
+	{
+		Dexed::loadVoiceParameters (const_cast<uint8_t *> (rVoice.Data));
+		m_nHeldNotes = 0;
+		m_nVoiceLoadsApplied.fetch_add (1, std::memory_order_release);
+	}
+
+	// The TG becomes silent, when the output has decayed below one LSB
+	// of the 24-bit output and no voice is playing any more.
+	// m_SpinLock must be held
+	void UpdateSilent (const float32_t* buffer, uint16_t n_samples)
+	{
+		float32_t fMax, fMin;
+		uint32_t nIndex;
+		arm_max_f32 (buffer, n_samples, &fMax, &nIndex);
+		arm_min_f32 (buffer, n_samples, &fMin, &nIndex);
+		m_nVoices = Dexed::getNumNotesPlaying ();
+		m_bSilent =    fMax < SilenceThreshold
+			    && fMin > -SilenceThreshold
+			    && m_nVoices == 0;
+	}
+
+	// The voice fades out with its release, a sustained note is not
+	// released before the pedal. m_SpinLock must be held
+	void ReleaseOldestNote (void)
+	{
+		if (m_nHeldNotes > 0)
+		{
+			int16_t pitch = m_HeldNote[0];
+			RemoveHeldNote (pitch);
+			Dexed::keyup (pitch);
+		}
+	}
+
+	// The level of a voice is estimated from the highest operator amplitude,
+	// which is not below the amplitude of the carriers. Only a voice quieter
+	// than nMaxAmp is cut. m_SpinLock must be held
+	bool CutReleasingVoice (uint32_t nMaxAmp = UINT32_MAX)
+	{
+		int nQuietest = -1;
+		uint32_t nQuietestAmp = 0;
+		for (unsigned i = 0; i < max_notes; i++)
+		{
+			if (   !voices[i].live
+			    || voices[i].keydown
+			    || voices[i].sustained)
+			{
+				continue;
+			}
+
+			VoiceStatus Status;
+			voices[i].dx7_note->peekVoiceStatus (Status);
+
+			uint32_t nAmp = 0;
+			for (unsigned op = 0; op < 6; op++)
+			{
+				if (Status.amp[op] > nAmp)
+				{
+					nAmp = Status.amp[op];
+				}
+			}
+
+			if (   nQuietest < 0
+			    || nAmp < nQuietestAmp)
+			{
+				nQuietest = i;
+				nQuietestAmp = nAmp;
+			}
+		}
+
+		if (   nQuietest < 0
+		    || nQuietestAmp >= nMaxAmp)
+		{
+			return false;
+		}
+
+		voices[nQuietest].live = false;
+		if (m_nVoices > 0)
+		{
+			m_nVoices--;		// until the next block has been rendered
+		}
+
+		return true;
+	}
+
+	// m_SpinLock must be held
+	void ProcessCutRequests (void)
+	{
+		unsigned nCuts = m_nCutRequests.exchange (0, std::memory_order_relaxed);
+		for (; nCuts > 0; nCuts--)
+		{
+			if (!CutReleasingVoice (CutThreshold))
+			{
+				break;
+			}
+		}
+	}
+
+	// m_SpinLock must be held
+	void StealVoice (void)
+	{
+		if (!CutReleasingVoice ())
+		{
+			ReleaseOldestNote ();
+		}
+	}
+
+	// frees a voice for a new note, if the voice limit has been reached.
+	// m_SpinLock must be held
+	void LimitVoices (void)
+	{
+		unsigned nVoices = m_nVoiceLimit.load (std::memory_order_relaxed);
+		if (!nVoices--)
+		{
+			return;
+		}
+
+		unsigned nLive = 0;
+		for (unsigned i = 0; i < max_notes; i++)
+		{
+			if (voices[i].live)
+			{
+				nLive++;
+			}
+		}
+
+		for (; nLive > nVoices; nLive--)
+		{
+			if (!CutReleasingVoice ())
+			{
+				ReleaseOldestNote ();
+
+				break;
+			}
+		}
+	}
+
+	// m_SpinLock must be held
+	void AddHeldNote (int16_t pitch)
+	{
+		RemoveHeldNote (pitch);
+
+		if (m_nHeldNotes == MaxHeldNotes)
+		{
+			RemoveHeldNote (m_HeldNote[0]);
+		}
+
+		m_HeldNote[m_nHeldNotes++] = pitch;
+	}
+
+	// m_SpinLock must be held
+	void RemoveHeldNote (int16_t pitch)
+	{
+		for (unsigned i = 0; i < m_nHeldNotes; i++)
+		{
+			if (m_HeldNote[i] == pitch)
+			{
+				for (m_nHeldNotes--; i < m_nHeldNotes; i++)
+				{
+					m_HeldNote[i] = m_HeldNote[i+1];
+				}
+
+				break;
+			}
+		}
+	}
+
+	// m_SpinLock must be held
+	void ProcessEvents (void)
+	{
+		TEvent Event;
+		while (m_Events.Get (&Event))
+		{
+			ProcessEvent (Event);
+		}
+	}
+
+	void ProcessEvent (const TEvent &rEvent)
+	{
+		TRACE (TraceEventApplied, rEvent.Type | (rEvent.nPitch & 0xFF) << 8);
+
+		switch (rEvent.Type)
+		{
+		case EventKeyDown:
+			LimitVoices ();
+			Dexed::keydown (rEvent.nPitch, rEvent.nValue);
+			AddHeldNote (rEvent.nPitch);
+			m_nKeyDownsApplied.fetch_add (1, std::memory_order_relaxed);
+			break;
+
+		case EventKeyUp:
+			Dexed::keyup (rEvent.nPitch);
+			RemoveHeldNote (rEvent.nPitch);
+			break;
+
+		case EventSustain:
+			Dexed::setSustain (!!rEvent.nValue);
+			break;
+
+		case EventSostenuto:
+			Dexed::setSostenuto (!!rEvent.nValue);
+			break;
+
+		case EventHold:
+			Dexed::setHold (!!rEvent.nValue);
+			break;
+
+		case EventPanic:
+			Dexed::panic ();
+			m_nHeldNotes = 0;
+			break;
+
+		case EventNotesOff:
+			Dexed::notesOff ();
+			m_nHeldNotes = 0;
+			break;
+
+		case EventControllersRefresh:
+			Dexed::ControllersRefresh ();
+			break;
+
+		case EventStealVoice:
+			StealVoice ();
+			break;
+
+		case EventPitchbend:
+			Dexed::setPitchbend (rEvent.nPitch);
+			break;
+
+		case EventModWheel:
+			Dexed::setModWheel (rEvent.nValue);
+			break;
+
+		case EventBreathController:
+			Dexed::setBreathController (rEvent.nValue);
+			break;
+
+		case EventFootController:
+			Dexed::setFootController (rEvent.nValue);
+			break;
+
+		case EventAftertouch:
+			Dexed::setAftertouch (rEvent.nValue);
+			break;
+
+		case EventLoadVoice:
+			assert (m_Voices.Peek ());
+			ApplyVoice (*m_Voices.Peek ());
+			m_Voices.Remove ();
+			break;
+		}
 	}
 
 private:
+	static constexpr float32_t SilenceThreshold = 1.0f / (1 << 23);
+
+	// Cutting a voice, which is 60 dB below full scale (operator amplitudes
+	// are Q24), does not click. A stolen voice is cut at any level.
+	static const uint32_t CutThreshold = (1 << 24) >> 10;
+
 	CSpinLock m_SpinLock;
+
+	// Serializes the producers (MIDI devices, UI). The queue is consumed
+	// with m_SpinLock held, which is not taken by the producers normally.
+	CSpinLock m_EventSpinLock;
+	CSPSCRing<TEvent, EventQueueSize> m_Events;
+	CSPSCRing<TVoice, VoiceQueueSize> m_Voices;
+	TVoice m_LastVoice;				// put into m_Voices last
+	std::atomic<unsigned> m_nVoiceLoads;		// queued
+	std::atomic<unsigned> m_nVoiceLoadsApplied;
+
+	std::atomic<unsigned> m_nKeyDowns;		// queued
+	std::atomic<unsigned> m_nKeyDownsApplied;
+	volatile unsigned m_nVoices;			// playing after the last block
+
+	static const unsigned MaxHeldNotes = 128;
+	int16_t m_HeldNote[MaxHeldNotes];		// oldest first
+	unsigned m_nHeldNotes;
+
+	// set by the load governor on the audio core, without locking
+	std::atomic<unsigned> m_nCutRequests;
+	std::atomic<unsigned> m_nVoiceLimit;
+
+	volatile bool m_bSilent;
 };
 
 #endif
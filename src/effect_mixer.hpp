@@ -92,6 +92,7 @@ public:
 		{
 			panorama[i][0] = UNITY_PANORAMA;
 			panorama[i][1] = UNITY_PANORAMA;
+			update_coeff(i);
 		}
 
 		sumbufR=new float32_t[buffer_length];
@@ -115,20 +116,88 @@ public:
 		// From: https://stackoverflow.com/questions/67062207/how-to-pan-audio-sample-data-naturally
 		panorama[channel][0]=arm_sin_f32(mapfloat(pan, MIN_PANORAMA, MAX_PANORAMA, 0.0, M_PI/2.0));
 		panorama[channel][1]=arm_cos_f32(mapfloat(pan, MIN_PANORAMA, MAX_PANORAMA, 0.0, M_PI/2.0));
+		update_coeff(channel);
 	}
 
-	void doAddMix(uint8_t channel, float32_t* in)
+	void gain(uint8_t channel, float32_t gain)
 	{
-		float32_t tmp[buffer_length];
+		if (channel >= NN) return;
+
+		AudioMixer<NN>::gain(channel, gain);
+		update_coeff(channel);
+	}
+
+	void gain(float32_t gain)
+	{
+		AudioMixer<NN>::gain(gain);
+		for (uint8_t i = 0; i < NN; i++)
+			update_coeff(i);
+	}
 
+	void doAddMix(uint8_t channel, float32_t* in)
+	{
 		assert(in);
 
-		// left
-		arm_scale_f32(in, panorama[channel][0] * multiplier[channel], tmp, buffer_length);
-		arm_add_f32(sumbufL, tmp, sumbufL, buffer_length);
-		// right
-		arm_scale_f32(in, panorama[channel][1] * multiplier[channel], tmp, buffer_length);
-		arm_add_f32(sumbufR, tmp, sumbufR, buffer_length);
+		const float32_t cl = coeff[channel][0];
+		const float32_t cr = coeff[channel][1];
+		float32_t* outL = sumbufL;
+		float32_t* outR = sumbufR;
+		uint16_t n = buffer_length;
+
+#if defined(ARM_MATH_NEON)
+		for (; n >= 4; n -= 4)
+		{
+			float32x4_t x = vld1q_f32(in);
+			vst1q_f32(outL, vmlaq_n_f32(vld1q_f32(outL), x, cl));
+			vst1q_f32(outR, vmlaq_n_f32(vld1q_f32(outR), x, cr));
+			in += 4; outL += 4; outR += 4;
+		}
+#endif
+		while (n--)
+		{
+			float32_t x = *in++;
+			*outL++ += x * cl;
+			*outR++ += x * cr;
+		}
+	}
+
+	// Adds the input to this mixer (dry bus) and to the send mixer (e.g. the
+	// reverb send) in a single pass, so that the input is read only once.
+	void doAddMixWithSend(uint8_t channel, float32_t* in, AudioStereoMixer<NN>* send)
+	{
+		assert(in);
+		assert(send);
+		assert(send->buffer_length == buffer_length);
+
+		const float32_t dl = coeff[channel][0];
+		const float32_t dr = coeff[channel][1];
+		const float32_t sl = send->coeff[channel][0];
+		const float32_t sr = send->coeff[channel][1];
+		float32_t* dryL = sumbufL;
+		float32_t* dryR = sumbufR;
+		float32_t* sendL = send->sumbufL;
+		float32_t* sendR = send->sumbufR;
+		uint16_t n = buffer_length;
+
+#if defined(ARM_MATH_NEON)
+		for (; n >= 4; n -= 4)
+		{
+			float32x4_t x = vld1q_f32(in);
+			vst1q_f32(dryL, vmlaq_n_f32(vld1q_f32(dryL), x, dl));
+			vst1q_f32(dryR, vmlaq_n_f32(vld1q_f32(dryR), x, dr));
+			vst1q_f32(sendL, vmlaq_n_f32(vld1q_f32(sendL), x, sl));
+			vst1q_f32(sendR, vmlaq_n_f32(vld1q_f32(sendR), x, sr));
+			in += 4; dryL += 4; dryR += 4; sendL += 4; sendR += 4;
+		}
+#endif
+		while (n--)
+		{
+			float32_t x = *in++;
+			*dryL++ += x * dl;
+			*dryR++ += x * dr;
+			*sendL++ += x * sl;
+			*sendR++ += x * sr;
+		}
 	}
 
 	void getMix(float32_t* bufferL, float32_t* bufferR)
@@ -162,10 +231,17 @@ public:
 	}
 
 protected:
+	void update_coeff(uint8_t channel)
+	{
+		coeff[channel][0] = panorama[channel][0] * multiplier[channel];
+		coeff[channel][1] = panorama[channel][1] * multiplier[channel];
+	}
+
 	using AudioMixer<NN>::sumbufL;
 	using AudioMixer<NN>::multiplier;
 	using AudioMixer<NN>::buffer_length;
 	float32_t panorama[NN][2];
+	float32_t coeff[NN][2];		// gain * panorama, for L and R
 	float32_t* sumbufR;
 };
 
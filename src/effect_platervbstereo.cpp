@@ -54,6 +54,10 @@
 
 #define RV_MASTER_LOWPASS_F (0.6f)                           // master lowpass scaled frequency coeff. 
 
+#define RV_SILENCE_THRESHOLD (1.0f / (1 << 23))             // peak level, below which a block is silent
+
+#define RV_BLOCK_SIZE       (64)                            // LFOs and input allpasses are computed per block of this size
+
 const int16_t AudioWaveformSine[257] = {
      0,   804,  1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,
   7962,  8739,  9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732,
@@ -85,49 +89,20 @@ const int16_t AudioWaveformSine[257] = {
 
 AudioEffectPlateReverb::AudioEffectPlateReverb(float32_t samplerate)
 {
+    static_assert((rv_buf_mask & (rv_buf_mask + 1)) == 0, "Buffer size must be a power of 2");
+    static_assert(rv_buf_mask - in_allp4_end_R >= RV_BLOCK_SIZE, "Delay lines do not fit into the buffer");
+
     input_attn = 0.5f;
     in_allp_k = INP_ALLP_COEFF;
 
-    memset(in_allp1_bufL, 0, sizeof(in_allp1_bufL));
-    memset(in_allp2_bufL, 0, sizeof(in_allp2_bufL));
-    memset(in_allp3_bufL, 0, sizeof(in_allp3_bufL));
-    memset(in_allp4_bufL, 0, sizeof(in_allp4_bufL));
-    in_allp1_idxL = 0;
-    in_allp2_idxL = 0;
-    in_allp3_idxL = 0;
-    in_allp4_idxL = 0;
-
-    memset(in_allp1_bufR, 0, sizeof(in_allp1_bufR));
-    memset(in_allp2_bufR, 0, sizeof(in_allp2_bufR));
-    memset(in_allp3_bufR, 0, sizeof(in_allp3_bufR));
-    memset(in_allp4_bufR, 0, sizeof(in_allp4_bufR));
-    in_allp1_idxR = 0;
-    in_allp2_idxR = 0;
-    in_allp3_idxR = 0;
-    in_allp4_idxR = 0;
-
-    in_allp_out_R = 0.0f;
-
-    memset(lp_allp1_buf, 0, sizeof(lp_allp1_buf));
-    memset(lp_allp2_buf, 0, sizeof(lp_allp2_buf));
-    memset(lp_allp3_buf, 0, sizeof(lp_allp3_buf));
-    memset(lp_allp4_buf, 0, sizeof(lp_allp4_buf));
-    lp_allp1_idx = 0;
-    lp_allp2_idx = 0;
-    lp_allp3_idx = 0;
-    lp_allp4_idx = 0;
+    rv_idx = 0;
+    cleanup();
+
+    silent_len = 0;
+
     loop_allp_k = LOOP_ALLOP_COEFF;
     lp_allp_out = 0.0f;
 
-    memset(lp_dly1_buf, 0, sizeof(lp_dly1_buf));
-    memset(lp_dly2_buf, 0, sizeof(lp_dly2_buf));
-    memset(lp_dly3_buf, 0, sizeof(lp_dly3_buf));
-    memset(lp_dly4_buf, 0, sizeof(lp_dly4_buf));
-    lp_dly1_idx = 0;
-    lp_dly2_idx = 0;
-    lp_dly3_idx = 0;
-    lp_dly4_idx = 0;
-
     lp_hidamp_k = 1.0f;
     lp_lodamp_k = 0.0f;
 
@@ -156,299 +131,329 @@ AudioEffectPlateReverb::AudioEffectPlateReverb(float32_t samplerate)
     reverb_level = 0.0f;
 }
 
-// #define sat16(n, rshift) signed_saturate_rshift((n), 16, (rshift))
+void AudioEffectPlateReverb::cleanup(void)
+{
+    memset(rv_buf, 0, sizeof(rv_buf));
+}
 
-void AudioEffectPlateReverb::doReverb(const float32_t* inblockL, const float32_t* inblockR, float32_t* rvbblockL, float32_t* rvbblockR, uint16_t len)
+bool AudioEffectPlateReverb::is_silent(const float32_t* blockL, const float32_t* blockR, uint16_t len)
 {
-    float32_t input, acc, temp1, temp2;
-    uint16_t temp16;
-    float32_t rv_time;
+    float32_t fMax, fMin;
+    uint32_t nIndex;
 
-    // for LFOs:
-    int16_t lfo1_out_sin, lfo1_out_cos, lfo2_out_sin, lfo2_out_cos;
+    arm_max_f32(blockL, len, &fMax, &nIndex);
+    arm_min_f32(blockL, len, &fMin, &nIndex);
+    if (fMax >= RV_SILENCE_THRESHOLD || fMin <= -RV_SILENCE_THRESHOLD)
+    {
+        return false;
+    }
+
+    arm_max_f32(blockR, len, &fMax, &nIndex);
+    arm_min_f32(blockR, len, &fMin, &nIndex);
+
+    return fMax < RV_SILENCE_THRESHOLD && fMin > -RV_SILENCE_THRESHOLD;
+}
+
+// 16 bit sine and cosine output of a LFO at the given phase
+static inline void lfo_sin_cos(uint32_t phase_acc, int16_t *lfo_sin, int16_t *lfo_cos)
+{
+    uint32_t idx;
     int32_t y0, y1;
     int64_t y;
-    uint32_t idx;
-    static bool cleanup_done = false;
+
+    idx = phase_acc >> 24;          // 8bit lookup table address
+    y0 = AudioWaveformSine[idx];
+    y1 = AudioWaveformSine[idx+1];
+    idx = phase_acc & 0x00FFFFFF;   // lower 24 bit = fractional part
+    y = (int64_t)y0 * (0x00FFFFFF - idx);
+    y += (int64_t)y1 * idx;
+    *lfo_sin = (int32_t) (y >> (32-8));
+
+    // the cosine uses the table address as fractional part, which is kept to
+    // not change the sound of the reverb
+    idx = ((phase_acc >> 24)+64) & 0xFF;
+    y0 = AudioWaveformSine[idx];
+    y1 = AudioWaveformSine[idx + 1];
+    y = (int64_t)y0 * (0x00FFFFFF - idx);
+    y += (int64_t)y1 * idx;
+    *lfo_cos = (int32_t) (y >> (32-8));
+}
+
+// allpass on a ring buffer with write index w
+static inline float32_t allpass(float32_t *buf, uint32_t mask, uint32_t w, uint32_t len, float32_t input, float32_t k)
+{
+    float32_t acc = buf[(w - len) & mask] + input * k;
+    buf[w & mask] = input - k * acc;
+
+    return acc;
+}
+
+#if defined(ARM_MATH_NEON)
+// the same for the L and R line of a stage at once
+static inline float32x2_t allpass_stereo(float32_t *buf, uint32_t mask, uint32_t w_L, uint32_t w_R, uint32_t len_L, uint32_t len_R, float32x2_t input, float32x2_t k)
+{
+    float32x2_t acc = vdup_n_f32(0.0f);
+    acc = vld1_lane_f32(&buf[(w_L - len_L) & mask], acc, 0);
+    acc = vld1_lane_f32(&buf[(w_R - len_R) & mask], acc, 1);
+    acc = vmla_f32(acc, input, k);
+    float32x2_t output = vmls_f32(input, k, acc);
+    vst1_lane_f32(&buf[w_L & mask], output, 0);
+    vst1_lane_f32(&buf[w_R & mask], output, 1);
+
+    return acc;
+}
+#endif
+
+// delay line tap with linear interpolation, pos is the absolute index of the first sample
+static inline float32_t tap_interp(const float32_t *buf, uint32_t mask, uint32_t pos, float32_t frac)
+{
+    float32_t temp1 = buf[pos & mask];          // sample now
+    float32_t temp2 = buf[(pos + 1) & mask];    // sample next
+
+    return temp1*(1.0f-frac) + temp2*frac;
+}
+
+bool AudioEffectPlateReverb::doReverb(const float32_t* inblockL, const float32_t* inblockR, float32_t* rvbblockL, float32_t* rvbblockR, uint16_t len)
+{
+    enum {LFO1_SIN, LFO1_COS, LFO2_SIN, LFO2_COS, LFO_OUTPUTS};
+
+    float32_t input, acc, temp1, temp2;
+    float32_t rv_time;
+
+    // LFO outputs as delay offset and interpolation coefficient, input allpass outputs (L/R interleaved)
+    int32_t lfo_ofs[LFO_OUTPUTS][RV_BLOCK_SIZE];
+    float32_t lfo_frac[LFO_OUTPUTS][RV_BLOCK_SIZE];
+    float32_t in_allp_out[RV_BLOCK_SIZE*2];
 
     // handle bypass, 1st call will clean the buffers to avoid continuing the previous reverb tail
     if (bypass)
     {
         if (!cleanup_done)
         {
-            memset(in_allp1_bufL, 0, sizeof(in_allp1_bufL));
-            memset(in_allp2_bufL, 0, sizeof(in_allp2_bufL));
-            memset(in_allp3_bufL, 0, sizeof(in_allp3_bufL));
-            memset(in_allp4_bufL, 0, sizeof(in_allp4_bufL));
-            memset(in_allp1_bufR, 0, sizeof(in_allp1_bufR));
-            memset(in_allp2_bufR, 0, sizeof(in_allp2_bufR));
-            memset(in_allp3_bufR, 0, sizeof(in_allp3_bufR));
-            memset(in_allp4_bufR, 0, sizeof(in_allp4_bufR));
-            memset(lp_allp1_buf, 0, sizeof(lp_allp1_buf));
-            memset(lp_allp2_buf, 0, sizeof(lp_allp2_buf));
-            memset(lp_allp3_buf, 0, sizeof(lp_allp3_buf));
-            memset(lp_allp4_buf, 0, sizeof(lp_allp4_buf));
-            memset(lp_dly1_buf, 0, sizeof(lp_dly1_buf));
-            memset(lp_dly2_buf, 0, sizeof(lp_dly2_buf));
-            memset(lp_dly3_buf, 0, sizeof(lp_dly3_buf));
-            memset(lp_dly4_buf, 0, sizeof(lp_dly4_buf));
+            cleanup();
 
+            idle = true;
             cleanup_done = true;
         }
 
-        return;
+        return false;
     }
     cleanup_done = false;
 
+    // nothing to do, until there is new input
+    bool input_silent = is_silent(inblockL, inblockR, len);
+    if (input_silent && idle)
+    {
+        return false;
+    }
+    idle = false;
+
+    float32_t* outblockL = rvbblockL;
+    float32_t* outblockR = rvbblockR;
+    uint16_t outlen = len;
+
     rv_time = rv_time_k;
 
-    for (uint16_t i=0; i < len; i++) 
+    while (len > 0)
     {
+        uint16_t blk = len < RV_BLOCK_SIZE ? len : RV_BLOCK_SIZE;
+
         // do the LFOs
-        lfo1_phase_acc += lfo1_adder;
-        idx = lfo1_phase_acc >> 24;     // 8bit lookup table address
-        y0 =  AudioWaveformSine[idx];
-        y1 = AudioWaveformSine[idx+1];
-        idx = lfo1_phase_acc & 0x00FFFFFF;   // lower 24 bit = fractional part
-        y = (int64_t)y0 * (0x00FFFFFF - idx);
-        y += (int64_t)y1 * idx;
-        lfo1_out_sin = (int32_t) (y >> (32-8)); // 16bit output
-        idx = ((lfo1_phase_acc >> 24)+64) & 0xFF;
-        y0 = AudioWaveformSine[idx];
-        y1 = AudioWaveformSine[idx + 1];
-        y = (int64_t)y0 * (0x00FFFFFF - idx);
-        y += (int64_t)y1 * idx;
-        lfo1_out_cos = (int32_t) (y >> (32-8)); // 16bit output        
-
-        lfo2_phase_acc += lfo2_adder;
-        idx = lfo2_phase_acc >> 24;     // 8bit lookup table address
-        y0 =  AudioWaveformSine[idx];
-        y1 = AudioWaveformSine[idx+1];
-        idx = lfo2_phase_acc & 0x00FFFFFF;   // lower 24 bit = fractional part
-        y = (int64_t)y0 * (0x00FFFFFF - idx);
-        y += (int64_t)y1 * idx;
-        lfo2_out_sin = (int32_t) (y >> (32-8)); //32-8->output 16bit,
-        idx = ((lfo2_phase_acc >> 24)+64) & 0xFF;
-        y0 = AudioWaveformSine[idx];
-        y1 = AudioWaveformSine[idx + 1];
-        y = (int64_t)y0 * (0x00FFFFFF - idx);
-        y += (int64_t)y1 * idx;
-        lfo2_out_cos = (int32_t) (y >> (32-8)); // 16bit output   
-
-	input = inblockL[i] * input_attn;
-
-        // chained input allpasses, channel L
-        acc = in_allp1_bufL[in_allp1_idxL]  + input * in_allp_k;  
-        in_allp1_bufL[in_allp1_idxL] = input - in_allp_k * acc;
-        input = acc;
-        if (++in_allp1_idxL >= sizeof(in_allp1_bufL)/sizeof(float32_t)) in_allp1_idxL = 0;
-
-        acc = in_allp2_bufL[in_allp2_idxL]  + input * in_allp_k;  
-        in_allp2_bufL[in_allp2_idxL] = input - in_allp_k * acc;
-        input = acc;
-        if (++in_allp2_idxL >= sizeof(in_allp2_bufL)/sizeof(float32_t)) in_allp2_idxL = 0;
-
-        acc = in_allp3_bufL[in_allp3_idxL]  + input * in_allp_k;  
-        in_allp3_bufL[in_allp3_idxL] = input - in_allp_k * acc;
-        input = acc;
-        if (++in_allp3_idxL >= sizeof(in_allp3_bufL)/sizeof(float32_t)) in_allp3_idxL = 0;
-
-        acc = in_allp4_bufL[in_allp4_idxL]  + input * in_allp_k;  
-        in_allp4_bufL[in_allp4_idxL] = input - in_allp_k * acc;
-        in_allp_out_L = acc;
-        if (++in_allp4_idxL >= sizeof(in_allp4_bufL)/sizeof(float32_t)) in_allp4_idxL = 0;
-
-        input = inblockR[i] * input_attn;
-
-        // chained input allpasses, channel R
-        acc = in_allp1_bufR[in_allp1_idxR]  + input * in_allp_k;  
-        in_allp1_bufR[in_allp1_idxR] = input - in_allp_k * acc;
-        input = acc;
-        if (++in_allp1_idxR >= sizeof(in_allp1_bufR)/sizeof(float32_t)) in_allp1_idxR = 0;
-
-        acc = in_allp2_bufR[in_allp2_idxR]  + input * in_allp_k;  
-        in_allp2_bufR[in_allp2_idxR] = input - in_allp_k * acc;
-        input = acc;
-        if (++in_allp2_idxR >= sizeof(in_allp2_bufR)/sizeof(float32_t)) in_allp2_idxR = 0;
-
-        acc = in_allp3_bufR[in_allp3_idxR]  + input * in_allp_k;  
-        in_allp3_bufR[in_allp3_idxR] = input - in_allp_k * acc;
-        input = acc;
-        if (++in_allp3_idxR >= sizeof(in_allp3_bufR)/sizeof(float32_t)) in_allp3_idxR = 0;
-
-        acc = in_allp4_bufR[in_allp4_idxR]  + input * in_allp_k;  
-        in_allp4_bufR[in_allp4_idxR] = input - in_allp_k * acc;
-        in_allp_out_R = acc;
-        if (++in_allp4_idxR >= sizeof(in_allp4_bufR)/sizeof(float32_t)) in_allp4_idxR = 0;
-
-        // input allpases done, start loop allpases
-        input = lp_allp_out + in_allp_out_R; 
-        acc = lp_allp1_buf[lp_allp1_idx] + input * loop_allp_k;                  // input is the lp allpass chain output
-        lp_allp1_buf[lp_allp1_idx] = input - loop_allp_k * acc;
-        input = acc;
-        if (++lp_allp1_idx >= sizeof(lp_allp1_buf)/sizeof(float32_t)) lp_allp1_idx = 0;
-        
-        acc = lp_dly1_buf[lp_dly1_idx];                                                   // read the end of the delay
-        lp_dly1_buf[lp_dly1_idx] = input;                                                 // write new sample
-        input = acc;
-        if (++lp_dly1_idx >= sizeof(lp_dly1_buf)/sizeof(float32_t)) lp_dly1_idx = 0;     // update index
-
-        // hi/lo shelving filter
-        temp1 = input - lpf1;
-        lpf1 += temp1 * lp_lowpass_f;
-        temp2 = input - lpf1;
-        temp1 = lpf1 - hpf1;
-        hpf1 += temp1 * lp_hipass_f;
-        acc = lpf1 + temp2*lp_hidamp_k + hpf1*lp_lodamp_k;
-        acc = acc * rv_time * rv_time_scaler;                                                                // scale by the reveb time
-        
-        input = acc + in_allp_out_L;
-
-        acc = lp_allp2_buf[lp_allp2_idx] + input * loop_allp_k;                  
-        lp_allp2_buf[lp_allp2_idx] = input - loop_allp_k * acc;
-        input = acc;
-        if (++lp_allp2_idx >= sizeof(lp_allp2_buf)/sizeof(float32_t)) lp_allp2_idx = 0;
-        acc = lp_dly2_buf[lp_dly2_idx];                                                   // read the end of the delay
-        lp_dly2_buf[lp_dly2_idx] = input;                                                 // write new sample
-        input = acc;
-        if (++lp_dly2_idx >= sizeof(lp_dly2_buf)/sizeof(float32_t)) lp_dly2_idx = 0;     // update index
-        // hi/lo shelving filter
-        temp1 = input - lpf2;
-        lpf2 += temp1 * lp_lowpass_f;
-        temp2 = input - lpf2;
-        temp1 = lpf2 - hpf2;
-        hpf2 += temp1 * lp_hipass_f;
-        acc = lpf2 + temp2*lp_hidamp_k + hpf2*lp_lodamp_k;
-        acc = acc * rv_time * rv_time_scaler;             
-
-        input = acc + in_allp_out_R;
-
-        acc = lp_allp3_buf[lp_allp3_idx] + input * loop_allp_k;                  
-        lp_allp3_buf[lp_allp3_idx] = input - loop_allp_k * acc;
-        input = acc;
-        if (++lp_allp3_idx >= sizeof(lp_allp3_buf)/sizeof(float32_t)) lp_allp3_idx = 0;
-        acc = lp_dly3_buf[lp_dly3_idx];                                                   // read the end of the delay
-        lp_dly3_buf[lp_dly3_idx] = input;                                                 // write new sample
-        input = acc;
-        if (++lp_dly3_idx >= sizeof(lp_dly3_buf)/sizeof(float32_t)) lp_dly3_idx = 0;     // update index
-        // hi/lo shelving filter
-        temp1 = input - lpf3;
-        lpf3 += temp1 * lp_lowpass_f;
-        temp2 = input - lpf3;
-        temp1 = lpf3 - hpf3;
-        hpf3 += temp1 * lp_hipass_f;
-        acc = lpf3 + temp2*lp_hidamp_k + hpf3*lp_lodamp_k;
-        acc = acc * rv_time * rv_time_scaler;              
-
-        input = acc + in_allp_out_L;       
-
-        acc = lp_allp4_buf[lp_allp4_idx] + input * loop_allp_k;                  
-        lp_allp4_buf[lp_allp4_idx] = input - loop_allp_k * acc;
-        input = acc;
-        if (++lp_allp4_idx >= sizeof(lp_allp4_buf)/sizeof(float32_t)) lp_allp4_idx = 0;
-        acc = lp_dly4_buf[lp_dly4_idx];                                                   // read the end of the delay
-        lp_dly4_buf[lp_dly4_idx] = input;                                                 // write new sample
-        input = acc;
-        if (++lp_dly4_idx >= sizeof(lp_dly4_buf)/sizeof(float32_t)) lp_dly4_idx= 0;     // update index
-        // hi/lo shelving filter
-        temp1 = input - lpf4;
-        lpf4 += temp1 * lp_lowpass_f;
-        temp2 = input - lpf4;
-        temp1 = lpf4 - hpf4;
-        hpf4 += temp1 * lp_hipass_f;
-        acc = lpf4 + temp2*lp_hidamp_k + hpf4*lp_lodamp_k;
-        acc = acc * rv_time * rv_time_scaler;              
-
-        lp_allp_out = acc;
-
-        // channel L:
-#ifdef TAP1_MODULATED
-        temp16 = (lp_dly1_idx + lp_dly1_offset_L + (lfo1_out_cos>>LFO_FRAC_BITS)) %  (sizeof(lp_dly1_buf)/sizeof(float32_t));
-        temp1 = lp_dly1_buf[temp16++];    // sample now
-        if (temp16  >= sizeof(lp_dly1_buf)/sizeof(float32_t)) temp16 = 0;
-        temp2 = lp_dly1_buf[temp16];    // sample next
-        input = (float32_t)(lfo1_out_cos & LFO_FRAC_MASK) / ((float32_t)LFO_FRAC_MASK); // interp. k
-        acc = (temp1*(1.0f-input) + temp2*input)* 0.8f;
+        for (uint16_t i=0; i < blk; i++)
+        {
+            int16_t lfo_out[LFO_OUTPUTS];
+
+            lfo1_phase_acc += lfo1_adder;
+            lfo_sin_cos(lfo1_phase_acc, &lfo_out[LFO1_SIN], &lfo_out[LFO1_COS]);
+            lfo2_phase_acc += lfo2_adder;
+            lfo_sin_cos(lfo2_phase_acc, &lfo_out[LFO2_SIN], &lfo_out[LFO2_COS]);
+
+            for (unsigned j=0; j < LFO_OUTPUTS; j++)
+            {
+                lfo_ofs[j][i] = lfo_out[j] >> LFO_FRAC_BITS;
+                lfo_frac[j][i] = (float32_t)(lfo_out[j] & LFO_FRAC_MASK) / ((float32_t)LFO_FRAC_MASK); // interp. k
+            }
+        }
+
+        // chained input allpasses, channel L and R
+#if defined(ARM_MATH_NEON)
+        float32x2_t k = vdup_n_f32(in_allp_k);
+        float32x2_t attn = vdup_n_f32(input_attn);
+        for (uint16_t i=0; i < blk; i++)
+        {
+            uint32_t w = rv_idx + i;
+            float32x2_t in = vmul_f32(vset_lane_f32(inblockR[i], vdup_n_f32(inblockL[i]), 1), attn);
+
+            in = allpass_stereo(rv_buf, rv_buf_mask, w + in_allp1_end_L, w + in_allp1_end_R, in_allp1_len_L, in_allp1_len_R, in, k);
+            in = allpass_stereo(rv_buf, rv_buf_mask, w + in_allp2_end_L, w + in_allp2_end_R, in_allp2_len_L, in_allp2_len_R, in, k);
+            in = allpass_stereo(rv_buf, rv_buf_mask, w + in_allp3_end_L, w + in_allp3_end_R, in_allp3_len_L, in_allp3_len_R, in, k);
+            in = allpass_stereo(rv_buf, rv_buf_mask, w + in_allp4_end_L, w + in_allp4_end_R, in_allp4_len_L, in_allp4_len_R, in, k);
+
+            vst1_f32(&in_allp_out[i*2], in);
+        }
 #else
-        temp16 = (lp_dly1_idx + lp_dly1_offset_L) %  (sizeof(lp_dly1_buf)/sizeof(float32_t));
-        acc = lp_dly1_buf[temp16]* 0.8f;
+        for (uint16_t i=0; i < blk; i++)
+        {
+            uint32_t w = rv_idx + i;
+
+            input = inblockL[i] * input_attn;
+            input = allpass(rv_buf, rv_buf_mask, w + in_allp1_end_L, in_allp1_len_L, input, in_allp_k);
+            input = allpass(rv_buf, rv_buf_mask, w + in_allp2_end_L, in_allp2_len_L, input, in_allp_k);
+            input = allpass(rv_buf, rv_buf_mask, w + in_allp3_end_L, in_allp3_len_L, input, in_allp_k);
+            in_allp_out[i*2] = allpass(rv_buf, rv_buf_mask, w + in_allp4_end_L, in_allp4_len_L, input, in_allp_k);
+
+            input = inblockR[i] * input_attn;
+            input = allpass(rv_buf, rv_buf_mask, w + in_allp1_end_R, in_allp1_len_R, input, in_allp_k);
+            input = allpass(rv_buf, rv_buf_mask, w + in_allp2_end_R, in_allp2_len_R, input, in_allp_k);
+            input = allpass(rv_buf, rv_buf_mask, w + in_allp3_end_R, in_allp3_len_R, input, in_allp_k);
+            in_allp_out[i*2+1] = allpass(rv_buf, rv_buf_mask, w + in_allp4_end_R, in_allp4_len_R, input, in_allp_k);
+        }
 #endif
 
+        for (uint16_t i=0; i < blk; i++)
+        {
+            uint32_t w = rv_idx + i;
+            float32_t in_allp_out_L = in_allp_out[i*2];
+            float32_t in_allp_out_R = in_allp_out[i*2+1];
+
+            // input allpases done, start loop allpases
+            input = lp_allp_out + in_allp_out_R;
+            input = allpass(rv_buf, rv_buf_mask, w + lp_allp1_end, lp_allp1_len, input, loop_allp_k);
+            acc = rv_buf[(w + lp_dly1_end - lp_dly1_len) & rv_buf_mask];     // read the end of the delay
+            rv_buf[(w + lp_dly1_end) & rv_buf_mask] = input;                  // write new sample
+            input = acc;
+
+            // hi/lo shelving filter
+            temp1 = input - lpf1;
+            lpf1 += temp1 * lp_lowpass_f;
+            temp2 = input - lpf1;
+            temp1 = lpf1 - hpf1;
+            hpf1 += temp1 * lp_hipass_f;
+            acc = lpf1 + temp2*lp_hidamp_k + hpf1*lp_lodamp_k;
+            acc = acc * rv_time * rv_time_scaler;                               // scale by the reveb time
+
+            input = acc + in_allp_out_L;
+
+            input = allpass(rv_buf, rv_buf_mask, w + lp_allp2_end, lp_allp2_len, input, loop_allp_k);
+            acc = rv_buf[(w + lp_dly2_end - lp_dly2_len) & rv_buf_mask];
+            rv_buf[(w + lp_dly2_end) & rv_buf_mask] = input;
+            input = acc;
+            // hi/lo shelving filter
+            temp1 = input - lpf2;
+            lpf2 += temp1 * lp_lowpass_f;
+            temp2 = input - lpf2;
+            temp1 = lpf2 - hpf2;
+            hpf2 += temp1 * lp_hipass_f;
+            acc = lpf2 + temp2*lp_hidamp_k + hpf2*lp_lodamp_k;
+            acc = acc * rv_time * rv_time_scaler;
+
+            input = acc + in_allp_out_R;
+
+            input = allpass(rv_buf, rv_buf_mask, w + lp_allp3_end, lp_allp3_len, input, loop_allp_k);
+            acc = rv_buf[(w + lp_dly3_end - lp_dly3_len) & rv_buf_mask];
+            rv_buf[(w + lp_dly3_end) & rv_buf_mask] = input;
+            input = acc;
+            // hi/lo shelving filter
+            temp1 = input - lpf3;
+            lpf3 += temp1 * lp_lowpass_f;
+            temp2 = input - lpf3;
+            temp1 = lpf3 - hpf3;
+            hpf3 += temp1 * lp_hipass_f;
+            acc = lpf3 + temp2*lp_hidamp_k + hpf3*lp_lodamp_k;
+            acc = acc * rv_time * rv_time_scaler;
+
+            input = acc + in_allp_out_L;
+
+            input = allpass(rv_buf, rv_buf_mask, w + lp_allp4_end, lp_allp4_len, input, loop_allp_k);
+            acc = rv_buf[(w + lp_dly4_end - lp_dly4_len) & rv_buf_mask];
+            rv_buf[(w + lp_dly4_end) & rv_buf_mask] = input;
+            input = acc;
+            // hi/lo shelving filter
+            temp1 = input - lpf4;
+            lpf4 += temp1 * lp_lowpass_f;
+            temp2 = input - lpf4;
+            temp1 = lpf4 - hpf4;
+            hpf4 += temp1 * lp_hipass_f;
+            acc = lpf4 + temp2*lp_hidamp_k + hpf4*lp_lodamp_k;
+            acc = acc * rv_time * rv_time_scaler;
+
+            lp_allp_out = acc;
+
+            // the oldest sample of each delay line, the taps are relative to it
+            uint32_t dly1_pos = w + lp_dly1_end + 1 - lp_dly1_len;
+            uint32_t dly2_pos = w + lp_dly2_end + 1 - lp_dly2_len;
+            uint32_t dly3_pos = w + lp_dly3_end + 1 - lp_dly3_len;
+            uint32_t dly4_pos = w + lp_dly4_end + 1 - lp_dly4_len;
+
+            // channel L:
+#ifdef TAP1_MODULATED
+            acc = tap_interp(rv_buf, rv_buf_mask, dly1_pos + lp_dly1_offset_L + lfo_ofs[LFO1_COS][i], lfo_frac[LFO1_COS][i]) * 0.8f;
+#else
+            acc = rv_buf[(dly1_pos + lp_dly1_offset_L) & rv_buf_mask] * 0.8f;
+#endif
 
 #ifdef TAP2_MODULATED
-        temp16 = (lp_dly2_idx + lp_dly2_offset_L + (lfo1_out_sin>>LFO_FRAC_BITS)) % (sizeof(lp_dly2_buf)/sizeof(float32_t));
-        temp1 = lp_dly2_buf[temp16++];
-        if (temp16  >= sizeof(lp_dly2_buf)/sizeof(float32_t)) temp16 = 0;
-        temp2 = lp_dly2_buf[temp16]; 
-        input = (float32_t)(lfo1_out_sin & LFO_FRAC_MASK) / ((float32_t)LFO_FRAC_MASK); // interp. k
-        acc += (temp1*(1.0f-input) + temp2*input)* 0.7f;
+            acc += tap_interp(rv_buf, rv_buf_mask, dly2_pos + lp_dly2_offset_L + lfo_ofs[LFO1_SIN][i], lfo_frac[LFO1_SIN][i]) * 0.7f;
 #else
-        temp16 = (lp_dly2_idx + lp_dly2_offset_L) % (sizeof(lp_dly2_buf)/sizeof(float32_t));
-        acc += (temp1*(1.0f-input) + temp2*input)* 0.6f;
+            acc += rv_buf[(dly2_pos + lp_dly2_offset_L) & rv_buf_mask] * 0.6f;
+#endif
+
+            acc += tap_interp(rv_buf, rv_buf_mask, dly3_pos + lp_dly3_offset_L + lfo_ofs[LFO2_COS][i], lfo_frac[LFO2_COS][i]) * 0.6f;
+            acc += tap_interp(rv_buf, rv_buf_mask, dly4_pos + lp_dly4_offset_L + lfo_ofs[LFO2_SIN][i], lfo_frac[LFO2_SIN][i]) * 0.5f;
+
+            // Master lowpass filter
+            temp1 = acc - master_lowpass_l;
+            master_lowpass_l += temp1 * master_lowpass_f;
+
+            rvbblockL[i] = master_lowpass_l;
+
+            // Channel R
+#ifdef TAP1_MODULATED
+            acc = tap_interp(rv_buf, rv_buf_mask, dly1_pos + lp_dly1_offset_R + lfo_ofs[LFO2_COS][i], lfo_frac[LFO2_COS][i]) * 0.8f;
+#else
+            acc = rv_buf[(dly1_pos + lp_dly1_offset_R) & rv_buf_mask] * 0.8f;
 #endif
 
-        temp16 = (lp_dly3_idx + lp_dly3_offset_L + (lfo2_out_cos>>LFO_FRAC_BITS)) % (sizeof(lp_dly3_buf)/sizeof(float32_t));
-        temp1 = lp_dly3_buf[temp16++];
-        if (temp16  >= sizeof(lp_dly3_buf)/sizeof(float32_t)) temp16 = 0;
-        temp2 = lp_dly3_buf[temp16]; 
-        input = (float32_t)(lfo2_out_cos & LFO_FRAC_MASK) / ((float32_t)LFO_FRAC_MASK); // interp. k
-        acc += (temp1*(1.0f-input) + temp2*input)* 0.6f;
-
-        temp16 = (lp_dly4_idx + lp_dly4_offset_L + (lfo2_out_sin>>LFO_FRAC_BITS)) % (sizeof(lp_dly4_buf)/sizeof(float32_t));
-        temp1 = lp_dly4_buf[temp16++];
-        if (temp16  >= sizeof(lp_dly4_buf)/sizeof(float32_t)) temp16 = 0;
-        temp2 = lp_dly4_buf[temp16]; 
-        input = (float32_t)(lfo2_out_sin & LFO_FRAC_MASK) / ((float32_t)LFO_FRAC_MASK); // interp. k
-        acc += (temp1*(1.0f-input) + temp2*input)* 0.5f;
-
-        // Master lowpass filter
-        temp1 = acc - master_lowpass_l;
-        master_lowpass_l += temp1 * master_lowpass_f;
-
-	rvbblockL[i] = master_lowpass_l;
-
-        // Channel R
-        #ifdef TAP1_MODULATED
-        temp16 = (lp_dly1_idx + lp_dly1_offset_R + (lfo2_out_cos>>LFO_FRAC_BITS)) %  (sizeof(lp_dly1_buf)/sizeof(float32_t));
-        temp1 = lp_dly1_buf[temp16++];    // sample now
-        if (temp16  >= sizeof(lp_dly1_buf)/sizeof(float32_t)) temp16 = 0;
-        temp2 = lp_dly1_buf[temp16];    // sample next
-        input = (float32_t)(lfo2_out_cos & LFO_FRAC_MASK) / ((float32_t)LFO_FRAC_MASK); // interp. k
-
-        acc = (temp1*(1.0f-input) + temp2*input)* 0.8f;
-        #else
-        temp16 = (lp_dly1_idx + lp_dly1_offset_R) %  (sizeof(lp_dly1_buf)/sizeof(float32_t));
-        acc = lp_dly1_buf[temp16] * 0.8f;
-        #endif
 #ifdef TAP2_MODULATED
-        temp16 = (lp_dly2_idx + lp_dly2_offset_R + (lfo1_out_cos>>LFO_FRAC_BITS)) % (sizeof(lp_dly2_buf)/sizeof(float32_t));
-        temp1 = lp_dly2_buf[temp16++];
-        if (temp16  >= sizeof(lp_dly2_buf)/sizeof(float32_t)) temp16 = 0;
-        temp2 = lp_dly2_buf[temp16]; 
-        input = (float32_t)(lfo1_out_cos & LFO_FRAC_MASK) / ((float32_t)LFO_FRAC_MASK); // interp. k
-        acc += (temp1*(1.0f-input) + temp2*input)* 0.7f;
+            acc += tap_interp(rv_buf, rv_buf_mask, dly2_pos + lp_dly2_offset_R + lfo_ofs[LFO1_COS][i], lfo_frac[LFO1_COS][i]) * 0.7f;
 #else
-        temp16 = (lp_dly2_idx + lp_dly2_offset_R) % (sizeof(lp_dly2_buf)/sizeof(float32_t));
-        acc += (temp1*(1.0f-input) + temp2*input)* 0.7f;
+            acc += rv_buf[(dly2_pos + lp_dly2_offset_R) & rv_buf_mask] * 0.7f;
 #endif
-        temp16 = (lp_dly3_idx + lp_dly3_offset_R + (lfo2_out_sin>>LFO_FRAC_BITS)) % (sizeof(lp_dly3_buf)/sizeof(float32_t));
-        temp1 = lp_dly3_buf[temp16++];
-        if (temp16  >= sizeof(lp_dly3_buf)/sizeof(float32_t)) temp16 = 0;
-        temp2 = lp_dly3_buf[temp16]; 
-        input = (float32_t)(lfo2_out_sin & LFO_FRAC_MASK) / ((float32_t)LFO_FRAC_MASK); // interp. k
-        acc += (temp1*(1.0f-input) + temp2*input)* 0.6f;
-
-        temp16 = (lp_dly4_idx + lp_dly4_offset_R + (lfo1_out_sin>>LFO_FRAC_BITS)) % (sizeof(lp_dly4_buf)/sizeof(float32_t));
-        temp1 = lp_dly4_buf[temp16++];
-        if (temp16  >= sizeof(lp_dly4_buf)/sizeof(float32_t)) temp16 = 0;
-        temp2 = lp_dly4_buf[temp16]; 
-        input = (float32_t)(lfo2_out_cos & LFO_FRAC_MASK) / ((float32_t)LFO_FRAC_MASK); // interp. k
-        acc += (temp1*(1.0f-input) + temp2*input)* 0.5f;
-
-        // Master lowpass filter
-        temp1 = acc - master_lowpass_r;
-        master_lowpass_r += temp1 * master_lowpass_f;
-
-	rvbblockR[i] = master_lowpass_r;
+
+            acc += tap_interp(rv_buf, rv_buf_mask, dly3_pos + lp_dly3_offset_R + lfo_ofs[LFO2_SIN][i], lfo_frac[LFO2_SIN][i]) * 0.6f;
+            // the 4th tap uses the LFO 2 cosine for interpolation
+            acc += tap_interp(rv_buf, rv_buf_mask, dly4_pos + lp_dly4_offset_R + lfo_ofs[LFO1_SIN][i], lfo_frac[LFO2_COS][i]) * 0.5f;
+
+            // Master lowpass filter
+            temp1 = acc - master_lowpass_r;
+            master_lowpass_r += temp1 * master_lowpass_f;
+
+            rvbblockR[i] = master_lowpass_r;
+        }
+
+        rv_idx += blk;
+
+        inblockL += blk;
+        inblockR += blk;
+        rvbblockL += blk;
+        rvbblockR += blk;
+        len -= blk;
     }
+
+    // track the tail
+    if (input_silent && is_silent(outblockL, outblockR, outlen))
+    {
+        silent_len += outlen;
+        if (silent_len >= rv_tail_len)
+        {
+            idle = true;
+            silent_len = 0;
+        }
+    }
+    else
+    {
+        silent_len = 0;
+    }
+
+    return true;
 }
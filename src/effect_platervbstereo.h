@@ -60,7 +60,8 @@ class AudioEffectPlateReverb
 {
 public:
     AudioEffectPlateReverb(float32_t samplerate);
-    void doReverb(const float32_t* inblockL, const float32_t* inblockR, float32_t* rvbblockL, float32_t* rvbblockR,uint16_t len);
+    // returns false, if the reverb is bypassed or idle and no output has been written
+    bool doReverb(const float32_t* inblockL, const float32_t* inblockR, float32_t* rvbblockL, float32_t* rvbblockR,uint16_t len);
 
     void size(float n)
     {
@@ -109,48 +110,77 @@ public:
     void set_bypass(bool state) {bypass = state;};
     void tgl_bypass(void) {bypass ^=1;}
     float32_t get_level(void) {return reverb_level;}
+    bool is_idle(void) {return idle;}
 private:
+    void cleanup(void);
+    static bool is_silent(const float32_t* blockL, const float32_t* blockR, uint16_t len);
+
     bool bypass = false;
+    bool cleanup_done = false;
+
+    // The reverb goes idle, when input and output have been silent for
+    // longer than the signal needs to pass all delay lines, and wakes up
+    // with the first non-silent input block.
+    bool idle = true;
+    uint32_t silent_len;
     float32_t reverb_level;
     float32_t input_attn;
 
+    // All delay lines share one ring buffer with a power-of-two size, addressed
+    // by the common write index rv_idx and a mask. A line of length N occupies
+    // N+1 entries, which move through the buffer with rv_idx. It writes at
+    // (rv_idx + end) & mask and reads the sample, which has been written N
+    // samples ago, at (rv_idx + end - N) & mask. The next line follows at
+    // end + 1, so a write overwrites the oldest sample of the next line,
+    // which has been read one sample before. The input allpasses are run a
+    // block ahead of the loop, so one block is left free behind the last line.
+    static const uint32_t rv_buf_mask = 32768 - 1;
+    float32_t rv_buf[rv_buf_mask + 1];
+    uint32_t rv_idx;
+
     float32_t in_allp_k;            // input allpass coeff 
-    float32_t in_allp1_bufL[224];   // input allpass buffers
-    float32_t in_allp2_bufL[420];
-    float32_t in_allp3_bufL[856];
-    float32_t in_allp4_bufL[1089];
-    uint16_t in_allp1_idxL;
-    uint16_t in_allp2_idxL;
-    uint16_t in_allp3_idxL;
-    uint16_t in_allp4_idxL;
-    float32_t in_allp_out_L;    // L allpass chain output
-    float32_t in_allp1_bufR[156]; // input allpass buffers
-    float32_t in_allp2_bufR[520];
-    float32_t in_allp3_bufR[956];
-    float32_t in_allp4_bufR[1289];
-    uint16_t in_allp1_idxR;
-    uint16_t in_allp2_idxR;
-    uint16_t in_allp3_idxR;
-    uint16_t in_allp4_idxR;
-    float32_t in_allp_out_R;    // R allpass chain output
-    float32_t lp_allp1_buf[2303]; // loop allpass buffers
-    float32_t lp_allp2_buf[2905];
-    float32_t lp_allp3_buf[3175];
-    float32_t lp_allp4_buf[2398];
-    uint16_t lp_allp1_idx;
-    uint16_t lp_allp2_idx;
-    uint16_t lp_allp3_idx;
-    uint16_t lp_allp4_idx;
+    static const uint32_t in_allp1_len_L = 224;     // input allpass lengths
+    static const uint32_t in_allp2_len_L = 420;
+    static const uint32_t in_allp3_len_L = 856;
+    static const uint32_t in_allp4_len_L = 1089;
+    static const uint32_t in_allp1_len_R = 156;
+    static const uint32_t in_allp2_len_R = 520;
+    static const uint32_t in_allp3_len_R = 956;
+    static const uint32_t in_allp4_len_R = 1289;
+
+    static const uint32_t lp_allp1_len = 2303;      // loop allpass lengths
+    static const uint32_t lp_allp2_len = 2905;
+    static const uint32_t lp_allp3_len = 3175;
+    static const uint32_t lp_allp4_len = 2398;
     float32_t loop_allp_k;         // loop allpass coeff
     float32_t lp_allp_out;
-    float32_t lp_dly1_buf[3423];
-    float32_t lp_dly2_buf[4589];
-    float32_t lp_dly3_buf[4365];
-    float32_t lp_dly4_buf[3698];
-    uint16_t lp_dly1_idx;
-    uint16_t lp_dly2_idx;
-    uint16_t lp_dly3_idx;
-    uint16_t lp_dly4_idx;
+
+    static const uint32_t lp_dly1_len = 3423;       // loop delay lengths
+    static const uint32_t lp_dly2_len = 4589;
+    static const uint32_t lp_dly3_len = 4365;
+    static const uint32_t lp_dly4_len = 3698;
+
+    // end of each line in rv_buf (relative to rv_idx), the loop lines first
+    static const uint32_t lp_allp1_end = lp_allp1_len;
+    static const uint32_t lp_dly1_end = lp_allp1_end + 1 + lp_dly1_len;
+    static const uint32_t lp_allp2_end = lp_dly1_end + 1 + lp_allp2_len;
+    static const uint32_t lp_dly2_end = lp_allp2_end + 1 + lp_dly2_len;
+    static const uint32_t lp_allp3_end = lp_dly2_end + 1 + lp_allp3_len;
+    static const uint32_t lp_dly3_end = lp_allp3_end + 1 + lp_dly3_len;
+    static const uint32_t lp_allp4_end = lp_dly3_end + 1 + lp_allp4_len;
+    static const uint32_t lp_dly4_end = lp_allp4_end + 1 + lp_dly4_len;
+    static const uint32_t in_allp1_end_L = lp_dly4_end + 1 + in_allp1_len_L;
+    static const uint32_t in_allp2_end_L = in_allp1_end_L + 1 + in_allp2_len_L;
+    static const uint32_t in_allp3_end_L = in_allp2_end_L + 1 + in_allp3_len_L;
+    static const uint32_t in_allp4_end_L = in_allp3_end_L + 1 + in_allp4_len_L;
+    static const uint32_t in_allp1_end_R = in_allp4_end_L + 1 + in_allp1_len_R;
+    static const uint32_t in_allp2_end_R = in_allp1_end_R + 1 + in_allp2_len_R;
+    static const uint32_t in_allp3_end_R = in_allp2_end_R + 1 + in_allp3_len_R;
+    static const uint32_t in_allp4_end_R = in_allp3_end_R + 1 + in_allp4_len_R;
+
+    static const uint32_t rv_tail_len =   in_allp1_len_R + in_allp2_len_R + in_allp3_len_R + in_allp4_len_R
+                                        + lp_allp1_len + lp_allp2_len + lp_allp3_len + lp_allp4_len
+                                        + lp_dly1_len + lp_dly2_len + lp_dly3_len + lp_dly4_len;
 
     const uint16_t lp_dly1_offset_L = 201;      // delay line tap offets
     const uint16_t lp_dly2_offset_L = 145;
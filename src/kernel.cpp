@@ -21,6 +21,7 @@
 #include <circle/logger.h>
 #include <circle/synchronize.h>
 #include <circle/gpiopin.h>
+#include <circle/timer.h>
 #include <assert.h>
 #include <circle/usb/usbhcidevice.h>
 #include "usbminidexedmidigadget.h"
@@ -156,6 +157,8 @@ CStdlibApp::TShutdownMode CKernel::Run (void)
 {
 	assert (m_pDexed);
 
+	unsigned nLastThrottleTicks = CTimer::GetClockTicks ();
+
 	while (42 == 42)
 	{
 		boolean bUpdated = m_pUSB->UpdatePlugAndPlay ();
@@ -168,6 +171,16 @@ CStdlibApp::TShutdownMode CKernel::Run (void)
 		}
 
 		m_CPUThrottle.Update ();
+
+		// to see, if the audio cores heat the SoC up until it is throttled
+		if (   m_Config.GetProfileEnabled ()
+		    && CTimer::GetClockTicks () - nLastThrottleTicks >= 10 * CLOCKHZ)
+		{
+			nLastThrottleTicks = CTimer::GetClockTicks ();
+
+			LOGNOTE ("SoC temperature %u C, CPU clock %u MHz",
+				 m_CPUThrottle.GetTemperature (), m_CPUThrottle.GetClockRate () / 1000000);
+		}
 	}
 
 	return ShutdownHalt;
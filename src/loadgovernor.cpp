@@ -0,0 +1,125 @@
+//
+// loadgovernor.cpp
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "loadgovernor.h"
+#include <circle/logger.h>
+#include <assert.h>
+
+LOGMODULE ("governor");
+
+static const unsigned LoadScale = 16;
+static const unsigned RiseShift = 2;		// the load follows a rise with 1/4 per chunk
+static const unsigned FallShift = 4;		//   and a fall with 1/16 per chunk
+static const unsigned StepUpMillis = 20;	// time for a step to take effect
+
+static const char *LevelName[CLoadGovernor::LevelUnknown] =
+{
+	"normal",
+	"cut released voices",
+	"limit voices per TG",
+	"reverb off"
+};
+
+CLoadGovernor::CLoadGovernor (unsigned nHighLoad, unsigned nLowLoad, unsigned nHoldMillis, bool bReverbOff)
+:	m_nHighLoad (nHighLoad * LoadScale),
+	m_nLowLoad (nLowLoad * LoadScale),
+	m_nHoldTicks (nHoldMillis * (CLOCKHZ / 1000)),
+	m_MaxLevel (bReverbOff ? LevelReverbOff : LevelLimitVoices),
+	m_nLoad (0),
+	m_nLastChangeTicks (0),
+	m_nLowLoadTicks (0),
+	m_Level (LevelNormal),
+	m_nChangeLoad (0),
+	m_LoggedLevel (LevelNormal)
+{
+	assert (nLowLoad < nHighLoad);
+}
+
+CLoadGovernor::TLevel CLoadGovernor::Update (unsigned nChunkMicros, unsigned nPeriodMicros)
+{
+	assert (nPeriodMicros);
+	unsigned nLoad = nChunkMicros * 100 * LoadScale / nPeriodMicros;
+	if (nLoad > m_nLoad)
+	{
+		m_nLoad += (nLoad - m_nLoad) >> RiseShift;
+	}
+	else
+	{
+		m_nLoad -= (m_nLoad - nLoad) >> FallShift;
+	}
+
+	TLevel Level = m_Level.load (std::memory_order_relaxed);
+	TLevel NewLevel = Level;
+
+	unsigned nTicks = CTimer::GetClockTicks ();
+	if (m_nLoad >= m_nLowLoad)
+	{
+		m_nLowLoadTicks = nTicks;		// the hold time starts below the low threshold
+	}
+
+	if (   m_nLoad > m_nHighLoad
+	    && Level < m_MaxLevel
+	    && nTicks - m_nLastChangeTicks >= StepUpMillis * (CLOCKHZ / 1000))
+	{
+		NewLevel = (TLevel) (Level + 1);
+	}
+	else if (   Level > LevelNormal
+		 && nTicks - m_nLowLoadTicks >= m_nHoldTicks
+		 && nTicks - m_nLastChangeTicks >= m_nHoldTicks)
+	{
+		NewLevel = (TLevel) (Level - 1);
+	}
+
+	if (NewLevel != Level)
+	{
+		m_nLastChangeTicks = nTicks;
+		m_nChangeLoad.store (m_nLoad / LoadScale, std::memory_order_relaxed);
+		m_Level.store (NewLevel, std::memory_order_release);
+	}
+
+	return NewLevel;
+}
+
+CLoadGovernor::TLevel CLoadGovernor::GetLevel (void) const
+{
+	return m_Level.load (std::memory_order_acquire);
+}
+
+void CLoadGovernor::Dump (void)
+{
+	TLevel Level = GetLevel ();
+	if (Level == m_LoggedLevel)
+	{
+		return;
+	}
+
+	// intermediate levels may have been passed since the previous call
+	if (Level > m_LoggedLevel)
+	{
+		LOGWARN ("Load %u%%, level %u: %s", m_nChangeLoad.load (std::memory_order_relaxed),
+			 Level, LevelName[Level]);
+	}
+	else
+	{
+		LOGNOTE ("Load %u%%, back to level %u: %s", m_nChangeLoad.load (std::memory_order_relaxed),
+			 Level, LevelName[Level]);
+	}
+
+	m_LoggedLevel = Level;
+}
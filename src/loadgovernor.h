@@ -0,0 +1,71 @@
+//
+// loadgovernor.h
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _loadgovernor_h
+#define _loadgovernor_h
+
+#include <atomic>
+#include <circle/timer.h>
+
+// Degrades the sound step by step, when the processing time of the chunks
+// comes close to the chunk duration, instead of dropping out. The load is
+// the processing time in percent of the chunk duration, smoothed over a few
+// chunks. It goes up one level, when the load is above the high threshold,
+// and down one level, when it is below the low threshold for the hold time.
+// Update() is called from the audio path, Dump() logs the level changes from
+// the main loop.
+
+class CLoadGovernor
+{
+public:
+	enum TLevel
+	{
+		LevelNormal,
+		LevelCutReleases,		// inaudible released voices are cut
+		LevelLimitVoices,		// and the voices per TG are limited
+		LevelReverbOff,			// and the reverb is switched off
+		LevelUnknown
+	};
+
+public:
+	CLoadGovernor (unsigned nHighLoad, unsigned nLowLoad, unsigned nHoldMillis, bool bReverbOff);
+
+	// returns the level for the next chunk
+	TLevel Update (unsigned nChunkMicros, unsigned nPeriodMicros);
+
+	TLevel GetLevel (void) const;
+
+	void Dump (void);
+
+private:
+	unsigned m_nHighLoad;				// percent * LoadScale
+	unsigned m_nLowLoad;
+	unsigned m_nHoldTicks;
+	TLevel m_MaxLevel;
+
+	unsigned m_nLoad;				// smoothed, percent * LoadScale
+	unsigned m_nLastChangeTicks;
+	unsigned m_nLowLoadTicks;			// last time the load was not below the low threshold
+	std::atomic<TLevel> m_Level;
+	std::atomic<unsigned> m_nChangeLoad;		// at the last change, percent
+
+	TLevel m_LoggedLevel;
+};
+
+#endif
@@ -22,6 +22,7 @@
 //
 
 #include <circle/logger.h>
+#include <circle/synchronize.h>
 #include "mididevice.h"
 #include "minidexed.h"
 #include "config.h"
@@ -54,10 +55,13 @@ const unsigned MIDISystemCCMap[NUM_MIDI_CC_MAPS][8] = {
 
 CMIDIDevice::TDeviceMap CMIDIDevice::s_DeviceMap;
 
+static_assert (CConfig::AllToneGenerators <= 32, "m_ChannelTGMask has one bit per TG");
+
 CMIDIDevice::CMIDIDevice (CMiniDexed *pSynthesizer, CConfig *pConfig, CUserInterface *pUI)
 :	m_pSynthesizer (pSynthesizer),
 	m_pConfig (pConfig),
-	m_pUI (pUI)
+	m_pUI (pUI),
+	m_nThruRoutes (0)
 {
 	for (unsigned nTG = 0; nTG < CConfig::AllToneGenerators; nTG++)
 	{
@@ -65,6 +69,11 @@ CMIDIDevice::CMIDIDevice (CMiniDexed *pSynthesizer, CConfig *pConfig, CUserInter
 		m_PreviousChannelMap[nTG] = Disabled; // Initialize previous channel map
 	}
 
+	for (unsigned nChannel = 0; nChannel < Channels; nChannel++)
+	{
+		m_ChannelTGMask[nChannel] = 0;
+	}
+
 	m_nMIDISystemCCVol = m_pConfig->GetMIDISystemCCVol();
 	m_nMIDISystemCCPan = m_pConfig->GetMIDISystemCCPan();
 	m_nMIDISystemCCDetune = m_pConfig->GetMIDISystemCCDetune();
@@ -118,6 +127,21 @@ void CMIDIDevice::SetChannel (u8 ucChannel, unsigned nTG)
 	}
 	
 	m_ChannelMap[nTG] = ucChannel;
+
+	// only the configured TGs receive MIDI messages
+	u32 nBit = 1U << nTG;
+	for (unsigned nChannel = 0; nChannel < Channels; nChannel++)
+	{
+		if (   nTG < m_pConfig->GetToneGenerators ()
+		    && (ucChannel == nChannel || ucChannel == OmniMode))
+		{
+			m_ChannelTGMask[nChannel] |= nBit;
+		}
+		else
+		{
+			m_ChannelTGMask[nChannel] &= ~nBit;
+		}
+	}
 }
 
 u8 CMIDIDevice::GetChannel (unsigned nTG) const
@@ -131,6 +155,10 @@ void CMIDIDevice::MIDIMessageHandler (const u8 *pMessage, size_t nLength, unsign
 	// The packet contents are just normal MIDI data - see
 	// https://www.midi.org/specifications/item/table-1-summary-of-midi-message
 
+	TRACE (TraceMIDIMessage,   (nLength > 0 ? pMessage[0] : 0)
+				 | (nLength > 1 ? pMessage[1] << 8 : 0)
+				 | (nLength > 2 ? pMessage[2] << 16 : 0));
+
 	if (m_pConfig->GetMIDIDumpEnabled ())
 	{
 		switch (nLength)
@@ -190,41 +218,22 @@ void CMIDIDevice::MIDIMessageHandler (const u8 *pMessage, size_t nLength, unsign
 */
 
 	// Handle MIDI Thru
-	bool canThru = TRUE;
-	if (nLength == 1)
+	if (   nLength > 0
+	    && m_nThruRoutes > 0)
 	{
-		if ((pMessage[0] == MIDI_TIMING_CLOCK) && m_pConfig->GetMIDIThruIgnoreClock())
-		{
-			canThru = FALSE;
-		}
-		if ((pMessage[0] == MIDI_ACTIVE_SENSING) && m_pConfig->GetMIDIThruIgnoreActiveSensing())
-		{
-			canThru = FALSE;
-		}
-	}
-
-	if (canThru)
-	{
-		if (m_DeviceName.compare (m_pConfig->GetMIDIThruIn ()) == 0)
-		{
-			TDeviceMap::const_iterator Iterator;
-
-			Iterator = s_DeviceMap.find (m_pConfig->GetMIDIThruOut ());
-			if (Iterator != s_DeviceMap.end ())
-			{
-				Iterator->second->Send (pMessage, nLength, nCable);
-			}
-		}
+		unsigned nMessageClass = GetMessageClass (pMessage[0]);
+		u8 ucChannel = pMessage[0] < MIDI_SYSTEM_EXCLUSIVE_BEGIN ? pMessage[0] & 0x0F : OmniMode;
 
-		// Handle MIDI Thru 2
-		if (m_DeviceName.compare (m_pConfig->GetMIDIThru2In ()) == 0)
+		for (unsigned i = 0; i < m_nThruRoutes; i++)
 		{
-			TDeviceMap::const_iterator Iterator;
+			const TThruRoute &rRoute = m_ThruRoute[i];
 
-			Iterator = s_DeviceMap.find (m_pConfig->GetMIDIThru2Out ());
-			if (Iterator != s_DeviceMap.end ())
+			if (   (rRoute.nMessageMask & nMessageClass)
+			    && (   rRoute.nChannel == OmniMode
+				|| ucChannel == OmniMode
+				|| ucChannel == rRoute.nChannel))
 			{
-				Iterator->second->Send (pMessage, nLength, nCable);
+				rRoute.pOut->Send (pMessage, nLength, nCable);
 			}
 		}
 	}
@@ -291,6 +300,18 @@ void CMIDIDevice::MIDIMessageHandler (const u8 *pMessage, size_t nLength, unsign
 		//printf("Master volume: %f (%d)\n",fMasterVolume, nMasterVolume);
 		m_pSynthesizer->setMasterVolume(fMasterVolume);
 	}
+	// Dropout statistics are queried with a non-commercial SysEx message:
+	//   F0 7D 00 01 F7
+	// The reply is sent back to this device, see SendXRunStatistics().
+	else if (nLength == 5 &&
+	    pMessage[0] == MIDI_SYSTEM_EXCLUSIVE_BEGIN &&
+	    pMessage[1] == 0x7D &&
+	    pMessage[2] == 0x00 &&
+	    pMessage[3] == 0x01 &&
+	    pMessage[4] == MIDI_SYSTEM_EXCLUSIVE_END)
+	{
+		SendXRunStatistics (nCable);
+	}
 	else
 	{
 		// Perform any MiniDexed level MIDI handling before specific Tone Generators
@@ -365,338 +386,327 @@ void CMIDIDevice::MIDIMessageHandler (const u8 *pMessage, size_t nLength, unsign
 		bool bSystemCCChecked = false;
 		if (ucStatus == MIDI_SYSTEM_EXCLUSIVE_BEGIN) {
 			uint8_t ucSysExChannel = (pMessage[2] & 0x0F);
-			for (unsigned nTG = 0; nTG < m_pConfig->GetToneGenerators(); nTG++) {
-				if (m_ChannelMap[nTG] == ucSysExChannel || m_ChannelMap[nTG] == OmniMode) {
-					LOGNOTE("MIDI-SYSEX: channel: %u, len: %u, TG: %u",m_ChannelMap[nTG],nLength,nTG);
+			for (u32 nTGMask = m_ChannelTGMask[ucSysExChannel]; nTGMask; nTGMask &= nTGMask-1) {
+				unsigned nTG = __builtin_ctz (nTGMask);
+				LOGNOTE("MIDI-SYSEX: channel: %u, len: %u, TG: %u",m_ChannelMap[nTG],nLength,nTG);
 
-					// Check for TX216/TX816 style performance sysex messages
-					
-					if (nLength == 7 && pMessage[3] == 0x04)
-					{
-						// TX816/TX216 Performance SysEx message
-						uint8_t mTG = pMessage[2] & 0x0F; // mTG = module/tone generator number (0-7)
-						uint8_t par = pMessage[4];
-						uint8_t val = pMessage[5];
+				// Check for TX216/TX816 style performance sysex messages
+				
+				if (nLength == 7 && pMessage[3] == 0x04)
+				{
+					// TX816/TX216 Performance SysEx message
+					uint8_t mTG = pMessage[2] & 0x0F; // mTG = module/tone generator number (0-7)
+					uint8_t par = pMessage[4];
+					uint8_t val = pMessage[5];
 
-						if (!(m_ChannelMap[nTG] == mTG || m_ChannelMap[nTG] == OmniMode)) continue;
+					if (!(m_ChannelMap[nTG] == mTG || m_ChannelMap[nTG] == OmniMode)) continue;
 
-						LOGNOTE("MIDI-SYSEX: Assuming TX216/TX816 style performance sysex message because 4th byte is 0x04");
+					LOGNOTE("MIDI-SYSEX: Assuming TX216/TX816 style performance sysex message because 4th byte is 0x04");
 
-						switch (par)
-						{
-						case 2: // Poly/Mono
-							LOGNOTE("MIDI-SYSEX: Set Poly/Mono %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setMonoMode(val ? true : false, nTG);
-							break;
-						case 3: // Pitch Bend Range
-							LOGNOTE("MIDI-SYSEX: Set Pitch Bend Range %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setPitchbendRange(val, nTG);
-							break;
-						case 4: // Pitch Bend Step
-							LOGNOTE("MIDI-SYSEX: Set Pitch Bend Step %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setPitchbendStep(val, nTG);
-							break;
-						case 5: // Portamento Time
-							LOGNOTE("MIDI-SYSEX: Set Portamento Time %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setPortamentoTime(val, nTG);
-							break;
-						case 6: // Portamento/Glissando
-							LOGNOTE("MIDI-SYSEX: Set Portamento/Glissando %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setPortamentoGlissando(val, nTG);
-							break;
-						case 7: // Portamento Mode
-							LOGNOTE("MIDI-SYSEX: Set Portamento Mode %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setPortamentoMode(val, nTG);
-							break;
-						case 9: // Mod Wheel Sensitivity
-						{
-							int scaled = (val * 99) / 15;
-							LOGNOTE("MIDI-SYSEX: Set Mod Wheel Sensitivity %d to %d (scaled %d)", nTG, val & 0x0F, scaled);
-							m_pSynthesizer->setModWheelRange(scaled, nTG);
-						}
+					switch (par)
+					{
+					case 2: // Poly/Mono
+						LOGNOTE("MIDI-SYSEX: Set Poly/Mono %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setMonoMode(val ? true : false, nTG);
 						break;
-						case 10: // Mod Wheel Assign
-							LOGNOTE("MIDI-SYSEX: Set Mod Wheel Assign %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setModWheelTarget(val, nTG);
-							break;
-						case 11: // Foot Controller Sensitivity
-						{
-							int scaled = (val * 99) / 15;
-							LOGNOTE("MIDI-SYSEX: Set Foot Controller Sensitivity %d to %d (scaled %d)", nTG, val & 0x0F, scaled);
-							m_pSynthesizer->setFootControllerRange(scaled, nTG);
-						}
+					case 3: // Pitch Bend Range
+						LOGNOTE("MIDI-SYSEX: Set Pitch Bend Range %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setPitchbendRange(val, nTG);
 						break;
-						case 12: // Foot Controller Assign
-							LOGNOTE("MIDI-SYSEX: Set Foot Controller Assign %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setFootControllerTarget(val, nTG);
-							break;
-						case 13: // Aftertouch Sensitivity
-						{
-							int scaled = (val * 99) / 15;
-							LOGNOTE("MIDI-SYSEX: Set Aftertouch Sensitivity %d to %d (scaled %d)", nTG, val & 0x0F, scaled);
-							m_pSynthesizer->setAftertouchRange(scaled, nTG);
-						}
+					case 4: // Pitch Bend Step
+						LOGNOTE("MIDI-SYSEX: Set Pitch Bend Step %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setPitchbendStep(val, nTG);
 						break;
-						case 14: // Aftertouch Assign
-							LOGNOTE("MIDI-SYSEX: Set Aftertouch Assign %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setAftertouchTarget(val, nTG);
-							break;
-						case 15: // Breath Controller Sensitivity
-						{
-							int scaled = (val * 99) / 15;
-							LOGNOTE("MIDI-SYSEX: Set Breath Controller Sensitivity %d to %d (scaled %d)", nTG, val & 0x0F, scaled);
-							m_pSynthesizer->setBreathControllerRange(scaled, nTG);
-						}
+					case 5: // Portamento Time
+						LOGNOTE("MIDI-SYSEX: Set Portamento Time %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setPortamentoTime(val, nTG);
 						break;
-						case 16: // Breath Controller Assign
-							LOGNOTE("MIDI-SYSEX: Set Breath Controller Assign %d to %d", nTG, val & 0x0F);
-							m_pSynthesizer->setBreathControllerTarget(val, nTG);
-							break;
-						case 26: // Audio Output Level Attenuator
-							{
-								LOGNOTE("MIDI-SYSEX: Set Audio Output Level Attenuator %d to %d", nTG, val & 0x0F);
-								// Example: F0 43 10 04 1A 00 F7 to F0 43 10 04 1A 07 F7
-								unsigned attenVal = val & 0x07;
-								// unsigned newVolume = (unsigned)(127.0 * pow(attenVal / 7.0, 2.0) + 0.5); // Logarithmic mapping
-								// But on the T816, there is an exponential (not logarithmic!) mapping, and 0 results in the same volume as 1:
-								// 7=127, 6=63, 5=31, 4=15, 3=7, 2=3, 1=1, 0=1
-								unsigned newVolume = (attenVal == 0) ? 0 : (127 >> (7 - attenVal));
-								if (newVolume == 0) newVolume = 1; // 0 is like 1 to avoid silence
-								m_pSynthesizer->SetVolume(newVolume, nTG);
-							}
-							break;
-						case 64: // Master Tuning
-							LOGNOTE("MIDI-SYSEX: Set Master Tuning");
-							// TX812 scales from -75 to +75 cents.
-							m_pSynthesizer->SetMasterTune(maplong(val, 1, 127, -37, 37), nTG); // Would need 37.5 here, due to wrong constrain on dexed_synth module?
-							break;
-						default:
-							// Unknown or unsupported parameter
-							LOGNOTE("MIDI-SYSEX: Unknown parameter %d for TG %d", par, nTG);
-							break;
-						}
+					case 6: // Portamento/Glissando
+						LOGNOTE("MIDI-SYSEX: Set Portamento/Glissando %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setPortamentoGlissando(val, nTG);
+						break;
+					case 7: // Portamento Mode
+						LOGNOTE("MIDI-SYSEX: Set Portamento Mode %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setPortamentoMode(val, nTG);
+						break;
+					case 9: // Mod Wheel Sensitivity
+					{
+						int scaled = (val * 99) / 15;
+						LOGNOTE("MIDI-SYSEX: Set Mod Wheel Sensitivity %d to %d (scaled %d)", nTG, val & 0x0F, scaled);
+						m_pSynthesizer->setModWheelRange(scaled, nTG);
 					}
-					else
+					break;
+					case 10: // Mod Wheel Assign
+						LOGNOTE("MIDI-SYSEX: Set Mod Wheel Assign %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setModWheelTarget(val, nTG);
+						break;
+					case 11: // Foot Controller Sensitivity
+					{
+						int scaled = (val * 99) / 15;
+						LOGNOTE("MIDI-SYSEX: Set Foot Controller Sensitivity %d to %d (scaled %d)", nTG, val & 0x0F, scaled);
+						m_pSynthesizer->setFootControllerRange(scaled, nTG);
+					}
+					break;
+					case 12: // Foot Controller Assign
+						LOGNOTE("MIDI-SYSEX: Set Foot Controller Assign %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setFootControllerTarget(val, nTG);
+						break;
+					case 13: // Aftertouch Sensitivity
 					{
-						HandleSystemExclusive(pMessage, nLength, nCable, nTG);
-						if (nLength == 5) {
-							break; // Send dump request only to the first TG that matches the MIDI channel requested via the SysEx message device ID
+						int scaled = (val * 99) / 15;
+						LOGNOTE("MIDI-SYSEX: Set Aftertouch Sensitivity %d to %d (scaled %d)", nTG, val & 0x0F, scaled);
+						m_pSynthesizer->setAftertouchRange(scaled, nTG);
+					}
+					break;
+					case 14: // Aftertouch Assign
+						LOGNOTE("MIDI-SYSEX: Set Aftertouch Assign %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setAftertouchTarget(val, nTG);
+						break;
+					case 15: // Breath Controller Sensitivity
+					{
+						int scaled = (val * 99) / 15;
+						LOGNOTE("MIDI-SYSEX: Set Breath Controller Sensitivity %d to %d (scaled %d)", nTG, val & 0x0F, scaled);
+						m_pSynthesizer->setBreathControllerRange(scaled, nTG);
+					}
+					break;
+					case 16: // Breath Controller Assign
+						LOGNOTE("MIDI-SYSEX: Set Breath Controller Assign %d to %d", nTG, val & 0x0F);
+						m_pSynthesizer->setBreathControllerTarget(val, nTG);
+						break;
+					case 26: // Audio Output Level Attenuator
+						{
+							LOGNOTE("MIDI-SYSEX: Set Audio Output Level Attenuator %d to %d", nTG, val & 0x0F);
+							// Example: F0 43 10 04 1A 00 F7 to F0 43 10 04 1A 07 F7
+							unsigned attenVal = val & 0x07;
+							// unsigned newVolume = (unsigned)(127.0 * pow(attenVal / 7.0, 2.0) + 0.5); // Logarithmic mapping
+							// But on the T816, there is an exponential (not logarithmic!) mapping, and 0 results in the same volume as 1:
+							// 7=127, 6=63, 5=31, 4=15, 3=7, 2=3, 1=1, 0=1
+							unsigned newVolume = (attenVal == 0) ? 0 : (127 >> (7 - attenVal));
+							if (newVolume == 0) newVolume = 1; // 0 is like 1 to avoid silence
+							m_pSynthesizer->SetVolume(newVolume, nTG);
 						}
+						break;
+					case 64: // Master Tuning
+						LOGNOTE("MIDI-SYSEX: Set Master Tuning");
+						// TX812 scales from -75 to +75 cents.
+						m_pSynthesizer->SetMasterTune(maplong(val, 1, 127, -37, 37), nTG); // Would need 37.5 here, due to wrong constrain on dexed_synth module?
+						break;
+					default:
+						// Unknown or unsupported parameter
+						LOGNOTE("MIDI-SYSEX: Unknown parameter %d for TG %d", par, nTG);
+						break;
+					}
+				}
+				else
+				{
+					HandleSystemExclusive(pMessage, nLength, nCable, nTG);
+					if (nLength == 5) {
+						break; // Send dump request only to the first TG that matches the MIDI channel requested via the SysEx message device ID
 					}
 				}
 			}
 		} else {
-			for (unsigned nTG = 0; nTG < m_pConfig->GetToneGenerators() && !bSystemCCHandled; nTG++) {
-				if (   m_ChannelMap[nTG] == ucChannel
-				    || m_ChannelMap[nTG] == OmniMode) {
-					switch (ucType)
+			// Decode the message once for all TGs receiving it. System
+			// messages and incomplete channel messages go to no TG.
+			u32 nTGMask = m_ChannelTGMask[ucChannel];
+			if (   ucStatus >= MIDI_SYSTEM_EXCLUSIVE_BEGIN
+			    || (   nLength < 3
+				&& ucType != MIDI_PROGRAM_CHANGE
+				&& ucType != MIDI_CHANNEL_AFTERTOUCH))
+			{
+				nTGMask = 0;
+			}
+			else if (ucType == MIDI_NOTE_ON && pMessage[2] == 0)
+			{
+				ucType = MIDI_NOTE_OFF;
+			}
+
+			s16 nPitchBend = 0;
+			if (ucType == MIDI_PITCH_BEND && nTGMask)
+			{
+				nPitchBend = pMessage[1];
+				nPitchBend |= (s16) pMessage[2] << 7;
+				nPitchBend -= 0x2000;
+			}
+
+			for (; nTGMask && !bSystemCCHandled; nTGMask &= nTGMask-1) {
+				unsigned nTG = __builtin_ctz (nTGMask);
+				switch (ucType)
+				{
+				case MIDI_NOTE_ON:
+					if (pMessage[2] <= 127)
 					{
-					case MIDI_NOTE_ON:
-						if (nLength < 3)
-						{
-							break;
-						}
-		
-						if (pMessage[2] > 0)
-						{
-							if (pMessage[2] <= 127)
-							{
-								m_pSynthesizer->keydown (pMessage[1],
-											 pMessage[2], nTG);
-							}
-						}
-						else
-						{
-							m_pSynthesizer->keyup (pMessage[1], nTG);
-						}
+						m_pSynthesizer->keydown (pMessage[1],
+									 pMessage[2], nTG);
+					}
+					break;
+	
+				case MIDI_NOTE_OFF:
+					m_pSynthesizer->keyup (pMessage[1], nTG);
+					break;
+	
+				case MIDI_CHANNEL_AFTERTOUCH:
+					
+					m_pSynthesizer->setAftertouch (pMessage[1], nTG);
+					m_pSynthesizer->ControllersRefresh (nTG);
+					break;
+						
+				case MIDI_CONTROL_CHANGE:
+					switch (pMessage[1])
+					{
+					case MIDI_CC_MODULATION:
+						m_pSynthesizer->setModWheel (pMessage[2], nTG);
+						m_pSynthesizer->ControllersRefresh (nTG);
 						break;
-		
-					case MIDI_NOTE_OFF:
-						if (nLength < 3)
-						{
-							break;
-						}
-		
-						m_pSynthesizer->keyup (pMessage[1], nTG);
+							
+					case MIDI_CC_FOOT_PEDAL:
+						m_pSynthesizer->setFootController (pMessage[2], nTG);
+						m_pSynthesizer->ControllersRefresh (nTG);
 						break;
-		
-					case MIDI_CHANNEL_AFTERTOUCH:
-						
-						m_pSynthesizer->setAftertouch (pMessage[1], nTG);
+
+					case MIDI_CC_PORTAMENTO_TIME:
+						m_pSynthesizer->setPortamentoTime (maplong (pMessage[2], 0, 127, 0, 99), nTG);
+						break;
+
+					case MIDI_CC_BREATH_CONTROLLER:
+						m_pSynthesizer->setBreathController (pMessage[2], nTG);
 						m_pSynthesizer->ControllersRefresh (nTG);
 						break;
 							
-					case MIDI_CONTROL_CHANGE:
-						if (nLength < 3)
+					case MIDI_CC_VOLUME:
+						m_pSynthesizer->SetVolume (pMessage[2], nTG);
+						break;
+	
+					case MIDI_CC_PAN_POSITION:
+						m_pSynthesizer->SetPan (pMessage[2], nTG);
+						break;
+	
+					case MIDI_CC_EXPRESSION:
+						if (m_nMIDIGlobalExpression == Disabled) {
+							// Expression is per channel only
+							m_pSynthesizer->SetExpression (pMessage[2], nTG);
+						}
+						break;
+	
+					case MIDI_CC_BANK_SELECT_MSB:
+						m_pSynthesizer->BankSelectMSB (pMessage[2], nTG);
+						break;
+	
+					case MIDI_CC_BANK_SELECT_LSB:
+						m_pSynthesizer->BankSelectLSB (pMessage[2], nTG);
+						break;
+	
+					case MIDI_CC_SUSTAIN:
+						m_pSynthesizer->setSustain (pMessage[2] >= 64, nTG);
+						break;
+
+					case MIDI_CC_SOSTENUTO:
+						m_pSynthesizer->setSostenuto (pMessage[2] >= 64, nTG);
+						break;
+
+					case MIDI_CC_PORTAMENTO:
+						m_pSynthesizer->setPortamentoMode (pMessage[2] >= 64, nTG);
+						break;
+
+					case MIDI_CC_HOLD2:
+						m_pSynthesizer->setHoldMode (pMessage[2] >= 64, nTG);
+						break;
+
+					case MIDI_CC_RESONANCE:
+						m_pSynthesizer->SetResonance (maplong (pMessage[2], 0, 127, 0, 99), nTG);
+						break;
+						
+					case MIDI_CC_FREQUENCY_CUTOFF:
+						m_pSynthesizer->SetCutoff (maplong (pMessage[2], 0, 127, 0, 99), nTG);
+						break;
+	
+					case MIDI_CC_REVERB_LEVEL:
+						m_pSynthesizer->SetReverbSend (maplong (pMessage[2], 0, 127, 0, 99), nTG);
+						break;
+	
+					case MIDI_CC_DETUNE_LEVEL:
+						if (pMessage[2] == 0)
 						{
-							break;
+							// 0 to 127, with 0 being no detune effect applied at all
+							m_pSynthesizer->SetMasterTune (0, nTG);
 						}
-		
-						switch (pMessage[1])
+						else
 						{
-						case MIDI_CC_MODULATION:
-							m_pSynthesizer->setModWheel (pMessage[2], nTG);
-							m_pSynthesizer->ControllersRefresh (nTG);
-							break;
-								
-						case MIDI_CC_FOOT_PEDAL:
-							m_pSynthesizer->setFootController (pMessage[2], nTG);
-							m_pSynthesizer->ControllersRefresh (nTG);
-							break;
-
-						case MIDI_CC_PORTAMENTO_TIME:
-							m_pSynthesizer->setPortamentoTime (maplong (pMessage[2], 0, 127, 0, 99), nTG);
-							break;
-
-						case MIDI_CC_BREATH_CONTROLLER:
-							m_pSynthesizer->setBreathController (pMessage[2], nTG);
-							m_pSynthesizer->ControllersRefresh (nTG);
-							break;
-								
-						case MIDI_CC_VOLUME:
-							m_pSynthesizer->SetVolume (pMessage[2], nTG);
-							break;
-		
-						case MIDI_CC_PAN_POSITION:
-							m_pSynthesizer->SetPan (pMessage[2], nTG);
-							break;
-		
-						case MIDI_CC_EXPRESSION:
-							if (m_nMIDIGlobalExpression == Disabled) {
-								// Expression is per channel only
-								m_pSynthesizer->SetExpression (pMessage[2], nTG);
-							}
-							break;
-		
-						case MIDI_CC_BANK_SELECT_MSB:
-							m_pSynthesizer->BankSelectMSB (pMessage[2], nTG);
-							break;
-		
-						case MIDI_CC_BANK_SELECT_LSB:
-							m_pSynthesizer->BankSelectLSB (pMessage[2], nTG);
-							break;
-		
-						case MIDI_CC_SUSTAIN:
-							m_pSynthesizer->setSustain (pMessage[2] >= 64, nTG);
-							break;
-
-						case MIDI_CC_SOSTENUTO:
-							m_pSynthesizer->setSostenuto (pMessage[2] >= 64, nTG);
-							break;
-
-						case MIDI_CC_PORTAMENTO:
-							m_pSynthesizer->setPortamentoMode (pMessage[2] >= 64, nTG);
-							break;
-
-						case MIDI_CC_HOLD2:
-							m_pSynthesizer->setHoldMode (pMessage[2] >= 64, nTG);
-							break;
-
-						case MIDI_CC_RESONANCE:
-							m_pSynthesizer->SetResonance (maplong (pMessage[2], 0, 127, 0, 99), nTG);
-							break;
-							
-						case MIDI_CC_FREQUENCY_CUTOFF:
-							m_pSynthesizer->SetCutoff (maplong (pMessage[2], 0, 127, 0, 99), nTG);
-							break;
-		
-						case MIDI_CC_REVERB_LEVEL:
-							m_pSynthesizer->SetReverbSend (maplong (pMessage[2], 0, 127, 0, 99), nTG);
-							break;
-		
-						case MIDI_CC_DETUNE_LEVEL:
-							if (pMessage[2] == 0)
-							{
-								// 0 to 127, with 0 being no detune effect applied at all
-								m_pSynthesizer->SetMasterTune (0, nTG);
-							}
-							else
-							{
-								// Scale to -99 to +99 cents
-								m_pSynthesizer->SetMasterTune (maplong (pMessage[2], 1, 127, -99, 99), nTG);
-							}
-							break;
-		
-						case MIDI_CC_ALL_SOUND_OFF:
-							m_pSynthesizer->panic (pMessage[2], nTG);
-							break;
-		
-						case MIDI_CC_ALL_NOTES_OFF:
-							// As per "MIDI 1.0 Detailed Specification" v4.2
-							// From "ALL NOTES OFF" states:
-							// "Receivers should ignore an All Notes Off message while Omni is on (Modes 1 & 2)"
-							if (!m_pConfig->GetIgnoreAllNotesOff () && m_ChannelMap[nTG] != OmniMode)
-							{
-								m_pSynthesizer->notesOff (pMessage[2], nTG);
-							}
-							break;
-
-						case MIDI_CC_OMNI_MODE_OFF:
-							// Sets to "Omni Off" mode
-							if (m_ChannelMap[nTG] == OmniMode) {
-								// Restore the previous channel if available, otherwise use current channel
-								u8 channelToRestore = (m_PreviousChannelMap[nTG] != Disabled) ? 
-									m_PreviousChannelMap[nTG] : ucChannel;
-								m_pSynthesizer->SetMIDIChannel(channelToRestore, nTG);
-								LOGDBG("Omni Mode Off: TG %d restored to MIDI channel %d", nTG, channelToRestore+1);
-							}
-							break;
-						
-						case MIDI_CC_OMNI_MODE_ON:
-							// Sets to "Omni On" mode
-							m_pSynthesizer->SetMIDIChannel(OmniMode, nTG);
-							LOGDBG("Omni Mode On: TG %d set to OMNI", nTG);
-							break;
-
-						case MIDI_CC_MONO_MODE_ON:
-							// Sets monophonic mode
-							m_pSynthesizer->setMonoMode(1, nTG);
-							LOGDBG("Mono Mode On: TG %d set to MONO", nTG);
-							break;
-
-						case MIDI_CC_POLY_MODE_ON:
-							// Sets polyphonic mode
-							m_pSynthesizer->setMonoMode(0, nTG);
-							LOGDBG("Poly Mode On: TG %d set to POLY", nTG);
-							break;
-
-						default:
-							// Check for system-level, cross-TG MIDI Controls, but only do it once.
-							// Also, if successfully handled, then no need to process other TGs,
-							// so it is possible to break out of the main TG loop too.
-							// Note: We handle this here so we get the TG MIDI channel checking.
-							if (!bSystemCCChecked) {
-								bSystemCCHandled = HandleMIDISystemCC(pMessage[1], pMessage[2]);
-								bSystemCCChecked = true;
-							}
-							break;
+							// Scale to -99 to +99 cents
+							m_pSynthesizer->SetMasterTune (maplong (pMessage[2], 1, 127, -99, 99), nTG);
 						}
 						break;
-		
-					case MIDI_PROGRAM_CHANGE:
-						// do program change only if enabled in config and not in "Performance Select Channel" mode
-						if( m_pConfig->GetMIDIRXProgramChange() && ( m_pSynthesizer->GetPerformanceSelectChannel() == Disabled) ) {
-							//printf("Program Change to %d (%d)\n", ucChannel, m_pSynthesizer->GetPerformanceSelectChannel());
-							m_pSynthesizer->ProgramChange (pMessage[1], nTG);
-						}
+	
+					case MIDI_CC_ALL_SOUND_OFF:
+						m_pSynthesizer->panic (pMessage[2], nTG);
 						break;
-		
-					case MIDI_PITCH_BEND: {
-						if (nLength < 3)
+	
+					case MIDI_CC_ALL_NOTES_OFF:
+						// As per "MIDI 1.0 Detailed Specification" v4.2
+						// From "ALL NOTES OFF" states:
+						// "Receivers should ignore an All Notes Off message while Omni is on (Modes 1 & 2)"
+						if (!m_pConfig->GetIgnoreAllNotesOff () && m_ChannelMap[nTG] != OmniMode)
 						{
-							break;
+							m_pSynthesizer->notesOff (pMessage[2], nTG);
+						}
+						break;
+
+					case MIDI_CC_OMNI_MODE_OFF:
+						// Sets to "Omni Off" mode
+						if (m_ChannelMap[nTG] == OmniMode) {
+							// Restore the previous channel if available, otherwise use current channel
+							u8 channelToRestore = (m_PreviousChannelMap[nTG] != Disabled) ? 
+								m_PreviousChannelMap[nTG] : ucChannel;
+							m_pSynthesizer->SetMIDIChannel(channelToRestore, nTG);
+							LOGDBG("Omni Mode Off: TG %d restored to MIDI channel %d", nTG, channelToRestore+1);
 						}
-		
-						s16 nValue = pMessage[1];
-						nValue |= (s16) pMessage[2] << 7;
-						nValue -= 0x2000;
-		
-						m_pSynthesizer->setPitchbend (nValue, nTG);
-						} break;
-		
+						break;
+					
+					case MIDI_CC_OMNI_MODE_ON:
+						// Sets to "Omni On" mode
+						m_pSynthesizer->SetMIDIChannel(OmniMode, nTG);
+						LOGDBG("Omni Mode On: TG %d set to OMNI", nTG);
+						break;
+
+					case MIDI_CC_MONO_MODE_ON:
+						// Sets monophonic mode
+						m_pSynthesizer->setMonoMode(1, nTG);
+						LOGDBG("Mono Mode On: TG %d set to MONO", nTG);
+						break;
+
+					case MIDI_CC_POLY_MODE_ON:
+						// Sets polyphonic mode
+						m_pSynthesizer->setMonoMode(0, nTG);
+						LOGDBG("Poly Mode On: TG %d set to POLY", nTG);
+						break;
+
 					default:
+						// Check for system-level, cross-TG MIDI Controls, but only do it once.
+						// Also, if successfully handled, then no need to process other TGs,
+						// so it is possible to break out of the main TG loop too.
+						// Note: We handle this here so we get the TG MIDI channel checking.
+						if (!bSystemCCChecked) {
+							bSystemCCHandled = HandleMIDISystemCC(pMessage[1], pMessage[2]);
+							bSystemCCChecked = true;
+						}
 						break;
 					}
+					break;
+	
+				case MIDI_PROGRAM_CHANGE:
+					// do program change only if enabled in config and not in "Performance Select Channel" mode
+					if( m_pConfig->GetMIDIRXProgramChange() && ( m_pSynthesizer->GetPerformanceSelectChannel() == Disabled) ) {
+						//printf("Program Change to %d (%d)\n", ucChannel, m_pSynthesizer->GetPerformanceSelectChannel());
+						m_pSynthesizer->ProgramChange (pMessage[1], nTG);
+					}
+					break;
+	
+				case MIDI_PITCH_BEND:
+					m_pSynthesizer->setPitchbend (nPitchBend, nTG);
+					break;
+	
+				default:
+					break;
 				}
 			}
 		}
@@ -713,6 +723,83 @@ void CMIDIDevice::AddDevice (const char *pDeviceName)
 	assert (!m_DeviceName.empty ());
 
 	s_DeviceMap.insert (std::pair<std::string, CMIDIDevice *> (pDeviceName, this));
+
+	// connect the MIDI Thru routes, for which both devices are known now
+	for (unsigned i = 0; i < m_pConfig->GetMIDIRoutes (); i++)
+	{
+		const CConfig::TMIDIRoute *pRoute = m_pConfig->GetMIDIRoute (i);
+
+		TDeviceMap::const_iterator In = s_DeviceMap.find (pRoute->In);
+		TDeviceMap::const_iterator Out = s_DeviceMap.find (pRoute->Out);
+		if (   In != s_DeviceMap.end ()
+		    && Out != s_DeviceMap.end ()
+		    && (In->second == this || Out->second == this))
+		{
+			In->second->AddThruRoute (Out->second, pRoute);
+		}
+	}
+}
+
+void CMIDIDevice::AddThruRoute (CMIDIDevice *pOut, const CConfig::TMIDIRoute *pRoute)
+{
+	assert (pOut);
+	assert (pRoute);
+	assert (m_nThruRoutes < CConfig::MaxMIDIRoutes);
+
+	TThruRoute &rRoute = m_ThruRoute[m_nThruRoutes];
+	rRoute.pOut = pOut;
+	rRoute.nChannel = pRoute->nChannel ? pRoute->nChannel-1 : OmniMode;
+	rRoute.nMessageMask = pRoute->nMessageMask;
+
+	// the route may be used by MIDIMessageHandler() from now on
+	DataMemBarrier ();
+	m_nThruRoutes++;
+
+	LOGNOTE ("MIDI Thru: %s -> %s", m_DeviceName.c_str (), pOut->m_DeviceName.c_str ());
+}
+
+unsigned CMIDIDevice::GetMessageClass (u8 ucStatus)
+{
+	switch (ucStatus >> 4)
+	{
+	case MIDI_NOTE_OFF:
+	case MIDI_NOTE_ON:
+	case MIDI_AFTERTOUCH:
+		return CConfig::MIDIMessageNotes;
+
+	case MIDI_CONTROL_CHANGE:
+		return CConfig::MIDIMessageControl;
+
+	case MIDI_PROGRAM_CHANGE:
+		return CConfig::MIDIMessageProgram;
+
+	case MIDI_CHANNEL_AFTERTOUCH:
+		return CConfig::MIDIMessageAftertouch;
+
+	case MIDI_PITCH_BEND:
+		return CConfig::MIDIMessagePitchBend;
+
+	default:
+		break;
+	}
+
+	switch (ucStatus)
+	{
+	case MIDI_SYSTEM_EXCLUSIVE_BEGIN:
+		return CConfig::MIDIMessageSysEx;
+
+	case MIDI_TIMING_CLOCK:
+		return CConfig::MIDIMessageClock;
+
+	case MIDI_ACTIVE_SENSING:
+		return CConfig::MIDIMessageActiveSensing;
+
+	default:
+		break;
+	}
+
+	// continued SysEx data does not start with a status byte
+	return ucStatus < 0x80 ? CConfig::MIDIMessageSysEx : CConfig::MIDIMessageSystem;
 }
 
 bool CMIDIDevice::HandleMIDISystemCC(const u8 ucCC, const u8 ucCCval)
@@ -872,3 +959,57 @@ void CMIDIDevice::SendSystemExclusiveVoice(uint8_t nVoice, const std::string& de
         LOGWARN("No device found in s_DeviceMap for name: %s", deviceName.c_str());
     }
 }
+
+// Dropout statistics reply:
+//   F0 7D 00 02
+//   <underruns> <overruns>	counts since start
+//   NN				number of events following, most recent first
+//   NN * <type> <age> <chunk> <voices> <queue>
+//   F7
+// type is 0 for an underrun and 1 for an overrun, age is in milliseconds,
+// chunk is the processing time of the chunk in microseconds, queue the number
+// of frames in the sound queue. All values are sent as 4 x 7 bits, LSB first.
+void CMIDIDevice::SendXRunStatistics (unsigned nCable)
+{
+	const CXRunCounter *pXRunCounter = m_pSynthesizer->GetXRunCounter ();
+	assert (pXRunCounter);
+
+	u8 Reply[4 + 2*4 + 1 + CXRunCounter::MaxEvents*5*4 + 1];
+	unsigned nLength = 0;
+
+	auto PutValue = [&Reply, &nLength] (unsigned nValue)
+	{
+		for (unsigned i = 0; i < 4; i++, nValue >>= 7)
+		{
+			Reply[nLength++] = nValue & 0x7F;
+		}
+	};
+
+	Reply[nLength++] = MIDI_SYSTEM_EXCLUSIVE_BEGIN;
+	Reply[nLength++] = 0x7D;
+	Reply[nLength++] = 0x00;
+	Reply[nLength++] = 0x02;
+
+	PutValue (pXRunCounter->GetCount (CXRunCounter::XRunUnderrun));
+	PutValue (pXRunCounter->GetCount (CXRunCounter::XRunOverrun));
+
+	unsigned nEventsPos = nLength++;
+	unsigned nEvents = 0;
+
+	unsigned nTicks = CTimer::GetClockTicks ();
+	CXRunCounter::TEvent Event;
+	for (; pXRunCounter->GetEvent (nEvents, &Event); nEvents++)
+	{
+		PutValue (Event.Type);
+		PutValue ((nTicks - Event.nTicks) / (CLOCKHZ / 1000));
+		PutValue (Event.nChunkMicros);
+		PutValue (Event.nActiveVoices);
+		PutValue (Event.nQueueFrames);
+	}
+
+	Reply[nEventsPos] = nEvents;
+	Reply[nLength++] = MIDI_SYSTEM_EXCLUSIVE_END;
+	assert (nLength <= sizeof Reply);
+
+	Send (Reply, nLength, nCable);
+}
@@ -65,6 +65,9 @@ protected:
 
 private:
 	bool HandleMIDISystemCC(const u8 ucCC, const u8 ucCCval);
+	void AddThruRoute (CMIDIDevice *pOut, const CConfig::TMIDIRoute *pRoute);
+	static unsigned GetMessageClass (u8 ucStatus);
+	void SendXRunStatistics (unsigned nCable);
 
 private:
 	CMiniDexed *m_pSynthesizer;
@@ -73,6 +76,7 @@ private:
 
 	u8 m_ChannelMap[CConfig::AllToneGenerators];
 	u8 m_PreviousChannelMap[CConfig::AllToneGenerators]; // Store previous channels for OMNI OFF restore
+	u32 m_ChannelTGMask[Channels];		// TGs receiving on a channel, including OMNI (bit n = TG n)
 	
 	unsigned m_nMIDISystemCCVol;
 	unsigned m_nMIDISystemCCPan;
@@ -82,6 +86,18 @@ private:
 
 	std::string m_DeviceName;
 
+	// MIDI Thru routes from this device, resolved from the device names in
+	// AddDevice(), so that forwarding needs no lookup per message
+	struct TThruRoute
+	{
+		CMIDIDevice *pOut;
+		unsigned nChannel;			// 0 .. 15, or OmniMode for all channels
+		unsigned nMessageMask;			// CConfig::TMIDIMessageClass bits
+	};
+
+	TThruRoute m_ThruRoute[CConfig::MaxMIDIRoutes];
+	volatile unsigned m_nThruRoutes;
+
 	typedef std::unordered_map<std::string, CMIDIDevice *> TDeviceMap;
 	static TDeviceMap s_DeviceMap;
 
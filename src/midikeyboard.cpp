@@ -22,14 +22,19 @@
 //
 #include "midikeyboard.h"
 #include <circle/devicenameservice.h>
+#include <circle/logger.h>
 #include <cstring>
 #include <assert.h>
 
+LOGMODULE ("midikeyboard");
+
 CMIDIKeyboard::CMIDIKeyboard (CMiniDexed *pSynthesizer, CConfig *pConfig, CUserInterface *pUI, unsigned nInstance)
 :	CMIDIDevice (pSynthesizer, pConfig, pUI),
 	m_nSysExIdx (0),
 	m_nInstance (nInstance),
-	m_pMIDIDevice (0)
+	m_pMIDIDevice (0),
+	m_nSendOverflows (0),
+	m_nSendOverflowsLogged (0)
 {
 	m_DeviceName.Format ("umidi%u", nInstance+1);
 
@@ -42,17 +47,31 @@ CMIDIKeyboard::~CMIDIKeyboard (void)
 
 void CMIDIKeyboard::Process (boolean bPlugAndPlayUpdated)
 {
-	while (!m_SendQueue.empty ())
+	// send the queued packets in batches, one bulk transfer each
+	u32 Batch[SendBatchSize];
+	unsigned nPackets = 0;
+	while (m_SendQueue.Get (&Batch[nPackets]))
 	{
-		TSendQueueEntry Entry = m_SendQueue.front ();
-		m_SendQueue.pop ();
-
-		if (m_pMIDIDevice)
+		if (   ++nPackets == SendBatchSize
+		    || m_SendQueue.IsEmpty ())
 		{
-			m_pMIDIDevice->SendPlainMIDI (Entry.nCable, Entry.pMessage, Entry.nLength);
+			if (m_pMIDIDevice)
+			{
+				m_pMIDIDevice->SendEventPackets (reinterpret_cast<const u8 *> (Batch),
+								 nPackets * sizeof Batch[0]);
+			}
+
+			nPackets = 0;
 		}
+	}
 
-		delete [] Entry.pMessage;
+	unsigned nOverflows = m_nSendOverflows;
+	if (nOverflows != m_nSendOverflowsLogged)
+	{
+		LOGWARN ("%s: %u messages dropped, send queue full",
+			 (const char *) m_DeviceName, nOverflows - m_nSendOverflowsLogged);
+
+		m_nSendOverflowsLogged = nOverflows;
 	}
 
 	if (!bPlugAndPlayUpdated)
@@ -75,14 +94,104 @@ void CMIDIKeyboard::Process (boolean bPlugAndPlayUpdated)
 
 void CMIDIKeyboard::Send (const u8 *pMessage, size_t nLength, unsigned nCable)
 {
-	TSendQueueEntry Entry;
-	Entry.pMessage = new u8[nLength];
-	Entry.nLength = nLength;
-	Entry.nCable = nCable;
+	assert (pMessage);
+
+	m_SendSpinLock.Acquire ();
+
+	// a message is queued completely or not at all
+	unsigned nPackets = EncodePackets (pMessage, nLength, nCable, false);
+	if (nPackets <= m_SendQueue.GetFree ())
+	{
+		EncodePackets (pMessage, nLength, nCable, true);
+	}
+	else
+	{
+		m_nSendOverflows++;
+	}
+
+	m_SendSpinLock.Release ();
+}
+
+// See "Universal Serial Bus Device Class Definition for MIDI Devices",
+// chapter 4 "USB-MIDI Event Packets". The Code Index Number (CIN) in the
+// low nibble of the header gives the number of valid MIDI bytes.
+unsigned CMIDIKeyboard::EncodePackets (const u8 *pMessage, size_t nLength, unsigned nCable, bool bPut)
+{
+	unsigned nPackets = 0;
+
+	bool bSysEx = false;
+	size_t i = 0;
+	while (i < nLength)
+	{
+		u8 ucStatus = pMessage[i];
+		u8 ucCIN;
+		size_t nBytes;
 
-	memcpy (Entry.pMessage, pMessage, nLength);
+		if (   ucStatus == 0xF0
+		    || bSysEx)
+		{
+			// SysEx is sent in chunks of 3 bytes, the last one ends it
+			bSysEx = true;
+			nBytes = 0;
+			while (   nBytes < 3
+			       && i + nBytes < nLength)
+			{
+				if (pMessage[i + nBytes++] == 0xF7)
+				{
+					bSysEx = false;
+					break;
+				}
+			}
+
+			ucCIN = bSysEx ? 0x4 : 0x4 + nBytes;	// starts or continues, or ends with 1..3 bytes
+		}
+		else if (ucStatus >= 0x80 && ucStatus < 0xF0)
+		{
+			ucCIN = ucStatus >> 4;
+			nBytes = ucCIN == 0xC || ucCIN == 0xD ? 2 : 3;
+		}
+		else if (ucStatus == 0xF1 || ucStatus == 0xF3)
+		{
+			ucCIN = 0x2;				// two-byte system common
+			nBytes = 2;
+		}
+		else if (ucStatus == 0xF2)
+		{
+			ucCIN = 0x3;				// three-byte system common
+			nBytes = 3;
+		}
+		else if (ucStatus >= 0xF4 && ucStatus <= 0xF7)
+		{
+			ucCIN = 0x5;				// single-byte system common
+			nBytes = 1;
+		}
+		else
+		{
+			ucCIN = 0xF;				// real-time or stray data byte
+			nBytes = 1;
+		}
+
+		if (i + nBytes > nLength)
+		{
+			break;					// incomplete message
+		}
+
+		if (bPut)
+		{
+			u32 nPacket = (nCable & 0xF) << 4 | ucCIN;
+			for (unsigned j = 0; j < nBytes; j++)
+			{
+				nPacket |= (u32) pMessage[i+j] << (8 * (j+1));
+			}
+
+			m_SendQueue.Put (nPacket);
+		}
+
+		nPackets++;
+		i += nBytes;
+	}
 
-	m_SendQueue.push (Entry);
+	return nPackets;
 }
 
 // Most packets will be passed straight onto the main MIDI message handler
@@ -25,11 +25,12 @@
 
 #include "mididevice.h"
 #include "config.h"
+#include "spscring.h"
 #include <circle/usb/usbmidi.h>
 #include <circle/device.h>
 #include <circle/string.h>
+#include <circle/spinlock.h>
 #include <circle/types.h>
-#include <queue>
 
 #define USB_SYSEX_BUFFER_SIZE (MAX_DX7_SYSEX_LENGTH+128) // Allow a bit spare to handle unexpected SysEx messages
 
@@ -51,13 +52,14 @@ private:
 	
 	void USBMIDIMessageHandler (u8 *pPacket, unsigned nLength, unsigned nCable, unsigned nDevice);
 
+	// converts a MIDI message to USB-MIDI event packets, which are put into
+	// m_SendQueue, if bPut is set, returns the number of packets
+	unsigned EncodePackets (const u8 *pMessage, size_t nLength, unsigned nCable, bool bPut);
+
 private:
-	struct TSendQueueEntry
-	{
-		u8	*pMessage;
-		size_t	 nLength;
-		unsigned nCable;
-	};
+	static const unsigned SendQueueSize = 2048;		// packets, holds a DX7 bank dump
+	static const unsigned SendBatchSize = 16;		// packets per transfer
+
 	uint8_t m_SysEx[USB_SYSEX_BUFFER_SIZE];
 	unsigned m_nSysExIdx;
 
@@ -67,7 +69,14 @@ private:
 
 	CUSBMIDIDevice * volatile m_pMIDIDevice;
 
-	std::queue<TSendQueueEntry> m_SendQueue;
+	// Outgoing USB-MIDI event packets, which are sent from Process(). The
+	// header is in the low byte, so that the packets are in memory order.
+	// Send() may be called from several devices, m_SendSpinLock serializes
+	// them.
+	CSpinLock m_SendSpinLock;
+	CSPSCRing<u32, SendQueueSize> m_SendQueue;
+	unsigned m_nSendOverflows;				// messages dropped, because the queue was full
+	unsigned m_nSendOverflowsLogged;
 };
 
 #endif
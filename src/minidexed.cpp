@@ -25,12 +25,14 @@
 #include <circle/sound/hdmisoundbasedevice.h>
 #include <circle/net/syslogdaemon.h>
 #include <circle/net/ipaddress.h>
+#include <circle/net/socket.h>
+#include <circle/net/in.h>
 #include <circle/gpiopin.h>
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
 #include "arm_float_to_q23.h"
-#include "arm_scale_zip_f32.h"
+#include "arm_scale_zip_q23.h"
 
 const char WLANFirmwarePath[] = "SD:firmware/";
 const char WLANConfigFile[]   = "SD:wpa_supplicant.conf";
@@ -54,11 +56,22 @@ CMiniDexed::CMiniDexed (CConfig *pConfig, CInterruptSystem *pInterrupt,
 	m_bQuadDAC8Chan (false),
 	m_pSoundDevice (0),
 	m_bChannelsSwapped (pConfig->GetChannelsSwapped ()),
+	m_nChunkStartTicks (0),
+	m_bSoundStarted (false),
 #ifdef ARM_ALLOW_MULTI_CORE
 //	m_nActiveTGsLog2 (0),
+	m_nAudioPipelineDepth (pConfig->GetAudioPipelineDepth ()),
+	m_nRenderSet (0),
+	m_nReverbFrames (0),
+	m_bReverbReturnValid (false),
+	m_RenderScheduler (pConfig->GetAudioCoreSleep ()),
+	m_bMIDIEventTiming (pConfig->GetMIDIEventTiming ()),
+	m_nRenderWindowStart (CTimer::GetClockTicks ()),
+	m_nRenderWindowEnd (m_nRenderWindowStart),
+	m_nRenderStartTicks (0),
+	m_nRenderJobs (0),
+	m_nRenderSpanTicks (0),
 #endif
-	m_GetChunkTimer ("GetChunk",
-			 1000000U * pConfig->GetChunkSize ()/2 / pConfig->GetSampleRate ()),
 	m_bProfileEnabled (m_pConfig->GetProfileEnabled ()),
 	m_pNet(nullptr),
 	m_pNetDevice(nullptr),
@@ -68,6 +81,7 @@ CMiniDexed::CMiniDexed (CConfig *pConfig, CInterruptSystem *pInterrupt,
 	m_bNetworkInit(false),
 	m_UDPMIDI(nullptr),
 	m_pmDNSPublisher (nullptr),
+	m_pTraceSocket (nullptr),
 	m_bSavePerformance (false),
 	m_bSavePerformanceNewFile (false),
 	m_bSetNewPerformance (false),
@@ -83,6 +97,47 @@ CMiniDexed::CMiniDexed (CConfig *pConfig, CInterruptSystem *pInterrupt,
 	m_nPolyphony = m_pConfig->GetPolyphony();
 	LOGNOTE("Tone Generators=%d, Polyphony=%d", m_nToneGenerators, m_nPolyphony);
 
+	// With the voice pool, each TG may play up to MaxNotes voices, as long as
+	// the pool has voices left. The pool never shrinks below the polyphony.
+	m_pVoicePool = nullptr;
+	unsigned nTGPolyphony = m_nPolyphony;
+	if (pConfig->GetVoicePool ())
+	{
+		nTGPolyphony = CConfig::MaxNotes;
+		m_pVoicePool = new CVoicePool (m_nToneGenerators, m_nPolyphony,
+					       m_nToneGenerators * CConfig::MaxNotes,
+					       pConfig->GetVoicePoolLoad ());
+		LOGNOTE ("Voice pool enabled, up to %u voices per TG", nTGPolyphony);
+	}
+
+	m_pLoadGovernor = nullptr;
+	m_LoadLevel = CLoadGovernor::LevelNormal;
+	m_nLoadCutTicks = 0;
+	if (pConfig->GetLoadGovernor ())
+	{
+		m_pLoadGovernor = new CLoadGovernor (pConfig->GetLoadGovernorHigh (),
+						     pConfig->GetLoadGovernorLow (),
+						     pConfig->GetLoadGovernorHold (),
+						     pConfig->GetLoadGovernorReverbOff ());
+	}
+
+	// the stages are measured against the duration of a chunk
+	static const char *ProfileStageName[ProfileStageUnknown] =
+		{"GetChunk", "RenderTG", "Mix", "Reverb", "Output", "WakeUp"};
+	unsigned nChunkMicros = 1000000U * pConfig->GetChunkSize ()/2 / pConfig->GetSampleRate ();
+	for (unsigned i = 0; i < ProfileStageUnknown; i++)
+	{
+		m_pProfileTimer[i] = nullptr;
+		if (m_bProfileEnabled)
+		{
+			m_pProfileTimer[i] = new CPerformanceTimer (ProfileStageName[i], nChunkMicros,
+								    pConfig->GetProfileWindow ());
+		}
+	}
+#ifdef ARM_ALLOW_MULTI_CORE
+	m_RenderScheduler.SetWakeUpTimer (m_pProfileTimer[ProfileStageWake]);
+#endif
+
 	for (unsigned i = 0; i < CConfig::AllToneGenerators; i++)
 	{
 		m_nVoiceBankID[i] = 0;
@@ -116,12 +171,15 @@ CMiniDexed::CMiniDexed (CConfig *pConfig, CInterruptSystem *pInterrupt,
 		
 		m_nReverbSend[i] = 0;
 
+		m_nVoicePriority[i] = 0;
+		m_nVoiceReserve[i] = 0;
+
 		// Active the required number of active TGs
 		if (i<m_nToneGenerators)
 		{
 			m_uchOPMask[i] = 0b111111;	// All operators on
 
-			m_pTG[i] = new CDexedAdapter (m_nPolyphony, pConfig->GetSampleRate ());
+			m_pTG[i] = new CDexedAdapter (nTGPolyphony, pConfig->GetSampleRate ());
 			assert (m_pTG[i]);
 
 			m_pTG[i]->setEngineType(pConfig->GetEngineType ());
@@ -233,6 +291,18 @@ CMiniDexed::CMiniDexed (CConfig *pConfig, CInterruptSystem *pInterrupt,
 	{
 		m_CoreStatus[nCore] = CoreStatusInit;
 	}
+
+	for (unsigned nTG = 0; nTG < CConfig::AllToneGenerators; nTG++)
+	{
+		m_nRenderTicks[nTG] = 0;
+		m_nRenderOrder[nTG] = nTG;
+	}
+
+	// the first chunk in pipelined mode is mixed from silence
+	memset (m_bOutputActive, 0, sizeof m_bOutputActive);
+
+	m_pRenderBuffers = nullptr;
+	m_nRenderFrames = 0;
 #endif
 
 	float masterVolNorm = (float)(pConfig->GetMasterVolume()) / 127.0f;
@@ -263,11 +333,40 @@ CMiniDexed::CMiniDexed (CConfig *pConfig, CInterruptSystem *pInterrupt,
 
 CMiniDexed::~CMiniDexed (void)
 {
+#ifdef ARM_ALLOW_MULTI_CORE
+	// stop the audio cores, before the objects they use go away
+	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	{
+		if (m_CoreStatus[nCore] != CoreStatusInit)
+		{
+			m_CoreStatus[nCore] = CoreStatusExit;
+			m_RenderScheduler.Wake ();
+
+			while (m_CoreStatus[nCore] != CoreStatusUnknown)
+			{
+				// just wait
+			}
+		}
+	}
+#endif
+
 	delete m_WLAN;
 	delete m_WPASupplicant;
 	delete m_UDPMIDI;
 	delete m_pFTPDaemon;
 	delete m_pmDNSPublisher;
+	delete m_pTraceSocket;
+	delete m_pVoicePool;
+	delete m_pLoadGovernor;
+
+#ifdef ARM_ALLOW_MULTI_CORE
+	delete [] m_pRenderBuffers;
+#endif
+
+	for (unsigned i = 0; i < ProfileStageUnknown; i++)
+	{
+		delete m_pProfileTimer[i];
+	}
 }
 
 bool CMiniDexed::Initialize (void)
@@ -365,6 +464,15 @@ bool CMiniDexed::Initialize (void)
 
 	m_nQueueSizeFrames = m_pSoundDevice->GetQueueSizeFrames ();
 
+#ifdef ARM_ALLOW_MULTI_CORE
+	if (!AllocateRenderBuffers (m_nQueueSizeFrames / 2, Channels))
+	{
+		LOGERR ("Cannot allocate render buffers");
+
+		return false;
+	}
+#endif
+
 	m_pSoundDevice->Start ();
 
 #ifdef ARM_ALLOW_MULTI_CORE
@@ -456,9 +564,31 @@ void CMiniDexed::Process (bool bPlugAndPlayUpdated)
 		pScheduler->Yield();
 	}
 		
+	m_XRunCounter.Dump ();
+
+	if (m_pVoicePool)
+	{
+		m_pVoicePool->Dump ();
+	}
+
+	if (m_pLoadGovernor)
+	{
+		m_pLoadGovernor->Dump ();
+	}
+
+#ifdef AUDIO_TRACE
+	if (m_pTraceSocket)
+	{
+		CTrace::Drain (SendTracePacket, this);
+	}
+#endif
+
 	if (m_bProfileEnabled)
 	{
-		m_GetChunkTimer.Dump ();
+		for (unsigned i = 0; i < ProfileStageUnknown; i++)
+		{
+			m_pProfileTimer[i]->Dump ();
+		}
 		pScheduler->Yield();
 	}
 	if (m_pNet) {
@@ -474,6 +604,10 @@ void CMiniDexed::Run (unsigned nCore)
 {
 	assert (1 <= nCore && nCore < CORES);
 
+	TRACE (TraceCoreStart, nCore);
+
+	CRenderScheduler::InitCore ();
+
 	if (nCore == 1)
 	{
 		m_CoreStatus[nCore] = CoreStatusIdle;			// core 1 ready
@@ -489,45 +623,244 @@ void CMiniDexed::Run (unsigned nCore)
 
 		while (m_CoreStatus[nCore] != CoreStatusExit)
 		{
-			ProcessSound ();
+			if (!ProcessSound ())
+			{
+				m_RenderScheduler.Sleep ();		// until the sound queue has drained
+			}
 		}
+
+		m_CoreStatus[nCore] = CoreStatusUnknown;
 	}
 	else								// core 2 and 3
 	{
-		while (1)
+		m_CoreStatus[nCore] = CoreStatusIdle;			// ready to take jobs
+
+		// take render jobs, as soon as core 1 submits them
+		while (m_CoreStatus[nCore] != CoreStatusExit)
 		{
-			m_CoreStatus[nCore] = CoreStatusIdle;		// ready to be kicked
-			while (m_CoreStatus[nCore] == CoreStatusIdle)
+			if (!m_RenderScheduler.ProcessJob (nCore))
 			{
-				// just wait
+				m_RenderScheduler.WaitForJob ();
 			}
+		}
+
+		m_CoreStatus[nCore] = CoreStatusUnknown;
+	}
+}
 
-			// now kicked from core 1
+// All render buffers are taken from one block. The block starts at a cache
+// line and the buffers are padded to whole cache lines, so that no line is
+// shared by buffers, which are written from different cores.
+bool CMiniDexed::AllocateRenderBuffers (unsigned nFrames, unsigned nChannels)
+{
+	assert (!m_pRenderBuffers);
+	assert (0 < nFrames && nFrames <= CConfig::MaxChunkSize);
 
-			if (m_CoreStatus[nCore] == CoreStatusExit)
-			{
-				m_CoreStatus[nCore] = CoreStatusUnknown;
+	const size_t CacheLineSize = 64;
+	auto Padded = [CacheLineSize] (size_t nBytes)
+		{ return (nBytes + CacheLineSize-1) & ~(CacheLineSize-1); };
 
-				break;
-			}
+	size_t nLevelSize = Padded (nFrames * sizeof (float32_t));
+	size_t nOutputSize = Padded (nFrames * nChannels * sizeof (int32_t));
+	size_t nSize =   m_nAudioPipelineDepth * m_nToneGenerators * nLevelSize
+		       + nOutputSize + 2 * nLevelSize;
 
-			assert (m_CoreStatus[nCore] == CoreStatusBusy);
+	m_pRenderBuffers = new u8[nSize + CacheLineSize-1];
+	if (!m_pRenderBuffers)
+	{
+		return false;
+	}
 
-			// process the TGs, assigned to this core (2 or 3)
+	u8 *pBuffer = reinterpret_cast<u8 *> (Padded (reinterpret_cast<uintptr> (m_pRenderBuffers)));
+	memset (pBuffer, 0, nSize);		// the first chunk in pipelined mode is mixed from silence
 
-			assert (m_nFramesToProcess <= m_pConfig->MaxChunkSize);
-			unsigned nTG = m_pConfig->GetTGsCore1() + (nCore-2)*m_pConfig->GetTGsCore23();
-			for (unsigned i = 0; i < m_pConfig->GetTGsCore23(); i++, nTG++)
+	// only the sets in use by the configured pipeline depth and the
+	// configured TGs get a buffer, the other pointers stay null
+	for (unsigned nSet = 0; nSet < CConfig::MaxAudioPipelineDepth; nSet++)
+	{
+		for (unsigned nTG = 0; nTG < CConfig::AllToneGenerators; nTG++)
+		{
+			if (nSet < m_nAudioPipelineDepth && nTG < m_nToneGenerators)
 			{
-				assert (nTG < CConfig::AllToneGenerators);
-				if (nTG < m_pConfig->GetToneGenerators())
-				{
-					assert (m_pTG[nTG]);
-					m_pTG[nTG]->getSamples (m_OutputLevel[nTG],m_nFramesToProcess);
-				}
+				m_pOutputLevel[nSet][nTG] = reinterpret_cast<float32_t *> (pBuffer);
+				pBuffer += nLevelSize;
+			}
+			else
+			{
+				m_pOutputLevel[nSet][nTG] = nullptr;
 			}
 		}
 	}
+
+	m_pOutputBuffer = reinterpret_cast<int32_t *> (pBuffer);
+	pBuffer += nOutputSize;
+
+	for (unsigned i = 0; i < 2; i++)
+	{
+		m_pReverbBuffer[i] = reinterpret_cast<float32_t *> (pBuffer);
+		pBuffer += nLevelSize;
+	}
+
+	m_nRenderFrames = nFrames;
+
+	LOGNOTE ("%u KB render buffers for %u frames", (unsigned) (nSize / 1024), nFrames);
+
+	return true;
+}
+
+// Submits the TGs to the render scheduler, most expensive first, so that the
+// cores pulling the jobs end up with about the same amount of work. The cost
+// of a TG is the duration of its previous getSamples() call, which follows
+// the number of active voices and the engine type.
+void CMiniDexed::ScheduleToneGenerators (void)
+{
+	// insertion sort, the order is mostly unchanged from the previous chunk
+	for (unsigned i = 1; i < m_nToneGenerators; i++)
+	{
+		unsigned nTG = m_nRenderOrder[i];
+		unsigned j = i;
+		for (; j > 0 && m_nRenderTicks[m_nRenderOrder[j-1]] < m_nRenderTicks[nTG]; j--)
+		{
+			m_nRenderOrder[j] = m_nRenderOrder[j-1];
+		}
+		m_nRenderOrder[j] = nTG;
+	}
+
+	// With MIDIEventTiming, the MIDI events, which arrived since the previous
+	// chunk has been scheduled, are placed into this chunk at their relative
+	// time. Otherwise all queued events are applied at the start of the chunk.
+	m_nRenderWindowStart = m_nRenderWindowEnd;
+	m_nRenderWindowEnd = CTimer::GetClockTicks ();
+
+	m_nRenderStartTicks = m_nRenderWindowEnd;
+	m_nRenderJobs.fetch_add (m_nToneGenerators);
+
+	for (unsigned i = 0; i < m_nToneGenerators; i++)
+	{
+		m_RenderScheduler.Submit (RenderToneGenerator, m_nRenderOrder[i], this);
+	}
+}
+
+void CMiniDexed::RenderToneGenerator (unsigned nTG, unsigned nCore, void *pParam)
+{
+	CMiniDexed *pThis = static_cast<CMiniDexed *> (pParam);
+	assert (pThis);
+
+	assert (nTG < CConfig::AllToneGenerators);
+	assert (pThis->m_pTG[nTG]);
+	assert (pThis->m_nFramesToProcess <= pThis->m_nRenderFrames);
+
+	float32_t *pOutputLevel = pThis->m_pOutputLevel[pThis->m_nRenderSet][nTG];
+	assert (pOutputLevel);
+	bool *pActive = &pThis->m_bOutputActive[pThis->m_nRenderSet][nTG];
+
+	// Silent TGs are neither rendered nor mixed. Their output buffer is
+	// cleared once, so that it can still be read directly (Quad DAC mode).
+	if (pThis->m_pTG[nTG]->isSilent ())
+	{
+		if (*pActive)
+		{
+			memset (pOutputLevel, 0, pThis->m_nFramesToProcess * sizeof (float32_t));
+
+			*pActive = false;
+		}
+
+		pThis->m_nRenderTicks[nTG] = 0;
+
+		pThis->RenderJobDone ();
+
+		return;
+	}
+
+	TRACE (TraceRenderBegin, nTG);
+
+	if (pThis->m_bProfileEnabled)
+	{
+		pThis->m_pProfileTimer[ProfileStageRender]->Start ();
+	}
+
+	unsigned nStartTicks = CTimer::GetClockTicks ();
+
+	if (pThis->m_bMIDIEventTiming)
+	{
+		pThis->m_pTG[nTG]->getSamples (pOutputLevel, pThis->m_nFramesToProcess,
+					       pThis->m_nRenderWindowStart, pThis->m_nRenderWindowEnd);
+	}
+	else
+	{
+		pThis->m_pTG[nTG]->getSamples (pOutputLevel, pThis->m_nFramesToProcess);
+	}
+	*pActive = true;
+
+	pThis->m_nRenderTicks[nTG] = CTimer::GetClockTicks () - nStartTicks;
+
+	if (pThis->m_bProfileEnabled)
+	{
+		pThis->m_pProfileTimer[ProfileStageRender]->Stop ();
+	}
+
+	TRACE (TraceRenderEnd, nTG);
+
+	pThis->RenderJobDone ();
+}
+
+void CMiniDexed::ProcessReverb (unsigned nJob, unsigned nCore, void *pParam)
+{
+	CMiniDexed *pThis = static_cast<CMiniDexed *> (pParam);
+	assert (pThis);
+
+	unsigned nFrames = pThis->m_nReverbFrames;
+	assert (nFrames <= pThis->m_nRenderFrames);
+	float32_t **ReverbBuffer = pThis->m_pReverbBuffer;
+
+	float32_t *ReverbSendBuffer[2];
+	pThis->reverb_send_mixer->getBuffers(ReverbSendBuffer);
+
+	TRACE (TraceReverbBegin, 0);
+
+	if (pThis->m_bProfileEnabled)
+	{
+		pThis->m_pProfileTimer[ProfileStageReverb]->Start ();
+	}
+
+	pThis->m_ReverbSpinLock.Acquire ();
+
+	// no output, if the reverb has been disabled after this job has been
+	// submitted or if input and tail are silent
+	pThis->m_bReverbReturnValid =
+		pThis->reverb->doReverb(ReverbSendBuffer[0],ReverbSendBuffer[1],ReverbBuffer[0], ReverbBuffer[1],nFrames);
+
+	if (pThis->m_bReverbReturnValid)
+	{
+		// scale down the reverb buffers by reverb level
+		arm_scale_f32(ReverbBuffer[0], pThis->reverb->get_level(), ReverbBuffer[0], nFrames);
+		arm_scale_f32(ReverbBuffer[1], pThis->reverb->get_level(), ReverbBuffer[1], nFrames);
+	}
+
+	pThis->m_ReverbSpinLock.Release ();
+
+	if (pThis->m_bProfileEnabled)
+	{
+		pThis->m_pProfileTimer[ProfileStageReverb]->Stop ();
+	}
+
+	TRACE (TraceReverbEnd, 0);
+
+	pThis->RenderJobDone ();
+}
+
+// The job, which completes the rendering of a chunk, takes the render span.
+// The reverb job is submitted during the mix and may be done later, in which
+// case the span is taken again up to its end.
+void CMiniDexed::RenderJobDone (void)
+{
+	assert (m_nRenderJobs.load () > 0);
+
+	if (m_nRenderJobs.fetch_sub (1) == 1)
+	{
+		m_nRenderSpanTicks.store (CTimer::GetClockTicks () - m_nRenderStartTicks,
+					  std::memory_order_relaxed);
+	}
 }
 
 #endif
@@ -748,6 +1081,40 @@ void CMiniDexed::SetReverbSend (unsigned nReverbSend, unsigned nTG)
 	m_UI.ParameterChanged ();
 }
 
+void CMiniDexed::SetVoicePriority (unsigned nPriority, unsigned nTG)
+{
+	nPriority=constrain((int)nPriority,0,(int)CVoicePool::MaxPriority);
+
+	assert (nTG < CConfig::AllToneGenerators);
+	if (nTG >= m_nToneGenerators) return;  // Not an active TG
+
+	m_nVoicePriority[nTG] = nPriority;
+
+	if (m_pVoicePool)
+	{
+		m_pVoicePool->SetPriority (nPriority, nTG);
+	}
+
+	m_UI.ParameterChanged ();
+}
+
+void CMiniDexed::SetVoiceReserve (unsigned nVoices, unsigned nTG)
+{
+	nVoices=constrain((int)nVoices,0,(int)CConfig::MaxNotes);
+
+	assert (nTG < CConfig::AllToneGenerators);
+	if (nTG >= m_nToneGenerators) return;  // Not an active TG
+
+	m_nVoiceReserve[nTG] = nVoices;
+
+	if (m_pVoicePool)
+	{
+		m_pVoicePool->SetReserve (nVoices, nTG);
+	}
+
+	m_UI.ParameterChanged ();
+}
+
 void CMiniDexed::SetMasterTune (int nMasterTune, unsigned nTG)
 {
 	nMasterTune=constrain((int)nMasterTune,-99,99);
@@ -865,6 +1232,21 @@ void CMiniDexed::keydown (int16_t pitch, uint8_t velocity, unsigned nTG)
 	pitch = ApplyNoteLimits (pitch, nTG);
 	if (pitch >= 0)
 	{
+		if (m_pVoicePool)
+		{
+			unsigned nStealTG;
+			if (!m_pVoicePool->Allocate (nTG, &nStealTG))
+			{
+				return;
+			}
+
+			if (nStealTG != CVoicePool::NoTG)
+			{
+				assert (m_pTG[nStealTG]);
+				m_pTG[nStealTG]->stealVoice ();
+			}
+		}
+
 		m_pTG[nTG]->keydown (pitch, velocity);
 	}
 }
@@ -995,6 +1377,45 @@ void CMiniDexed::ControllersRefresh (unsigned nTG)
 	m_pTG[nTG]->ControllersRefresh ();
 }
 
+// The counts are sampled by the rendering cores after each chunk.
+unsigned CMiniDexed::GetActiveVoices (void)
+{
+	unsigned nVoices = 0;
+	for (unsigned nTG = 0; nTG < m_nToneGenerators; nTG++)
+	{
+		assert (m_pTG[nTG]);
+		nVoices += m_pTG[nTG]->getVoicesPlaying ();
+	}
+
+	return nVoices;
+}
+
+CPerformanceTimer *CMiniDexed::GetProfileTimer (TProfileStage Stage)
+{
+	assert (Stage < ProfileStageUnknown);
+
+	return m_pProfileTimer[Stage];
+}
+
+const CXRunCounter *CMiniDexed::GetXRunCounter (void) const
+{
+	return &m_XRunCounter;
+}
+
+#ifdef AUDIO_TRACE
+
+void CMiniDexed::SendTracePacket (const void *pPacket, unsigned nLength, void *pParam)
+{
+	CMiniDexed *pThis = static_cast<CMiniDexed *> (pParam);
+	assert (pThis);
+	assert (pThis->m_pTraceSocket);
+
+	// packets are dropped, if the network is busy
+	pThis->m_pTraceSocket->Send (pPacket, nLength, MSG_DONTWAIT);
+}
+
+#endif
+
 void CMiniDexed::SetParameter (TParameter Parameter, int nValue)
 {
 	assert (reverb);
@@ -1132,6 +1553,9 @@ void CMiniDexed::SetTGParameter (TTGParameter Parameter, int nValue, unsigned nT
 
 	case TGParameterReverbSend:	SetReverbSend (nValue, nTG);	break;
 
+	case TGParameterVoicePriority:	SetVoicePriority (nValue, nTG);	break;
+	case TGParameterVoiceReserve:	SetVoiceReserve (nValue, nTG);	break;
+
 	default:
 		assert (0);
 		break;
@@ -1181,7 +1605,9 @@ int CMiniDexed::GetTGParameter (TTGParameter Parameter, unsigned nTG)
 	case TGParameterATPitch:					return getModController(3, 1,  nTG); 
 	case TGParameterATAmplitude:				return getModController(3, 2,  nTG); 
 	case TGParameterATEGBias:					return getModController(3, 3,  nTG); 
-	
+
+	case TGParameterVoicePriority:	return m_nVoicePriority[nTG];
+	case TGParameterVoiceReserve:	return m_nVoiceReserve[nTG];
 	
 	default:
 		assert (0);
@@ -1263,42 +1689,96 @@ std::string CMiniDexed::GetVoiceName (unsigned nTG)
 	return Result;
 }
 
+// Writes a processed chunk to the sound device and accounts for dropouts.
+// The queue has run empty (and silence has been played), if it is empty now,
+// except before the first chunk. Nothing is logged here, see Process().
+void CMiniDexed::WriteSound (const void *pBuffer, size_t nBytes)
+{
+	assert (m_pSoundDevice);
+
+	unsigned nQueueFrames = m_pSoundDevice->GetQueueFramesAvail ();
+
+	TRACE (TraceWriteBegin, nQueueFrames);
+
+	if (   !nQueueFrames
+	    && m_bSoundStarted)
+	{
+		TRACE (TraceXRun, CXRunCounter::XRunUnderrun);
+		m_XRunCounter.Record (CXRunCounter::XRunUnderrun,
+				      (CTimer::GetClockTicks () - m_nChunkStartTicks) / (CLOCKHZ / 1000000),
+				      GetActiveVoices (), nQueueFrames);
+	}
+
+	if (m_pSoundDevice->Write (pBuffer, nBytes) != (int) nBytes)
+	{
+		TRACE (TraceXRun, CXRunCounter::XRunOverrun);
+		m_XRunCounter.Record (CXRunCounter::XRunOverrun,
+				      (CTimer::GetClockTicks () - m_nChunkStartTicks) / (CLOCKHZ / 1000000),
+				      GetActiveVoices (), nQueueFrames);
+	}
+
+	m_bSoundStarted = true;
+
+	TRACE (TraceWriteEnd, 0);
+}
+
 #ifndef ARM_ALLOW_MULTI_CORE
 
-void CMiniDexed::ProcessSound (void)
+bool CMiniDexed::ProcessSound (void)
 {
 	assert (m_pSoundDevice);
 
 	unsigned nFrames = m_nQueueSizeFrames - m_pSoundDevice->GetQueueFramesAvail ();
 	if (nFrames >= m_nQueueSizeFrames/2)
 	{
+		m_nChunkStartTicks = CTimer::GetClockTicks ();
+
+		TRACE (TraceChunkBegin, 0);
+
 		if (m_bProfileEnabled)
 		{
-			m_GetChunkTimer.Start ();
+			m_pProfileTimer[ProfileStageChunk]->Start ();
 		}
 
 		float32_t SampleBuffer[nFrames];
-		m_pTG[0]->getSamples (SampleBuffer, nFrames);
+		if (!m_pTG[0]->isSilent ())
+		{
+			m_pTG[0]->getSamples (SampleBuffer, nFrames);
+		}
+		else
+		{
+			arm_fill_f32 (0.0f, SampleBuffer, nFrames);
+		}
 
 		// Convert single float array (mono) to int16 array
 		int32_t tmp_int[nFrames];
 		arm_float_to_q23(SampleBuffer,tmp_int,nFrames);
 
-		if (m_pSoundDevice->Write (tmp_int, sizeof(tmp_int)) != (int) sizeof(tmp_int))
+		WriteSound (tmp_int, sizeof(tmp_int));
+
+		if (m_bProfileEnabled)
 		{
-			LOGERR ("Sound data dropped");
+			m_pProfileTimer[ProfileStageChunk]->Stop ();
 		}
 
-		if (m_bProfileEnabled)
+		if (m_pVoicePool)
 		{
-			m_GetChunkTimer.Stop ();
+			m_pVoicePool->SetVoices (m_pTG[0]->getVoices (), 0);
 		}
+
+		UpdateLoad (nFrames);
+
+		TRACE (TraceChunkEnd, 0);
+
+		return true;
 	}
+
+	return false;
 }
 
 #else	// #ifdef ARM_ALLOW_MULTI_CORE
 
-void CMiniDexed::ProcessSound (void)
+bool CMiniDexed::ProcessSound (void)
 {
 	assert (m_pSoundDevice);
 	assert (m_pConfig);
@@ -1310,37 +1790,52 @@ void CMiniDexed::ProcessSound (void)
 		// as the tg_mixer cannot process more
 		nFrames = m_nQueueSizeFrames / 2;
 
+		m_nChunkStartTicks = CTimer::GetClockTicks ();
+
+		TRACE (TraceChunkBegin, 0);
+
 		if (m_bProfileEnabled)
 		{
-			m_GetChunkTimer.Start ();
+			m_pProfileTimer[ProfileStageChunk]->Start ();
 		}
 
-		m_nFramesToProcess = nFrames;
-
-		// kick secondary cores
-		for (unsigned nCore = 2; nCore < CORES; nCore++)
+		// render the TGs on all audio cores, core 1 takes part too
+		assert (nFrames <= m_nRenderFrames);
+		unsigned nMixSet = m_nRenderSet;
+		if (m_nAudioPipelineDepth > 1)
 		{
-			assert (m_CoreStatus[nCore] == CoreStatusIdle);
-			m_CoreStatus[nCore] = CoreStatusBusy;
-		}
+			// The TGs of this chunk have been rendered, while the previous
+			// chunk was mixed. Start rendering the next chunk into the
+			// other set, while this one is mixed and written below.
+			TRACE (TraceWaitBegin, 0);
+			m_RenderScheduler.WaitIdle (1);
+			TRACE (TraceWaitEnd, 0);
+
+			m_nRenderSet ^= 1;
 
-		// process the TGs assigned to core 1
-		assert (nFrames <= CConfig::MaxChunkSize);
-		for (unsigned i = 0; i < m_pConfig->GetTGsCore1(); i++)
+			m_nFramesToProcess = nFrames;
+			ScheduleToneGenerators ();
+		}
+		else
 		{
-			assert (m_pTG[i]);
-			m_pTG[i]->getSamples (m_OutputLevel[i], nFrames);
+			m_nFramesToProcess = nFrames;
+			ScheduleToneGenerators ();
+			TRACE (TraceWaitBegin, 0);
+			m_RenderScheduler.WaitIdle (1);
+			TRACE (TraceWaitEnd, 0);
 		}
 
-		// wait for cores 2 and 3 to complete their work
-		for (unsigned nCore = 2; nCore < CORES; nCore++)
+		if (m_pVoicePool)
 		{
-			while (m_CoreStatus[nCore] != CoreStatusIdle)
+			for (unsigned nTG = 0; nTG < m_nToneGenerators; nTG++)
 			{
-				// just wait
+				m_pVoicePool->SetVoices (m_pTG[nTG]->getVoices (), nTG);
 			}
 		}
 
+		float32_t **OutputLevel = m_pOutputLevel[nMixSet];
+		const bool *pOutputActive = m_bOutputActive[nMixSet];
+
 		//
 		// Audio signal path after tone generators starts here
 		//
@@ -1352,35 +1847,31 @@ void CMiniDexed::ProcessSound (void)
 			// No mixing is performed by MiniDexed, sound is output in 8 channels.
 			// Note: one TG per audio channel; output=mono; no processing.
 			const int Channels = 8;  // One TG per channel
-			float32_t tmp_float[nFrames*Channels];
-			int32_t tmp_int[nFrames*Channels];
-
-			// Convert dual float array (8 chan) to single int16 array (8 chan)
-			for(uint16_t i=0; i<nFrames;i++)
+			assert (nFrames <= m_nRenderFrames);
+			int32_t *tmp_int = m_pOutputBuffer;
+			const size_t nBytes = nFrames*Channels * sizeof (int32_t);
+
+			// Convert 8 float arrays (one per TG) to single int24 array (8 chan).
+			// TGs will alternate on L/R channels for each output reading
+			// directly from the TG OutputLevel buffer with no additional
+			// processing. This also prevents the PCM510x analog mute.
+			const float32_t *pChannel[Channels];
+			for (uint8_t tg = 0; tg < Channels; tg++)
 			{
-				// TGs will alternate on L/R channels for each output
-				// reading directly from the TG OutputLevel buffer with
-				// no additional processing.
-				for (uint8_t tg = 0; tg < Channels; tg++)
-				{
-					tmp_float[(i*Channels)+tg]=m_OutputLevel[tg][i] * nMasterVolume;
-				}
+				pChannel[tg] = OutputLevel[tg];
 			}
-
-			arm_float_to_q23(tmp_float,tmp_int,nFrames*Channels);
-
-			// Prevent PCM510x analog mute from kicking in
-			for (uint8_t tg = 0; tg < Channels; tg++) 
+			if (m_bProfileEnabled)
 			{
-				if (tmp_int[(nFrames - 1) * Channels + tg] == 0)
-				{
-					tmp_int[(nFrames - 1) * Channels + tg]++;
-				}
+				m_pProfileTimer[ProfileStageOutput]->Start ();
 			}
-			
-			if (m_pSoundDevice->Write (tmp_int, sizeof(tmp_int)) != (int) sizeof(tmp_int))
+
+			arm_scale_zip8_q23(pChannel, nMasterVolume, tmp_int, nFrames);
+
+			WriteSound (tmp_int, nBytes);
+
+			if (m_bProfileEnabled)
 			{
-				LOGERR ("Sound data dropped");
+				m_pProfileTimer[ProfileStageOutput]->Stop ();
 			}
 		}
 		else
@@ -1389,48 +1880,94 @@ void CMiniDexed::ProcessSound (void)
 			uint8_t indexL=0, indexR=1;
 
 			// BEGIN TG mixing
-			float32_t tmp_float[nFrames*2];
-			int32_t tmp_int[nFrames*2];
+			assert (nFrames <= m_nRenderFrames);
+			int32_t *tmp_int = m_pOutputBuffer;
+			const size_t nBytes = nFrames*2 * sizeof (int32_t);
 
 			// get the mix buffer of all TGs
 			float32_t *SampleBuffer[2];
 			tg_mixer->getBuffers(SampleBuffer);
 
-			tg_mixer->zeroFill();
+			TRACE (TraceMixBegin, 0);
 
-			for (uint8_t i = 0; i < m_nToneGenerators; i++)
+			if (m_bProfileEnabled)
 			{
-				tg_mixer->doAddMix(i,m_OutputLevel[i]);
+				m_pProfileTimer[ProfileStageMix]->Start ();
 			}
-			// END TG mixing
 
-			// BEGIN adding reverb
-			if (m_nParameter[ParameterReverbEnable])
+			tg_mixer->zeroFill();
+
+			// the reverb send is mixed in the same pass as the dry signal,
+			// if any active TG sends to the reverb
+			bool bReverbEnable =    m_nParameter[ParameterReverbEnable] != 0
+					     && m_LoadLevel < CLoadGovernor::LevelReverbOff;
+			bool bReverbSend = false;
+			for (uint8_t i = 0; bReverbEnable && i < m_nToneGenerators; i++)
 			{
-				float32_t ReverbBuffer[2][nFrames];
+				if (pOutputActive[i] && m_nReverbSend[i] > 0)
+				{
+					bReverbSend = true;
 
-				float32_t *ReverbSendBuffer[2];
-				reverb_send_mixer->getBuffers(ReverbSendBuffer);
+					break;
+				}
+			}
 
+			if (bReverbSend)
+			{
 				reverb_send_mixer->zeroFill();
+			}
 
-				for (uint8_t i = 0; i < m_nToneGenerators; i++)
+			for (uint8_t i = 0; i < m_nToneGenerators; i++)
+			{
+				if (!pOutputActive[i])
 				{
-					reverb_send_mixer->doAddMix(i,m_OutputLevel[i]);
+					continue;
 				}
 
-				m_ReverbSpinLock.Acquire ();
+				if (bReverbSend)
+				{
+					tg_mixer->doAddMixWithSend(i,OutputLevel[i],reverb_send_mixer);
+				}
+				else
+				{
+					tg_mixer->doAddMix(i,OutputLevel[i]);
+				}
+			}
+
+			if (m_bProfileEnabled)
+			{
+				m_pProfileTimer[ProfileStageMix]->Stop ();
+			}
+
+			TRACE (TraceMixEnd, 0);
+			// END TG mixing
+
+			// BEGIN adding reverb
+			// The return of the previous chunk is ready here, because the
+			// scheduler has been waited for before mixing. The send bus of
+			// this chunk is processed on a free core meanwhile, which sets
+			// m_bReverbReturnValid, if it has produced output.
+			if (m_bReverbReturnValid)
+			{
+				assert (m_nReverbFrames == nFrames);
+				arm_add_f32(SampleBuffer[indexL], m_pReverbBuffer[indexL], SampleBuffer[indexL], nFrames);
+				arm_add_f32(SampleBuffer[indexR], m_pReverbBuffer[indexR], SampleBuffer[indexR], nFrames);
 
-				reverb->doReverb(ReverbSendBuffer[indexL],ReverbSendBuffer[indexR],ReverbBuffer[indexL], ReverbBuffer[indexR],nFrames);
+				m_bReverbReturnValid = false;
+			}
 
-				// scale down and add left reverb buffer by reverb level 
-				arm_scale_f32(ReverbBuffer[indexL], reverb->get_level(), ReverbBuffer[indexL], nFrames);
-				arm_add_f32(SampleBuffer[indexL], ReverbBuffer[indexL], SampleBuffer[indexL], nFrames);
-				// scale down and add right reverb buffer by reverb level 
-				arm_scale_f32(ReverbBuffer[indexR], reverb->get_level(), ReverbBuffer[indexR], nFrames);
-				arm_add_f32(SampleBuffer[indexR], ReverbBuffer[indexR], SampleBuffer[indexR], nFrames);
+			// skip the reverb completely, when it is idle and there is no send
+			if (   bReverbEnable
+			    && (bReverbSend || !reverb->is_idle ()))
+			{
+				if (!bReverbSend)
+				{
+					reverb_send_mixer->zeroFill();		// let the tail ring out
+				}
 
-				m_ReverbSpinLock.Release ();
+				m_nReverbFrames = nFrames;
+				m_nRenderJobs.fetch_add (1);
+				m_RenderScheduler.Submit (ProcessReverb, 0, this);
 			}
 			// END adding reverb
 
@@ -1441,32 +1978,116 @@ void CMiniDexed::ProcessSound (void)
 				indexR=0;
 			}
 
-			// Convert dual float array (left, right) to single int16 array (left/right)
-			arm_scale_zip_f32(SampleBuffer[indexL], SampleBuffer[indexR], nMasterVolume, tmp_float, nFrames);
-
-			arm_float_to_q23(tmp_float,tmp_int,nFrames*2);
-
-			// Prevent PCM510x analog mute from kicking in
-			if (tmp_int[nFrames * 2 - 1] == 0)
+			// Convert dual float array (left, right) to single int24 array (left/right)
+			// in one pass. This also prevents the PCM510x analog mute.
+			if (m_bProfileEnabled)
 			{
-				tmp_int[nFrames * 2 - 1]++;
+				m_pProfileTimer[ProfileStageOutput]->Start ();
 			}
-			
-			if (m_pSoundDevice->Write (tmp_int, sizeof(tmp_int)) != (int) sizeof(tmp_int))
+
+			arm_scale_zip_q23(SampleBuffer[indexL], SampleBuffer[indexR], nMasterVolume, tmp_int, nFrames);
+
+			WriteSound (tmp_int, nBytes);
+
+			if (m_bProfileEnabled)
 			{
-				LOGERR ("Sound data dropped");
+				m_pProfileTimer[ProfileStageOutput]->Stop ();
 			}
 		} // End of Stereo mixing
 
 		if (m_bProfileEnabled)
 		{
-			m_GetChunkTimer.Stop ();
+			m_pProfileTimer[ProfileStageChunk]->Stop ();
 		}
+
+		UpdateLoad (nFrames);
+
+		TRACE (TraceChunkEnd, 0);
+
+		// help rendering the next chunk
+		while (m_RenderScheduler.ProcessJob (1))
+		{
+		}
+
+		return true;
 	}
+
+	return false;
 }
 
 #endif
 
+// Adapts the voice pool and the load governor to the processing time of the
+// chunk, which is done now. In pipelined mode the rendering of the next chunk
+// is not part of the chunk time, so the last render span is taken, if it is
+// longer. While the load is high, the governor has each TG cut one released
+// voice, which is no longer audible, every 10 ms.
+void CMiniDexed::UpdateLoad (unsigned nFrames)
+{
+	unsigned nChunkMicros = (CTimer::GetClockTicks () - m_nChunkStartTicks) / (CLOCKHZ / 1000000);
+	unsigned nPeriodMicros = 1000000U * nFrames / m_pConfig->GetSampleRate ();
+
+	// the pool and the governor must see the same load
+	unsigned nLoadMicros = nChunkMicros;
+#ifdef ARM_ALLOW_MULTI_CORE
+	unsigned nRenderMicros =   m_nRenderSpanTicks.load (std::memory_order_relaxed)
+				 / (CLOCKHZ / 1000000);
+	if (nLoadMicros < nRenderMicros)
+	{
+		nLoadMicros = nRenderMicros;
+	}
+#endif
+
+	if (m_pVoicePool)
+	{
+		m_pVoicePool->Update (nLoadMicros, nPeriodMicros);
+	}
+
+	if (!m_pLoadGovernor)
+	{
+		return;
+	}
+
+	CLoadGovernor::TLevel Level = m_pLoadGovernor->Update (nLoadMicros, nPeriodMicros);
+
+	if (   (Level >= CLoadGovernor::LevelLimitVoices)
+	    != (m_LoadLevel >= CLoadGovernor::LevelLimitVoices))
+	{
+		unsigned nLimit = 0;
+		if (Level >= CLoadGovernor::LevelLimitVoices)
+		{
+			unsigned nPolyphony = m_pVoicePool ? CConfig::MaxNotes : m_nPolyphony;
+			nLimit = nPolyphony * m_pConfig->GetLoadGovernorVoiceLimit () / 100;
+			if (!nLimit)
+			{
+				nLimit = 1;
+			}
+		}
+
+		for (unsigned nTG = 0; nTG < m_nToneGenerators; nTG++)
+		{
+			m_pTG[nTG]->setVoiceLimit (nLimit);
+		}
+	}
+
+	m_LoadLevel = Level;
+
+	unsigned nTicks = CTimer::GetClockTicks ();
+	if (   Level >= CLoadGovernor::LevelCutReleases
+	    && nTicks - m_nLoadCutTicks >= LoadCutIntervalMillis * (CLOCKHZ / 1000))
+	{
+		m_nLoadCutTicks = nTicks;
+
+		for (unsigned nTG = 0; nTG < m_nToneGenerators; nTG++)
+		{
+			if (!m_pTG[nTG]->isSilent ())
+			{
+				m_pTG[nTG]->cutReleasingVoice ();
+			}
+		}
+	}
+}
+
 unsigned CMiniDexed::GetPerformanceSelectChannel (void)
 {
 	// Stores and returns Select Channel using MIDI Device Channel definitions
@@ -1547,6 +2168,9 @@ bool CMiniDexed::DoSavePerformance (void)
 		m_PerformanceConfig.SetAftertouchTarget (m_nAftertouchTarget[nTG], nTG);
 		
 		m_PerformanceConfig.SetReverbSend (m_nReverbSend[nTG], nTG);
+
+		m_PerformanceConfig.SetVoicePriority (m_nVoicePriority[nTG], nTG);
+		m_PerformanceConfig.SetVoiceReserve (m_nVoiceReserve[nTG], nTG);
 	}
 
 	m_PerformanceConfig.SetCompressorEnable (!!m_nParameter[ParameterCompressorEnable]);
@@ -2037,7 +2661,9 @@ void CMiniDexed::LoadPerformanceParameters(void)
 			setBreathControllerTarget (m_PerformanceConfig.GetBreathControlTarget (nTG),  nTG);
 			setAftertouchRange (m_PerformanceConfig.GetAftertouchRange (nTG),  nTG);
 			setAftertouchTarget (m_PerformanceConfig.GetAftertouchTarget (nTG),  nTG);
-			
+
+			SetVoicePriority (m_PerformanceConfig.GetVoicePriority (nTG), nTG);
+			SetVoiceReserve (m_PerformanceConfig.GetVoiceReserve (nTG), nTG);
 		
 		}
 
@@ -2329,6 +2955,22 @@ void CMiniDexed::UpdateNetwork()
 					(const char *) IPString, (unsigned) usServerPort);
 
 				new CSysLogDaemon (m_pNet, ServerIP, usServerPort);
+
+#ifdef AUDIO_TRACE
+				m_pTraceSocket = new CSocket (m_pNet, IPPROTO_UDP);
+				if (m_pTraceSocket->Connect (ServerIP, CTrace::ServerPort) != 0)
+				{
+					LOGERR ("Cannot connect trace socket");
+
+					delete m_pTraceSocket;
+					m_pTraceSocket = nullptr;
+				}
+				else
+				{
+					LOGNOTE ("Sending audio trace to %s:%u",
+						(const char *) IPString, (unsigned) CTrace::ServerPort);
+				}
+#endif
 			}
 			else
 			{
@@ -29,6 +29,11 @@
 #include "pckeyboard.h"
 #include "serialmididevice.h"
 #include "perftimer.h"
+#include "xruncounter.h"
+#include "voicepool.h"
+#include "loadgovernor.h"
+#include "trace.h"
+#include "renderscheduler.h"
 #include <fatfs/ff.h>
 #include <stdint.h>
 #include <string>
@@ -100,11 +105,31 @@ public:
 	void setPitchbend (int16_t value, unsigned nTG);
 	void ControllersRefresh (unsigned nTG);
 
+	unsigned GetActiveVoices (void);				// playing voices of all TGs
+
+	enum TProfileStage
+	{
+		ProfileStageChunk,		// GetChunk on core 1, includes the stages below
+		ProfileStageRender,		// getSamples() of a TG, on any core
+		ProfileStageMix,
+		ProfileStageReverb,
+		ProfileStageOutput,		// conversion and Write()
+		ProfileStageWake,		// from submitting a job until a sleeping core took it
+		ProfileStageUnknown
+	};
+
+	// returns 0, if profiling is disabled
+	CPerformanceTimer *GetProfileTimer (TProfileStage Stage);
+
+	const CXRunCounter *GetXRunCounter (void) const;		// sound dropouts
+
 	void setFootController (uint8_t value, unsigned nTG);
 	void setBreathController (uint8_t value, unsigned nTG);
 	void setAftertouch (uint8_t value, unsigned nTG);
 
 	void SetReverbSend (unsigned nReverbSend, unsigned nTG);			// 0 .. 127
+	void SetVoicePriority (unsigned nPriority, unsigned nTG);		// 0 .. CVoicePool::MaxPriority
+	void SetVoiceReserve (unsigned nVoices, unsigned nTG);			// 0 .. CConfig::MaxNotes
 
 	void setMonoMode(uint8_t mono, uint8_t nTG);
 	void setPitchbendRange(uint8_t range, uint8_t nTG);
@@ -220,6 +245,9 @@ public:
 		TGParameterATPitch,
 		TGParameterATAmplitude,
 		TGParameterATEGBias,
+
+		TGParameterVoicePriority,
+		TGParameterVoiceReserve,
 		
 		TGParameterUnknown
 	};
@@ -247,9 +275,23 @@ private:
 	int16_t ApplyNoteLimits (int16_t pitch, unsigned nTG);	// returns < 0 to ignore note
 	uint8_t m_uchOPMask[CConfig::AllToneGenerators];
 	void LoadPerformanceParameters(void); 
-	void ProcessSound (void);
+	bool ProcessSound (void);			// returns false, if there was no chunk to process
+	void UpdateLoad (unsigned nFrames);		// after processing a chunk
+	void WriteSound (const void *pBuffer, size_t nBytes);
 	const char* GetNetworkDeviceShortName() const;
 
+#ifdef AUDIO_TRACE
+	static void SendTracePacket (const void *pPacket, unsigned nLength, void *pParam);
+#endif
+
+#ifdef ARM_ALLOW_MULTI_CORE
+	bool AllocateRenderBuffers (unsigned nFrames, unsigned nChannels);
+	void ScheduleToneGenerators (void);
+	static void RenderToneGenerator (unsigned nTG, unsigned nCore, void *pParam);
+	static void ProcessReverb (unsigned nJob, unsigned nCore, void *pParam);
+	void RenderJobDone (void);			// at the end of each render job
+#endif
+
 #ifdef ARM_ALLOW_MULTI_CORE
 	enum TCoreStatus
 	{
@@ -304,6 +346,15 @@ private:
 	int m_nNoteShift[CConfig::AllToneGenerators];
 
 	unsigned m_nReverbSend[CConfig::AllToneGenerators];
+
+	unsigned m_nVoicePriority[CConfig::AllToneGenerators];
+	unsigned m_nVoiceReserve[CConfig::AllToneGenerators];
+	CVoicePool *m_pVoicePool;				// if enabled
+
+	CLoadGovernor *m_pLoadGovernor;				// if enabled
+	CLoadGovernor::TLevel m_LoadLevel;			// applied to the audio path
+	unsigned m_nLoadCutTicks;				// voices have been cut last
+	static const unsigned LoadCutIntervalMillis = 10;
   
 	uint8_t m_nRawVoiceData[156]; 
 	
@@ -324,14 +375,48 @@ private:
 	bool m_bChannelsSwapped;
 	unsigned m_nQueueSizeFrames;
 
+	CXRunCounter m_XRunCounter;
+	unsigned m_nChunkStartTicks;				// of the chunk being processed
+	bool m_bSoundStarted;					// the first chunk has been written
+
 #ifdef ARM_ALLOW_MULTI_CORE
 //	unsigned m_nActiveTGsLog2;
 	volatile TCoreStatus m_CoreStatus[CORES];
 	volatile unsigned m_nFramesToProcess;
-	float32_t m_OutputLevel[CConfig::AllToneGenerators][CConfig::MaxChunkSize];
+	unsigned m_nAudioPipelineDepth;
+	unsigned m_nRenderSet;					// output level set, the TGs are rendered into
+	bool m_bOutputActive[CConfig::MaxAudioPipelineDepth][CConfig::AllToneGenerators];	// false if silent
+
+	// The render buffers are allocated in Initialize() for the configured
+	// chunk size. Each buffer starts at a cache line of its own, so that the
+	// cores rendering different TGs never write to the same cache line.
+	u8 *m_pRenderBuffers;					// memory block of the buffers below
+	unsigned m_nRenderFrames;				// size of each buffer in frames
+	float32_t *m_pOutputLevel[CConfig::MaxAudioPipelineDepth][CConfig::AllToneGenerators];
+	int32_t *m_pOutputBuffer;				// final interleaved samples for Write()
+
+	// The reverb runs as a job one chunk behind the mix. The send bus of a
+	// chunk is processed into m_pReverbBuffer, which is added to the next chunk.
+	float32_t *m_pReverbBuffer[2];
+	unsigned m_nReverbFrames;				// frames in the send bus for ProcessReverb()
+	bool m_bReverbReturnValid;				// m_pReverbBuffer holds a return to be mixed
+
+	CRenderScheduler m_RenderScheduler;
+	unsigned m_nRenderTicks[CConfig::AllToneGenerators];	// duration of last getSamples()
+	unsigned m_nRenderOrder[CConfig::AllToneGenerators];	// TGs sorted by descending cost
+	bool m_bMIDIEventTiming;
+	unsigned m_nRenderWindowStart;				// MIDI events arrived in this window (clock ticks)
+	unsigned m_nRenderWindowEnd;				//   are rendered into the scheduled chunk
+
+	// The render span is the time from submitting the TGs of a chunk until
+	// the last render or reverb job is done. In pipelined mode the rendering
+	// runs after the chunk has been measured, so UpdateLoad() uses the span.
+	unsigned m_nRenderStartTicks;
+	std::atomic<unsigned> m_nRenderJobs;			// submitted, but not done yet
+	std::atomic<unsigned> m_nRenderSpanTicks;		// of the last completed chunk
 #endif
 
-	CPerformanceTimer m_GetChunkTimer;
+	CPerformanceTimer *m_pProfileTimer[ProfileStageUnknown];	// if profiling is enabled
 	bool m_bProfileEnabled;
 
 	AudioEffectPlateReverb* reverb;
@@ -350,6 +435,7 @@ private:
 	CUDPMIDIDevice* m_UDPMIDI; // Changed to pointer
 	CFTPDaemon* m_pFTPDaemon;
 	CmDNSPublisher *m_pmDNSPublisher;
+	CSocket *m_pTraceSocket;				// to the syslog server, with AUDIO_TRACE
 
 	bool m_bSavePerformance;
 	bool m_bSavePerformanceNewFile;
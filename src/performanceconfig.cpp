@@ -208,6 +208,12 @@ bool CPerformanceConfig::Load (void)
 		
 		PropertyName.Format ("AftertouchTarget%u", nTG+1);
 		m_nAftertouchTarget[nTG] = m_Properties.GetNumber (PropertyName, 0);
+
+		PropertyName.Format ("VoicePriority%u", nTG+1);
+		m_nVoicePriority[nTG] = m_Properties.GetNumber (PropertyName, 0);
+
+		PropertyName.Format ("VoiceReserve%u", nTG+1);
+		m_nVoiceReserve[nTG] = m_Properties.GetNumber (PropertyName, 0);
 		
 		}
 
@@ -327,6 +333,12 @@ bool CPerformanceConfig::Save (void)
 		PropertyName.Format ("AftertouchTarget%u", nTG+1);
 		m_Properties.SetNumber (PropertyName, m_nAftertouchTarget[nTG]);			
 
+		PropertyName.Format ("VoicePriority%u", nTG+1);
+		m_Properties.SetNumber (PropertyName, m_nVoicePriority[nTG]);
+
+		PropertyName.Format ("VoiceReserve%u", nTG+1);
+		m_Properties.SetNumber (PropertyName, m_nVoiceReserve[nTG]);
+
 		}
 
 	m_Properties.SetNumber ("CompressorEnable", m_bCompressorEnable ? 1 : 0);
@@ -737,6 +749,30 @@ unsigned CPerformanceConfig::GetAftertouchTarget (unsigned nTG) const
 	return m_nAftertouchTarget[nTG];
 }
 
+void CPerformanceConfig::SetVoicePriority (unsigned nValue, unsigned nTG)
+{
+	assert (nTG < CConfig::AllToneGenerators);
+	m_nVoicePriority[nTG] = nValue;
+}
+
+unsigned CPerformanceConfig::GetVoicePriority (unsigned nTG) const
+{
+	assert (nTG < CConfig::AllToneGenerators);
+	return m_nVoicePriority[nTG];
+}
+
+void CPerformanceConfig::SetVoiceReserve (unsigned nValue, unsigned nTG)
+{
+	assert (nTG < CConfig::AllToneGenerators);
+	m_nVoiceReserve[nTG] = nValue;
+}
+
+unsigned CPerformanceConfig::GetVoiceReserve (unsigned nTG) const
+{
+	assert (nTG < CConfig::AllToneGenerators);
+	return m_nVoiceReserve[nTG];
+}
+
 void CPerformanceConfig::SetVoiceDataToTxt (const uint8_t *pData, unsigned nTG)  
 {
 	assert (nTG < CConfig::AllToneGenerators);
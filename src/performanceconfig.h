@@ -70,6 +70,8 @@ public:
 	unsigned GetBreathControlTarget (unsigned nTG) const;  // 0 .. 7
 	unsigned GetAftertouchRange (unsigned nTG) const; // 0 .. 99
 	unsigned GetAftertouchTarget (unsigned nTG) const;  // 0 .. 7
+	unsigned GetVoicePriority (unsigned nTG) const;		// 0 .. 7
+	unsigned GetVoiceReserve (unsigned nTG) const;		// 0 .. CConfig::MaxNotes
 
 	void SetBankNumber (unsigned nValue, unsigned nTG);
 	void SetVoiceNumber (unsigned nValue, unsigned nTG);
@@ -100,6 +102,8 @@ public:
 	void SetBreathControlTarget (unsigned nValue, unsigned nTG);
 	void SetAftertouchRange (unsigned nValue, unsigned nTG);
 	void SetAftertouchTarget (unsigned nValue, unsigned nTG);
+	void SetVoicePriority (unsigned nValue, unsigned nTG);
+	void SetVoiceReserve (unsigned nValue, unsigned nTG);
 
 	// Effects
 	bool GetCompressorEnable (void) const;
@@ -182,6 +186,8 @@ private:
 	unsigned m_nBreathControlTarget[CConfig::AllToneGenerators];	
 	unsigned m_nAftertouchRange[CConfig::AllToneGenerators];	
 	unsigned m_nAftertouchTarget[CConfig::AllToneGenerators];	
+	unsigned m_nVoicePriority[CConfig::AllToneGenerators];
+	unsigned m_nVoiceReserve[CConfig::AllToneGenerators];
 
 	unsigned m_nLastPerformance;  
 	unsigned m_nActualPerformance = 0;  
@@ -18,29 +18,79 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 #include "perftimer.h"
-#include <iostream>
+#include <circle/logger.h>
+#include <circle/multicore.h>
+#include <circle/string.h>
+#include <string.h>
+#include <assert.h>
 
-CPerformanceTimer::CPerformanceTimer (const char *pName, unsigned nDeadlineMicros)
+LOGMODULE ("perftimer");
+
+CPerformanceTimer::CPerformanceTimer (const char *pName, unsigned nDeadlineMicros, unsigned nWindowSeconds)
 :	m_Name (pName),
 	m_nDeadlineMicros (nDeadlineMicros),
-	m_nMaximumMicros (0),
+	m_nWindow (nWindowSeconds),
+	m_pSnapshot (nullptr),
+	m_nSnapshotsTaken (0),
 	m_nLastDumpTicks (0)
 {
+	for (unsigned nCore = 0; nCore < CORES; nCore++)
+	{
+		THistogram &rHistogram = m_Histogram[nCore];
+
+		for (unsigned i = 0; i < Buckets; i++)
+		{
+			rHistogram.nBucket[i] = 0;
+		}
+
+		rHistogram.nDeadlineMisses = 0;
+		rHistogram.nMaximumMicros = 0;
+		rHistogram.nStartTicks = 0;
+	}
+
+	if (m_nWindow)
+	{
+		m_pSnapshot = new TSnapshot[m_nWindow];
+		assert (m_pSnapshot);
+	}
+}
+
+CPerformanceTimer::~CPerformanceTimer (void)
+{
+	delete [] m_pSnapshot;
 }
 
 void CPerformanceTimer::Start (void)
 {
-	m_nStartTicks = CTimer::GetClockTicks ();
+	m_Histogram[ThisCore ()].nStartTicks = CTimer::GetClockTicks ();
 }
 
 void CPerformanceTimer::Stop (void)
 {
 	unsigned nEndTicks = CTimer::GetClockTicks ();
-	unsigned nMicros = (nEndTicks - m_nStartTicks) / (CLOCKHZ / 1000000);
 
-	if (nMicros > m_nMaximumMicros)
+	Record ((nEndTicks - m_Histogram[ThisCore ()].nStartTicks) / (CLOCKHZ / 1000000));
+}
+
+void CPerformanceTimer::Record (unsigned nMicros)
+{
+	// only this core writes to its histogram, the counters need not be
+	// incremented atomically
+	THistogram &rHistogram = m_Histogram[ThisCore ()];
+
+	std::atomic<unsigned> &rBucket = rHistogram.nBucket[GetBucket (nMicros)];
+	rBucket.store (rBucket.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	if (   m_nDeadlineMicros
+	    && nMicros > m_nDeadlineMicros)
+	{
+		rHistogram.nDeadlineMisses.store (rHistogram.nDeadlineMisses.load (std::memory_order_relaxed) + 1,
+						  std::memory_order_relaxed);
+	}
+
+	if (nMicros > rHistogram.nMaximumMicros.load (std::memory_order_relaxed))
 	{
-		m_nMaximumMicros = nMicros;
+		rHistogram.nMaximumMicros.store (nMicros, std::memory_order_relaxed);
 	}
 }
 
@@ -52,15 +102,188 @@ void CPerformanceTimer::Dump (unsigned nIntervalTicks)
 	{
 		m_nLastDumpTicks = nTicks;
 
-		unsigned nMaximumMicros = m_nMaximumMicros;	// may be overwritten from interrupt
+		for (unsigned nCore = 0; nCore < CORES; nCore++)
+		{
+			TStatistics Statistics;
+			if (!GetStatistics (&Statistics, nCore))
+			{
+				continue;
+			}
+
+			CString Load;
+			if (m_nDeadlineMicros)
+			{
+				Load.Format (" (%u%%), %u deadline misses",
+					     Statistics.nMaximumMicros*100 / m_nDeadlineMicros,
+					     Statistics.nDeadlineMisses);
+			}
+
+			LOGNOTE ("%s core %u: %u times, median %uus, p99 %uus, max %uus%s",
+				 m_Name.c_str (), nCore, Statistics.nCount, Statistics.nMedianMicros,
+				 Statistics.nP99Micros, Statistics.nMaximumMicros, (const char *) Load);
+		}
+
+		if (m_nWindow)
+		{
+			TakeSnapshot (&m_pSnapshot[m_nSnapshotsTaken++ % m_nWindow]);
+		}
+	}
+}
+
+bool CPerformanceTimer::GetStatistics (TStatistics *pStatistics, unsigned nCore) const
+{
+	assert (pStatistics);
+	assert (nCore <= AllCores);
+
+	unsigned nFirstCore = nCore < AllCores ? nCore : 0;
+	unsigned nLastCore = nCore < AllCores ? nCore : CORES-1;
+
+	// the oldest snapshot in the ring is the start of the window
+	const TSnapshot *pStart = nullptr;
+	if (   m_nWindow
+	    && m_nSnapshotsTaken >= m_nWindow)
+	{
+		pStart = &m_pSnapshot[m_nSnapshotsTaken % m_nWindow];
+	}
+
+	unsigned nBucket[Buckets];
+	memset (nBucket, 0, sizeof nBucket);
+	unsigned nCount = 0;
+	unsigned nMaximumMicros = 0;
+
+	memset (pStatistics, 0, sizeof *pStatistics);
+
+	for (unsigned i = nFirstCore; i <= nLastCore; i++)
+	{
+		const THistogram &rHistogram = m_Histogram[i];
+
+		for (unsigned j = 0; j < Buckets; j++)
+		{
+			unsigned nValue = rHistogram.nBucket[j].load (std::memory_order_relaxed);
+			if (pStart)
+			{
+				nValue -= pStart->nBucket[i][j];
+			}
+
+			nBucket[j] += nValue;
+			nCount += nValue;
+		}
+
+		unsigned nMisses = rHistogram.nDeadlineMisses.load (std::memory_order_relaxed);
+		pStatistics->nDeadlineMisses += pStart ? nMisses - pStart->nDeadlineMisses[i] : nMisses;
+
+		unsigned nMicros = rHistogram.nMaximumMicros.load (std::memory_order_relaxed);
+		if (nMicros > nMaximumMicros)
+		{
+			nMaximumMicros = nMicros;
+		}
+	}
+
+	if (!nCount)
+	{
+		return false;
+	}
 
-		std::cout << m_Name << ": Maximum duration was " << nMaximumMicros <<  "us";
+	// the maximum since the start is exact, in a window it is the limit of
+	// the highest bucket, which is not empty
+	if (pStart)
+	{
+		unsigned j = Buckets-1;
+		while (!nBucket[j])
+		{
+			j--;
+		}
 
-		if (m_nDeadlineMicros != 0)
+		if (GetBucketLimit (j) < nMaximumMicros)
 		{
-			std::cout << " (" << nMaximumMicros*100 / m_nDeadlineMicros << "%)";
+			nMaximumMicros = GetBucketLimit (j);
 		}
+	}
 
-		std::cout << std::endl;
+	pStatistics->nCount = nCount;
+	pStatistics->nMaximumMicros = nMaximumMicros;
+
+	unsigned nMedianCount = (nCount + 1) / 2;
+	unsigned nP99Count = nCount - nCount / 100;
+	unsigned nSum = 0;
+	for (unsigned j = 0; j < Buckets; j++)
+	{
+		nSum += nBucket[j];
+
+		unsigned nLimit = GetBucketLimit (j) < nMaximumMicros ? GetBucketLimit (j) : nMaximumMicros;
+
+		if (   !pStatistics->nMedianMicros
+		    && nSum >= nMedianCount)
+		{
+			pStatistics->nMedianMicros = nLimit;
+		}
+
+		if (nSum >= nP99Count)
+		{
+			pStatistics->nP99Micros = nLimit;
+
+			break;
+		}
 	}
+
+	return true;
+}
+
+const char *CPerformanceTimer::GetName (void) const
+{
+	return m_Name.c_str ();
+}
+
+void CPerformanceTimer::TakeSnapshot (TSnapshot *pSnapshot) const
+{
+	assert (pSnapshot);
+
+	for (unsigned nCore = 0; nCore < CORES; nCore++)
+	{
+		const THistogram &rHistogram = m_Histogram[nCore];
+
+		for (unsigned j = 0; j < Buckets; j++)
+		{
+			pSnapshot->nBucket[nCore][j] = rHistogram.nBucket[j].load (std::memory_order_relaxed);
+		}
+
+		pSnapshot->nDeadlineMisses[nCore] = rHistogram.nDeadlineMisses.load (std::memory_order_relaxed);
+	}
+}
+
+unsigned CPerformanceTimer::ThisCore (void)
+{
+#ifdef ARM_ALLOW_MULTI_CORE
+	return CMultiCoreSupport::ThisCore ();
+#else
+	return 0;
+#endif
+}
+
+// 0..3us have a bucket each, above there are 4 buckets per octave
+unsigned CPerformanceTimer::GetBucket (unsigned nMicros)
+{
+	if (nMicros < 4)
+	{
+		return nMicros;
+	}
+
+	unsigned nMSB = 31 - __builtin_clz (nMicros);
+	unsigned nBucket = 4*(nMSB-1) + ((nMicros >> (nMSB-2)) & 3);
+
+	return nBucket < Buckets ? nBucket : Buckets-1;
+}
+
+unsigned CPerformanceTimer::GetBucketLimit (unsigned nBucket)
+{
+	assert (nBucket < Buckets);
+
+	if (nBucket < 4)
+	{
+		return nBucket;
+	}
+
+	unsigned nMSB = nBucket/4 + 1;
+
+	return ((5 + nBucket%4) << (nMSB-2)) - 1;
 }
@@ -21,24 +21,81 @@
 #define _perftimer_h
 
 #include <string>
+#include <atomic>
 #include <circle/timer.h>
+#include <circle/sysconfig.h>
+
+// Measures the duration of a processing stage on each core. The durations
+// are collected in a histogram per core with 4 logarithmic buckets per octave
+// (about 19% resolution), from which the median, the 99th percentile and the
+// maximum are derived. Start() and Stop() are lock-free, each core writes to
+// its own histogram only. Dump() and GetStatistics() are called from the
+// main loop. With a window of n seconds, the statistics cover the last n
+// Dump() intervals only, otherwise all durations since the start.
 
 class CPerformanceTimer
 {
 public:
-	CPerformanceTimer (const char *pName, unsigned nDeadlineMicros = 0);
+	static const unsigned AllCores = CORES;
+
+	struct TStatistics
+	{
+		unsigned nCount;
+		unsigned nMedianMicros;
+		unsigned nP99Micros;
+		unsigned nMaximumMicros;
+		unsigned nDeadlineMisses;		// durations longer than the deadline
+	};
+
+public:
+	CPerformanceTimer (const char *pName, unsigned nDeadlineMicros = 0, unsigned nWindowSeconds = 0);
+	~CPerformanceTimer (void);
 
 	void Start (void);
 	void Stop (void);
 
+	void Record (unsigned nMicros);			// a duration measured elsewhere
+
+	// writes the statistics of each core to the log once per interval
 	void Dump (unsigned nIntervalTicks = CLOCKHZ);
 
+	// returns false, if no duration has been recorded (in the window)
+	bool GetStatistics (TStatistics *pStatistics, unsigned nCore = AllCores) const;
+
+	const char *GetName (void) const;
+
+private:
+	static const unsigned Buckets = 64;		// up to 131 ms
+
+	struct THistogram
+	{
+		std::atomic<unsigned> nBucket[Buckets];
+		std::atomic<unsigned> nDeadlineMisses;
+		std::atomic<unsigned> nMaximumMicros;
+		unsigned nStartTicks;
+	};
+
+	struct TSnapshot				// of the counters of all cores
+	{
+		unsigned nBucket[CORES][Buckets];
+		unsigned nDeadlineMisses[CORES];
+	};
+
+	void TakeSnapshot (TSnapshot *pSnapshot) const;
+
+	static unsigned ThisCore (void);
+	static unsigned GetBucket (unsigned nMicros);
+	static unsigned GetBucketLimit (unsigned nBucket);	// largest duration in bucket
+
 private:
 	std::string m_Name;
 	unsigned m_nDeadlineMicros;
 
-	unsigned m_nStartTicks;
-	unsigned m_nMaximumMicros;
+	THistogram m_Histogram[CORES];
+
+	unsigned m_nWindow;				// in Dump() intervals, 0 for no window
+	TSnapshot *m_pSnapshot;				// ring of m_nWindow snapshots
+	unsigned m_nSnapshotsTaken;
 
 	unsigned m_nLastDumpTicks;
 };
@@ -0,0 +1,204 @@
+//
+// renderscheduler.cpp
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "renderscheduler.h"
+#include <circle/timer.h>
+#include <circle/synchronize.h>
+#include <assert.h>
+#ifndef __circle__
+	#include <thread>
+#endif
+
+// the periodic event wakes sleeping cores every 20 to 40 microseconds
+static const unsigned EventStreamMicros = 20;
+
+static inline void WaitForEvent (void)
+{
+#ifdef __circle__
+	asm volatile ("wfe" ::: "memory");
+#else
+	std::this_thread::yield ();		// host build
+#endif
+}
+
+static inline void SendEvent (void)
+{
+#ifdef __circle__
+	DataSyncBarrier ();			// the counters must be visible to the woken cores
+	asm volatile ("sev");
+#endif
+}
+
+CRenderScheduler::CRenderScheduler (bool bSleep)
+:	m_bSleep (bSleep),
+	m_pWakeUpTimer (nullptr),
+	m_nSubmitted (0),
+	m_nTaken (0),
+	m_nCompleted (0)
+{
+	for (unsigned nCore = 0; nCore < CORES; nCore++)
+	{
+		m_bWaiting[nCore] = false;
+	}
+}
+
+// Enables the event stream of the generic timer on this core, which signals
+// an event, when the selected bit of the counter changes from 0 to 1. So WFE
+// does not wait longer than 2^(bit+1) counter ticks.
+void CRenderScheduler::InitCore (void)
+{
+#if defined (__circle__) && defined (ARM_ALLOW_MULTI_CORE)
+	unsigned long nFrequency;
+#if AARCH == 64
+	asm volatile ("mrs %0, cntfrq_el0" : "=r" (nFrequency));
+#else
+	asm volatile ("mrc p15, 0, %0, c14, c0, 0" : "=r" (nFrequency));
+#endif
+
+	unsigned nBit = 0;
+	while (   nBit < 15
+	       && (2ULL << nBit) * 1000000 / nFrequency < EventStreamMicros)
+	{
+		nBit++;
+	}
+
+	unsigned long nControl;
+#if AARCH == 64
+	asm volatile ("mrs %0, cntkctl_el1" : "=r" (nControl));
+#else
+	asm volatile ("mrc p15, 0, %0, c14, c1, 0" : "=r" (nControl));
+#endif
+
+	nControl &= ~(0xFUL << 4 | 1UL << 3);		// EVNTI, EVNTDIR (0 to 1)
+	nControl |= nBit << 4 | 1UL << 2;		// EVNTEN
+
+#if AARCH == 64
+	asm volatile ("msr cntkctl_el1, %0" :: "r" (nControl));
+#else
+	asm volatile ("mcr p15, 0, %0, c14, c1, 0" :: "r" (nControl));
+#endif
+	InstructionSyncBarrier ();
+#endif
+}
+
+void CRenderScheduler::SetWakeUpTimer (CPerformanceTimer *pTimer)
+{
+	m_pWakeUpTimer = pTimer;
+}
+
+void CRenderScheduler::Submit (TJobHandler *pHandler, unsigned nJob, void *pParam)
+{
+	assert (pHandler);
+
+	unsigned nSubmitted = m_nSubmitted.load (std::memory_order_relaxed);
+
+	// a slot must not be reused, before its job has been completed
+	assert (nSubmitted - m_nCompleted.load (std::memory_order_acquire) < MaxJobs);
+
+	TJob &rJob = m_Jobs[nSubmitted & (MaxJobs-1)];
+	rJob.pHandler = pHandler;
+	rJob.nJob = nJob;
+	rJob.pParam = pParam;
+	rJob.nSubmitTicks = CTimer::GetClockTicks ();
+
+	// publish the job to the consumers
+	m_nSubmitted.store (nSubmitted+1, std::memory_order_release);
+
+	Wake ();
+}
+
+void CRenderScheduler::WaitIdle (unsigned nCore)
+{
+	while (!IsIdle ())
+	{
+		if (!ProcessJob (nCore))
+		{
+			Sleep ();			// until another core completes a job
+		}
+	}
+}
+
+bool CRenderScheduler::ProcessJob (unsigned nCore)
+{
+	unsigned nTaken = m_nTaken.load (std::memory_order_relaxed);
+	do
+	{
+		if (nTaken == m_nSubmitted.load (std::memory_order_acquire))
+		{
+			// the producer does not wait for its own jobs
+			m_bWaiting[nCore] = nCore != 1;
+
+			return false;
+		}
+	}
+	while (!m_nTaken.compare_exchange_weak (nTaken, nTaken+1,
+						std::memory_order_acquire,
+						std::memory_order_relaxed));
+
+	const TJob &rJob = m_Jobs[nTaken & (MaxJobs-1)];
+
+	if (m_bWaiting[nCore])
+	{
+		m_bWaiting[nCore] = false;
+
+		if (m_pWakeUpTimer)
+		{
+			m_pWakeUpTimer->Record (  (CTimer::GetClockTicks () - rJob.nSubmitTicks)
+						/ (CLOCKHZ / 1000000));
+		}
+	}
+
+	(*rJob.pHandler) (rJob.nJob, nCore, rJob.pParam);
+
+	m_nCompleted.fetch_add (1, std::memory_order_release);
+
+	Wake ();
+
+	return true;
+}
+
+bool CRenderScheduler::IsIdle (void) const
+{
+	return m_nCompleted.load (std::memory_order_acquire) == m_nSubmitted.load (std::memory_order_relaxed);
+}
+
+void CRenderScheduler::WaitForJob (void)
+{
+	// a job submitted after this check has already set the event register
+	if (m_nTaken.load (std::memory_order_relaxed) == m_nSubmitted.load (std::memory_order_acquire))
+	{
+		Sleep ();
+	}
+}
+
+void CRenderScheduler::Sleep (void)
+{
+	if (m_bSleep)
+	{
+		WaitForEvent ();
+	}
+}
+
+void CRenderScheduler::Wake (void)
+{
+	if (m_bSleep)
+	{
+		SendEvent ();
+	}
+}
@@ -0,0 +1,91 @@
+//
+// renderscheduler.h
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _renderscheduler_h
+#define _renderscheduler_h
+
+#include <circle/types.h>
+#include <circle/sysconfig.h>
+#include "perftimer.h"
+#include <atomic>
+
+// Shared work queue for the audio cores. Jobs are submitted by core 1 only
+// (single producer) and are pulled by all cores taking part in rendering
+// (multiple consumers), so that the work of a chunk is balanced dynamically
+// instead of being bound to a fixed core.
+//
+// With bSleep, cores without work wait in low-power standby (WFE) instead
+// of spinning on the counters. They are woken with SEV, when a job has been
+// submitted or completed, and at the latest by the periodic event of the
+// generic timer, which is enabled with InitCore().
+
+class CRenderScheduler
+{
+public:
+	typedef void TJobHandler (unsigned nJob, unsigned nCore, void *pParam);
+
+	static const unsigned MaxJobs = 64;		// must be a power of 2
+
+public:
+	CRenderScheduler (bool bSleep = true);
+
+	// on each core taking part, before using the scheduler
+	static void InitCore (void);
+
+	// duration from submitting a job until an idle core has taken it
+	void SetWakeUpTimer (CPerformanceTimer *pTimer);
+
+	// producer (core 1) only
+	void Submit (TJobHandler *pHandler, unsigned nJob, void *pParam);
+	void WaitIdle (unsigned nCore);			// helps processing until all jobs are done
+
+	// consumers (any core); returns false, if no job was available
+	bool ProcessJob (unsigned nCore);
+
+	bool IsIdle (void) const;
+
+	// sleeps until a job may have been submitted, the caller must check again
+	void WaitForJob (void);
+
+	// sleeps until the next event (or the periodic event), e.g. when polling
+	void Sleep (void);
+	void Wake (void);				// all sleeping cores
+
+private:
+	struct TJob
+	{
+		TJobHandler *pHandler;
+		unsigned nJob;
+		void *pParam;
+		unsigned nSubmitTicks;
+	};
+
+	bool m_bSleep;
+	CPerformanceTimer *m_pWakeUpTimer;
+	bool m_bWaiting[CORES];				// a core found no job last time
+
+	TJob m_Jobs[MaxJobs];
+
+	// monotonic counters, the job slot is (counter & (MaxJobs-1))
+	std::atomic<unsigned> m_nSubmitted;
+	std::atomic<unsigned> m_nTaken;
+	std::atomic<unsigned> m_nCompleted;
+};
+
+#endif
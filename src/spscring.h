@@ -0,0 +1,108 @@
+//
+// spscring.h
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _spscring_h
+#define _spscring_h
+
+#include <atomic>
+
+// Lock-free ring buffer for one producer and one consumer, which may run on
+// different cores. Neither side ever waits for the other one.
+
+template <typename T, unsigned Size>		// Size must be a power of 2
+class CSPSCRing
+{
+	static_assert (Size > 0 && (Size & (Size-1)) == 0, "Size must be a power of 2");
+
+public:
+	CSPSCRing (void)
+	:	m_nWrite (0),
+		m_nRead (0)
+	{
+	}
+
+	// producer only, returns false if the ring is full
+	bool Put (const T &rItem)
+	{
+		unsigned nWrite = m_nWrite.load (std::memory_order_relaxed);
+		if (nWrite - m_nRead.load (std::memory_order_acquire) >= Size)
+		{
+			return false;
+		}
+
+		m_Items[nWrite & (Size-1)] = rItem;
+		m_nWrite.store (nWrite+1, std::memory_order_release);
+
+		return true;
+	}
+
+	// producer only, returns the number of items, which can be put
+	unsigned GetFree (void) const
+	{
+		return Size - (m_nWrite.load (std::memory_order_relaxed) - m_nRead.load (std::memory_order_acquire));
+	}
+
+	// consumer only, returns false if the ring is empty
+	bool Get (T *pItem)
+	{
+		unsigned nRead = m_nRead.load (std::memory_order_relaxed);
+		if (nRead == m_nWrite.load (std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		*pItem = m_Items[nRead & (Size-1)];
+		m_nRead.store (nRead+1, std::memory_order_release);
+
+		return true;
+	}
+
+	// consumer only, returns the next item without removing it or nullptr
+	const T *Peek (void) const
+	{
+		unsigned nRead = m_nRead.load (std::memory_order_relaxed);
+		if (nRead == m_nWrite.load (std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		return &m_Items[nRead & (Size-1)];
+	}
+
+	// consumer only, removes the item returned by Peek()
+	void Remove (void)
+	{
+		m_nRead.fetch_add (1, std::memory_order_release);
+	}
+
+	// may be called from any side
+	bool IsEmpty (void) const
+	{
+		return m_nRead.load (std::memory_order_acquire) == m_nWrite.load (std::memory_order_acquire);
+	}
+
+private:
+	T m_Items[Size];
+
+	// monotonic counters, the item slot is (counter & (Size-1))
+	std::atomic<unsigned> m_nWrite;
+	std::atomic<unsigned> m_nRead;
+};
+
+#endif
@@ -0,0 +1,113 @@
+//
+// trace.cpp
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "trace.h"
+#include <assert.h>
+
+#ifdef AUDIO_TRACE
+
+CTrace::TRing CTrace::s_Ring[CORES];
+
+bool CTrace::Drain (TPacketHandler *pHandler, void *pParam)
+{
+	assert (pHandler);
+
+	u8 Packet[MaxPacketSize];
+	TPacketHeader *pHeader = (TPacketHeader *) Packet;
+	TPacketRecord *pRecord = (TPacketRecord *) (Packet + sizeof (TPacketHeader));
+
+	for (unsigned nCore = 0; nCore < CORES; nCore++)
+	{
+		TRing &rRing = s_Ring[nCore];
+
+		bool bPending = false;
+		while (!bPending)
+		{
+			unsigned nWrite = rRing.nWrite.load (std::memory_order_acquire);
+			if (nWrite - rRing.nRead > RingSize)
+			{
+				rRing.nLost += nWrite - RingSize - rRing.nRead;
+				rRing.nRead = nWrite - RingSize;
+			}
+
+			unsigned nRecords = 0;
+			while (   rRing.nRead != nWrite
+			       && nRecords < MaxPacketRecords)
+			{
+				const TSlot &rSlot = rRing.Slot[rRing.nRead & (RingSize-1)];
+
+				// an older sequence (or 0) means, that the record has
+				// been reserved, but is still being written
+				unsigned nSequence = rSlot.nSequence.load (std::memory_order_acquire);
+				if ((int) (nSequence - (rRing.nRead + 1)) < 0)
+				{
+					bPending = true;
+					break;
+				}
+
+				pRecord[nRecords].nTicks = rSlot.nTicks;
+				pRecord[nRecords].nEventArg = rSlot.nEventArg;
+
+				std::atomic_thread_fence (std::memory_order_acquire);
+
+				if (   nSequence == rRing.nRead + 1
+				    && rSlot.nSequence.load (std::memory_order_relaxed) == nSequence)
+				{
+					nRecords++;
+				}
+				else
+				{
+					rRing.nLost++;			// overwritten meanwhile
+				}
+
+				rRing.nRead++;
+			}
+
+			if (!nRecords)
+			{
+				break;
+			}
+
+			pHeader->nMagic = PacketMagic;
+			pHeader->nVersion = PacketVersion;
+			pHeader->nCore = nCore;
+			pHeader->nRecords = nRecords;
+			pHeader->nLost = rRing.nLost;
+			rRing.nLost = 0;
+
+			(*pHandler) (Packet, sizeof (TPacketHeader) + nRecords * sizeof (TPacketRecord), pParam);
+
+			if (rRing.nRead == nWrite)
+			{
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+#else
+
+bool CTrace::Drain (TPacketHandler *pHandler, void *pParam)
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,162 @@
+//
+// trace.h
+//
+// Records the timing of the audio path with TRACE(event, arg) into a ring per
+// core, if built with "make TRACE=1" (AUDIO_TRACE defined), else TRACE() is
+// empty. The rings are drained from the main loop into packets, which are
+// sent to the syslog server host (UDP port 8515) and can be converted to the
+// Chrome trace format with trace2json.py.
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _trace_h
+#define _trace_h
+
+#include <atomic>
+#include <circle/timer.h>
+#include <circle/sysconfig.h>
+#include <circle/types.h>
+#include <circle/macros.h>
+#ifdef ARM_ALLOW_MULTI_CORE
+	#include <circle/multicore.h>
+#endif
+
+// keep in sync with trace2json.py
+enum TTraceEvent : u8
+{
+	TraceNone,
+	TraceChunkBegin,		// ProcessSound() on core 1
+	TraceChunkEnd,
+	TraceWaitBegin,			// core 1 waits for the render jobs
+	TraceWaitEnd,
+	TraceRenderBegin,		// arg: TG
+	TraceRenderEnd,
+	TraceMixBegin,
+	TraceMixEnd,
+	TraceReverbBegin,
+	TraceReverbEnd,
+	TraceWriteBegin,		// arg: frames queued
+	TraceWriteEnd,
+	TraceMIDIMessage,		// arg: status | data 1 << 8 | data 2 << 16
+	TraceKeyDown,			// queued to a TG, arg: pitch
+	TraceKeyUp,
+	TraceEventApplied,		// by the rendering core, arg: event type | pitch << 8
+	TraceXRun,			// arg: 0 underrun, 1 overrun
+	TraceCoreStart,			// CMiniDexed::Run()
+	TraceUnknown
+};
+
+#ifdef AUDIO_TRACE
+	#define TRACE(event, arg)	CTrace::Record ((event), (arg))
+#else
+	#define TRACE(event, arg)	((void) 0)
+#endif
+
+class CTrace
+{
+public:
+	// UDP port on the syslog server host
+	static const u16 ServerPort = 8515;
+
+	// packet: header and up to MaxPacketRecords records, all little endian
+	struct TPacketHeader
+	{
+		u32 nMagic;			// "MDTR"
+		u8 nVersion;
+		u8 nCore;
+		u16 nRecords;
+		u32 nLost;			// records overwritten before the previous packet
+	}
+	PACKED;
+
+	struct TPacketRecord
+	{
+		u32 nTicks;			// clock ticks (microseconds)
+		u32 nEventArg;			// event | arg << 8
+	}
+	PACKED;
+
+	static const u32 PacketMagic = 0x5254444D;
+	static const u8 PacketVersion = 1;
+	static const unsigned MaxPacketRecords = 128;
+	static const unsigned MaxPacketSize = sizeof (TPacketHeader) + MaxPacketRecords * sizeof (TPacketRecord);
+
+	typedef void TPacketHandler (const void *pPacket, unsigned nLength, void *pParam);
+
+public:
+	// lock-free, from any context (also from interrupt) on this core
+	static void Record (TTraceEvent Event, unsigned nArg = 0);
+
+	// drains the rings of all cores into packets and passes them to the handler,
+	// from one task only, returns false if tracing is not built in
+	static bool Drain (TPacketHandler *pHandler, void *pParam);
+
+#ifdef AUDIO_TRACE
+private:
+	static const unsigned RingSize = 4096;		// records per core, must be a power of 2
+
+	// a slot is valid, if nSequence is its index + 1, so that a record,
+	// which is interrupted by another one on the same core or is being
+	// overwritten, is not read
+	struct TSlot
+	{
+		std::atomic<unsigned> nSequence;
+		u32 nTicks;
+		u32 nEventArg;
+	};
+
+	struct TRing
+	{
+		TSlot Slot[RingSize];
+		std::atomic<unsigned> nWrite;		// slots reserved
+		unsigned nRead;				// slots drained
+		unsigned nLost;
+	};
+
+	static TRing s_Ring[CORES];
+#endif
+};
+
+#ifdef AUDIO_TRACE
+
+inline void CTrace::Record (TTraceEvent Event, unsigned nArg)
+{
+#ifdef ARM_ALLOW_MULTI_CORE
+	TRing &rRing = s_Ring[CMultiCoreSupport::ThisCore ()];
+#else
+	TRing &rRing = s_Ring[0];
+#endif
+
+	unsigned nIndex = rRing.nWrite.fetch_add (1, std::memory_order_relaxed);
+
+	TSlot &rSlot = rRing.Slot[nIndex & (RingSize-1)];
+	rSlot.nSequence.store (0, std::memory_order_relaxed);		// invalid while written
+	std::atomic_thread_fence (std::memory_order_release);
+	rSlot.nTicks = CTimer::GetClockTicks ();
+	rSlot.nEventArg = Event | nArg << 8;
+	rSlot.nSequence.store (nIndex + 1, std::memory_order_release);
+}
+
+#else
+
+inline void CTrace::Record (TTraceEvent Event, unsigned nArg)
+{
+}
+
+#endif
+
+#endif
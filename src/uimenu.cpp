@@ -52,7 +52,6 @@ const CUIMenu::TMenuItem CUIMenu::s_MainMenu[] =
 	{"TG6",		MenuHandler,	s_TGMenu, 5},
 	{"TG7",		MenuHandler,	s_TGMenu, 6},
 	{"TG8",		MenuHandler,	s_TGMenu, 7},
-#if (RASPPI==4 || RASPPI==5)
 	{"TG9",		MenuHandler,	s_TGMenu, 8},
 	{"TG10",	MenuHandler,	s_TGMenu, 9},
 	{"TG11",	MenuHandler,	s_TGMenu, 10},
@@ -61,11 +60,43 @@ const CUIMenu::TMenuItem CUIMenu::s_MainMenu[] =
 	{"TG14",	MenuHandler,	s_TGMenu, 13},
 	{"TG15",	MenuHandler,	s_TGMenu, 14},
 	{"TG16",	MenuHandler,	s_TGMenu, 15},
+#if (RASPPI==4 || RASPPI==5)
+	{"TG17",	MenuHandler,	s_TGMenu, 16},
+	{"TG18",	MenuHandler,	s_TGMenu, 17},
+	{"TG19",	MenuHandler,	s_TGMenu, 18},
+	{"TG20",	MenuHandler,	s_TGMenu, 19},
+	{"TG21",	MenuHandler,	s_TGMenu, 20},
+	{"TG22",	MenuHandler,	s_TGMenu, 21},
+	{"TG23",	MenuHandler,	s_TGMenu, 22},
+	{"TG24",	MenuHandler,	s_TGMenu, 23},
+	{"TG25",	MenuHandler,	s_TGMenu, 24},
+	{"TG26",	MenuHandler,	s_TGMenu, 25},
+	{"TG27",	MenuHandler,	s_TGMenu, 26},
+	{"TG28",	MenuHandler,	s_TGMenu, 27},
+	{"TG29",	MenuHandler,	s_TGMenu, 28},
+	{"TG30",	MenuHandler,	s_TGMenu, 29},
+	{"TG31",	MenuHandler,	s_TGMenu, 30},
+	{"TG32",	MenuHandler,	s_TGMenu, 31},
 #endif
 #endif
 	{"Effects",	MenuHandler,	s_EffectsMenu},
 	{"Master Volume", EditMasterVolume, 0, 0},
 	{"Performance",	MenuHandler, s_PerformanceMenu}, 
+	{"Profile",	MenuHandler,	s_ProfileMenu},
+	{0}
+};
+
+const CUIMenu::TMenuItem CUIMenu::s_ProfileMenu[] =
+{
+	{"Dropouts",	ShowDropouts},
+	{"GetChunk",	ShowProfile,	0,	CMiniDexed::ProfileStageChunk},
+#ifdef ARM_ALLOW_MULTI_CORE
+	{"Render TG",	ShowProfile,	0,	CMiniDexed::ProfileStageRender},
+	{"Mix",		ShowProfile,	0,	CMiniDexed::ProfileStageMix},
+	{"Reverb",	ShowProfile,	0,	CMiniDexed::ProfileStageReverb},
+	{"Output",	ShowProfile,	0,	CMiniDexed::ProfileStageOutput},
+	{"Wake-up",	ShowProfile,	0,	CMiniDexed::ProfileStageWake},
+#endif
 	{0}
 };
 
@@ -86,6 +117,10 @@ const CUIMenu::TMenuItem CUIMenu::s_TGMenu[] =
 	{"Poly/Mono",		EditTGParameter,	0,	CMiniDexed::TGParameterMonoMode}, 
 	{"Modulation",		MenuHandler,		s_ModulationMenu},
 	{"Channel",	EditTGParameter,	0,	CMiniDexed::TGParameterMIDIChannel},
+#ifdef ARM_ALLOW_MULTI_CORE
+	{"Voice Priority",	EditTGParameter,	0,	CMiniDexed::TGParameterVoicePriority},
+	{"Voice Reserve",	EditTGParameter,	0,	CMiniDexed::TGParameterVoiceReserve},
+#endif
 	{"Edit Voice",	MenuHandler,		s_EditVoiceMenu},
 	{0}
 };
@@ -265,7 +300,9 @@ const CUIMenu::TParameter CUIMenu::s_TGParameter[CMiniDexed::TGParameterUnknown]
 	{0, 99, 1}, //AT Range
 	{0, 1, 1, ToOnOff}, //AT Pitch
 	{0, 1, 1, ToOnOff}, //AT Amp
-	{0, 1, 1, ToOnOff} //AT EGBias	
+	{0, 1, 1, ToOnOff}, //AT EGBias	
+	{0,	CVoicePool::MaxPriority,		1},			// TGParameterVoicePriority
+	{0,	CConfig::MaxNotes,			1}			// TGParameterVoiceReserve
 };
 
 // must match DexedVoiceParameters in Synth_Dexed
@@ -2098,3 +2135,120 @@ void CUIMenu::EditMasterVolume(CUIMenu *pUIMenu, TMenuEvent Event)
     // Do NOT add < or > here; let DisplayWrite handle it
     pUIMenu->m_pUI->DisplayWrite("Master Volume", "", valueStr.c_str(), true, true);
 }
+
+// Shows the 99th percentile and the maximum duration of a processing stage.
+// Up/down select the core, the statistics are updated on each step.
+void CUIMenu::ShowProfile (CUIMenu *pUIMenu, TMenuEvent Event)
+{
+	CMiniDexed::TProfileStage Stage = (CMiniDexed::TProfileStage) pUIMenu->m_nCurrentParameter;
+	unsigned &rCore = pUIMenu->m_nProfileCore;
+
+	switch (Event)
+	{
+	case MenuEventUpdate:
+	case MenuEventUpdateParameter:
+		break;
+
+	case MenuEventStepDown:
+		if (rCore > 0)
+		{
+			rCore--;
+		}
+		break;
+
+	case MenuEventStepUp:
+		if (rCore < CPerformanceTimer::AllCores)
+		{
+			rCore++;
+		}
+		break;
+
+	default:
+		return;
+	}
+
+	std::string Core = rCore < CPerformanceTimer::AllCores ? "Core " + std::to_string (rCore) : "All cores";
+
+	std::string Value;
+	CPerformanceTimer::TStatistics Statistics;
+	CPerformanceTimer *pTimer = pUIMenu->m_pMiniDexed->GetProfileTimer (Stage);
+	if (!pTimer)
+	{
+		Value = "Profiling off";
+	}
+	else if (!pTimer->GetStatistics (&Statistics, rCore))
+	{
+		Value = "No data";
+	}
+	else
+	{
+		Value =   "p99 " + std::to_string (Statistics.nP99Micros)
+			+ " max " + std::to_string (Statistics.nMaximumMicros);
+	}
+
+	pUIMenu->m_pUI->DisplayWrite (pUIMenu->m_pParentMenu[pUIMenu->m_nCurrentMenuItem].Name,
+				      Core.c_str (), Value.c_str (),
+				      rCore > 0, rCore < CPerformanceTimer::AllCores);
+}
+
+// Shows the number of underruns and overruns of the sound output. Up steps
+// through the last dropouts, the most recent first.
+void CUIMenu::ShowDropouts (CUIMenu *pUIMenu, TMenuEvent Event)
+{
+	const CXRunCounter *pXRunCounter = pUIMenu->m_pMiniDexed->GetXRunCounter ();
+	unsigned &rEvent = pUIMenu->m_nDropoutEvent;
+
+	CXRunCounter::TEvent XRun;
+
+	switch (Event)
+	{
+	case MenuEventUpdate:
+		rEvent = 0;
+		break;
+
+	case MenuEventUpdateParameter:
+		break;
+
+	case MenuEventStepDown:
+		if (rEvent > 0)
+		{
+			rEvent--;
+		}
+		break;
+
+	case MenuEventStepUp:
+		if (pXRunCounter->GetEvent (rEvent, &XRun))
+		{
+			rEvent++;
+		}
+		break;
+
+	default:
+		return;
+	}
+
+	std::string Name;
+	std::string Value;
+	if (!rEvent)
+	{
+		Name = "Total";
+		Value =   "U " + std::to_string (pXRunCounter->GetCount (CXRunCounter::XRunUnderrun))
+			+ " O " + std::to_string (pXRunCounter->GetCount (CXRunCounter::XRunOverrun));
+	}
+	else if (pXRunCounter->GetEvent (rEvent-1, &XRun))
+	{
+		Name = "#" + std::to_string (rEvent);
+		Value =   (XRun.Type == CXRunCounter::XRunUnderrun ? "U " : "O ")
+			+ std::to_string (XRun.nChunkMicros) + "us "
+			+ std::to_string (XRun.nActiveVoices) + "v";
+	}
+	else
+	{
+		Name = "#" + std::to_string (rEvent);
+		Value = "Expired";
+	}
+
+	pUIMenu->m_pUI->DisplayWrite (pUIMenu->m_pParentMenu[pUIMenu->m_nCurrentMenuItem].Name,
+				      Name.c_str (), Value.c_str (),
+				      rEvent > 0, pXRunCounter->GetEvent (rEvent, &XRun));
+}
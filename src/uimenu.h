@@ -26,6 +26,7 @@
 #include <string>
 #include <circle/timer.h>
 #include "config.h"
+#include "perftimer.h"
 
 class CMiniDexed;
 class CUserInterface;
@@ -97,6 +98,8 @@ private:
 	static void SavePerformanceNewFile (CUIMenu *pUIMenu, TMenuEvent Event);
 	static void EditPerformanceBankNumber (CUIMenu *pUIMenu, TMenuEvent Event);
 	static void EditMasterVolume (CUIMenu *pUIMenu, TMenuEvent Event);
+	static void ShowProfile (CUIMenu *pUIMenu, TMenuEvent Event);
+	static void ShowDropouts (CUIMenu *pUIMenu, TMenuEvent Event);
 	
 	static std::string GetGlobalValueString (unsigned nParameter, int nValue);
 	static std::string GetTGValueString (unsigned nTGParameter, int nValue);
@@ -162,6 +165,7 @@ private:
 	static const TMenuItem s_EditPitchBendMenu[];
 	static const TMenuItem s_EditPortamentoMenu[];
 	static const TMenuItem s_PerformanceMenu[];
+	static const TMenuItem s_ProfileMenu[];
 	
 	static const TMenuItem s_ModulationMenu[];
 	static const TMenuItem s_ModulationMenuParameters[];
@@ -181,6 +185,8 @@ private:
 	unsigned m_nSelectedPerformanceID =0;
 	unsigned m_nSelectedPerformanceBankID =0;
 	bool m_bSplashShow=false;
+	unsigned m_nProfileCore=CPerformanceTimer::AllCores;
+	unsigned m_nDropoutEvent=0;			// 0 for the counts, else the n-th last event
 
 };
 
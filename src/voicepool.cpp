@@ -0,0 +1,219 @@
+//
+// voicepool.cpp
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "voicepool.h"
+#include <circle/logger.h>
+#include <assert.h>
+
+LOGMODULE ("voicepool");
+
+static const unsigned SizeShift = 4;		// the size grows by 1/16 of the difference per chunk
+static const unsigned MinMeasureVoices = 4;	// below the load is dominated by mixing and effects
+
+CVoicePool::CVoicePool (unsigned nToneGenerators, unsigned nMinVoices, unsigned nMaxVoices,
+			unsigned nTargetLoad)
+:	m_nToneGenerators (nToneGenerators),
+	m_nMinVoices (nMinVoices),
+	m_nMaxVoices (nMaxVoices),
+	m_nTargetLoad (nTargetLoad),
+	m_nSize (nMinVoices),
+	m_nSizeFraction (nMinVoices << SizeShift),
+	m_nStolen (0),
+	m_nDropped (0),
+	m_nStolenLogged (0),
+	m_nDroppedLogged (0),
+	m_nLastDumpTicks (0)
+{
+	assert (nToneGenerators <= CConfig::AllToneGenerators);
+	assert (0 < nMinVoices && nMinVoices <= nMaxVoices);
+	assert (0 < nTargetLoad && nTargetLoad <= 100);
+
+	for (unsigned nTG = 0; nTG < CConfig::AllToneGenerators; nTG++)
+	{
+		m_nPriority[nTG] = 0;
+		m_nReserve[nTG] = 0;
+		m_nVoices[nTG] = 0;
+		m_nAllocated[nTG] = 0;
+	}
+}
+
+void CVoicePool::SetPriority (unsigned nPriority, unsigned nTG)
+{
+	assert (nTG < CConfig::AllToneGenerators);
+	m_nPriority[nTG] = nPriority <= MaxPriority ? nPriority : MaxPriority;
+}
+
+void CVoicePool::SetReserve (unsigned nVoices, unsigned nTG)
+{
+	assert (nTG < CConfig::AllToneGenerators);
+	m_nReserve[nTG] = nVoices;
+}
+
+bool CVoicePool::Allocate (unsigned nTG, unsigned *pStealTG)
+{
+	assert (nTG < m_nToneGenerators);
+	assert (pStealTG);
+
+	*pStealTG = NoTG;
+
+	m_SpinLock.Acquire ();
+
+	unsigned nVoices[CConfig::AllToneGenerators];
+	unsigned nTotal = 0;
+	for (unsigned i = 0; i < m_nToneGenerators; i++)
+	{
+		nVoices[i] =   m_nVoices[i].load (std::memory_order_relaxed)
+			     + m_nAllocated[i].load (std::memory_order_relaxed);
+		nTotal += nVoices[i];
+	}
+
+	bool bAllocate = true;
+	if (nTotal >= m_nSize.load (std::memory_order_relaxed))
+	{
+		bool bReserved = nVoices[nTG] < m_nReserve[nTG];
+
+		unsigned nVictim = NoTG;
+		for (unsigned i = 0; i < m_nToneGenerators; i++)
+		{
+			if (nVoices[i] <= m_nReserve[i])
+			{
+				continue;			// reserved voices are not stolen
+			}
+
+			if (   !bReserved
+			    && m_nPriority[i] > m_nPriority[nTG])
+			{
+				continue;
+			}
+
+			if (   nVictim == NoTG
+			    || m_nPriority[i] < m_nPriority[nVictim]
+			    || (   m_nPriority[i] == m_nPriority[nVictim]
+				&& nVoices[i] - m_nReserve[i] > nVoices[nVictim] - m_nReserve[nVictim]))
+			{
+				nVictim = i;
+			}
+		}
+
+		if (nVictim != NoTG)
+		{
+			*pStealTG = nVictim;
+			m_nStolen.fetch_add (1, std::memory_order_relaxed);
+		}
+		else if (!bReserved)
+		{
+			bAllocate = false;
+			m_nDropped.fetch_add (1, std::memory_order_relaxed);
+		}
+	}
+
+	if (bAllocate)
+	{
+		m_nAllocated[nTG].fetch_add (1, std::memory_order_relaxed);
+	}
+
+	m_SpinLock.Release ();
+
+	return bAllocate;
+}
+
+void CVoicePool::SetVoices (unsigned nVoices, unsigned nTG)
+{
+	assert (nTG < CConfig::AllToneGenerators);
+
+	m_nVoices[nTG].store (nVoices, std::memory_order_relaxed);
+	m_nAllocated[nTG].store (0, std::memory_order_relaxed);
+}
+
+// The load of the audio path is assumed to be proportional to the number
+// of voices. The size is set to the number of voices, which would give the
+// target load. It shrinks immediately, but grows slowly, so that a short
+// burst of headroom does not admit more voices than can be rendered later.
+void CVoicePool::Update (unsigned nChunkMicros, unsigned nPeriodMicros)
+{
+	unsigned nVoices = GetVoices ();
+	if (   nVoices < MinMeasureVoices
+	    || !nChunkMicros)
+	{
+		return;
+	}
+
+	unsigned nTarget = (unsigned long long) nVoices * nPeriodMicros * m_nTargetLoad
+			   / (nChunkMicros * 100ULL);
+	if (nTarget < m_nMinVoices)
+	{
+		nTarget = m_nMinVoices;
+	}
+	else if (nTarget > m_nMaxVoices)
+	{
+		nTarget = m_nMaxVoices;
+	}
+
+	if (nTarget << SizeShift < m_nSizeFraction)
+	{
+		m_nSizeFraction = nTarget << SizeShift;
+	}
+	else
+	{
+		m_nSizeFraction += (  (nTarget << SizeShift) - m_nSizeFraction
+				    + (1 << SizeShift) - 1) >> SizeShift;
+	}
+
+	m_nSize.store (m_nSizeFraction >> SizeShift, std::memory_order_relaxed);
+}
+
+unsigned CVoicePool::GetSize (void) const
+{
+	return m_nSize.load (std::memory_order_relaxed);
+}
+
+unsigned CVoicePool::GetVoices (void) const
+{
+	unsigned nTotal = 0;
+	for (unsigned nTG = 0; nTG < m_nToneGenerators; nTG++)
+	{
+		nTotal += m_nVoices[nTG].load (std::memory_order_relaxed);
+	}
+
+	return nTotal;
+}
+
+void CVoicePool::Dump (unsigned nIntervalTicks)
+{
+	unsigned nTicks = CTimer::GetClockTicks ();
+	if (nTicks - m_nLastDumpTicks < nIntervalTicks)
+	{
+		return;
+	}
+
+	unsigned nStolen = m_nStolen.load (std::memory_order_relaxed);
+	unsigned nDropped = m_nDropped.load (std::memory_order_relaxed);
+	if (   nStolen == m_nStolenLogged
+	    && nDropped == m_nDroppedLogged)
+	{
+		return;
+	}
+
+	LOGNOTE ("%u voices stolen, %u notes dropped (%u of %u voices playing)",
+		 nStolen - m_nStolenLogged, nDropped - m_nDroppedLogged, GetVoices (), GetSize ());
+
+	m_nLastDumpTicks = nTicks;
+	m_nStolenLogged = nStolen;
+	m_nDroppedLogged = nDropped;
+}
@@ -0,0 +1,98 @@
+//
+// voicepool.h
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _voicepool_h
+#define _voicepool_h
+
+#include <atomic>
+#include <circle/spinlock.h>
+#include <circle/timer.h>
+#include "config.h"
+
+// Shares one budget of voices between all TGs instead of a fixed polyphony
+// per TG. The size of the pool follows the measured load of the audio path,
+// so that quiet TGs leave their capacity to busy ones.
+//
+// A new note takes a free voice from the pool. If the pool is full, a voice
+// is stolen from the TG with the lowest priority, which plays more voices
+// than it has reserved, and the most voices on a tie. A TG can steal from
+// TGs of the same or a lower priority only, but always from TGs exceeding
+// their reservation, while it is below its own. If no voice can be stolen,
+// the note is dropped.
+
+class CVoicePool
+{
+public:
+	static const unsigned MaxPriority = 7;
+	static const unsigned NoTG = CConfig::AllToneGenerators;
+
+public:
+	// nTargetLoad is the share of the chunk duration (in percent), which
+	// the audio path should use
+	CVoicePool (unsigned nToneGenerators, unsigned nMinVoices, unsigned nMaxVoices,
+		    unsigned nTargetLoad);
+
+	void SetPriority (unsigned nPriority, unsigned nTG);	// 0 .. MaxPriority
+	void SetReserve (unsigned nVoices, unsigned nTG);
+
+	// MIDI path: takes a voice for a new note on this TG, returns false if
+	// the note has to be dropped. *pStealTG is set to the TG, which has to
+	// release a voice for it, or to NoTG.
+	bool Allocate (unsigned nTG, unsigned *pStealTG);
+
+	// audio path: the voices of a TG after it has been rendered, including
+	// notes, which have been queued, but not started yet
+	void SetVoices (unsigned nVoices, unsigned nTG);
+
+	// audio path: adapts the size to the processing time of the last chunk,
+	// in pipelined mode to the time to render it
+	void Update (unsigned nChunkMicros, unsigned nPeriodMicros);
+
+	unsigned GetSize (void) const;
+	unsigned GetVoices (void) const;			// of all TGs
+
+	// logs the notes stolen and dropped since the previous call, at most once per interval
+	void Dump (unsigned nIntervalTicks = CLOCKHZ);
+
+private:
+	unsigned m_nToneGenerators;
+	unsigned m_nMinVoices;
+	unsigned m_nMaxVoices;
+	unsigned m_nTargetLoad;
+
+	unsigned m_nPriority[CConfig::AllToneGenerators];
+	unsigned m_nReserve[CConfig::AllToneGenerators];
+
+	// from the audio path, plus the voices allocated since then
+	std::atomic<unsigned> m_nVoices[CConfig::AllToneGenerators];
+	std::atomic<unsigned> m_nAllocated[CConfig::AllToneGenerators];
+
+	std::atomic<unsigned> m_nSize;
+	unsigned m_nSizeFraction;				// size << SizeShift, smoothed
+
+	std::atomic<unsigned> m_nStolen;
+	std::atomic<unsigned> m_nDropped;
+	unsigned m_nStolenLogged;
+	unsigned m_nDroppedLogged;
+	unsigned m_nLastDumpTicks;
+
+	CSpinLock m_SpinLock;					// serializes Allocate()
+};
+
+#endif
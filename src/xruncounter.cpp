@@ -0,0 +1,119 @@
+//
+// xruncounter.cpp
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "xruncounter.h"
+#include <circle/logger.h>
+#include <assert.h>
+
+LOGMODULE ("xrun");
+
+static const char *XRunName[CXRunCounter::XRunUnknown] = {"Underrun", "Overrun"};
+
+CXRunCounter::CXRunCounter (void)
+:	m_nEvents (0),
+	m_nEventsLogged (0),
+	m_nLastDumpTicks (0)
+{
+	for (unsigned i = 0; i < XRunUnknown; i++)
+	{
+		m_nCount[i] = 0;
+	}
+}
+
+void CXRunCounter::Record (TXRun Type, unsigned nChunkMicros, unsigned nActiveVoices, unsigned nQueueFrames)
+{
+	assert (Type < XRunUnknown);
+
+	// there is only one writer, the counters need not be incremented atomically
+	m_nCount[Type].store (m_nCount[Type].load (std::memory_order_relaxed) + 1,
+			      std::memory_order_relaxed);
+
+	unsigned nEvents = m_nEvents.load (std::memory_order_relaxed);
+
+	TEvent &rEvent = m_Event[nEvents % MaxEvents];
+	rEvent.Type = Type;
+	rEvent.nTicks = CTimer::GetClockTicks ();
+	rEvent.nChunkMicros = nChunkMicros;
+	rEvent.nActiveVoices = nActiveVoices;
+	rEvent.nQueueFrames = nQueueFrames;
+
+	m_nEvents.store (nEvents + 1, std::memory_order_release);
+}
+
+unsigned CXRunCounter::GetCount (TXRun Type) const
+{
+	assert (Type < XRunUnknown);
+
+	return m_nCount[Type].load (std::memory_order_relaxed);
+}
+
+bool CXRunCounter::GetEvent (unsigned nIndex, TEvent *pEvent) const
+{
+	assert (pEvent);
+
+	unsigned nEvents = m_nEvents.load (std::memory_order_acquire);
+	if (   nIndex >= MaxEvents
+	    || nIndex >= nEvents)
+	{
+		return false;
+	}
+
+	unsigned nEvent = nEvents - 1 - nIndex;
+	*pEvent = m_Event[nEvent % MaxEvents];
+
+	// the event may have been overwritten by Record() meanwhile
+	std::atomic_thread_fence (std::memory_order_acquire);
+
+	return m_nEvents.load (std::memory_order_relaxed) - nEvent <= MaxEvents;
+}
+
+void CXRunCounter::Dump (unsigned nIntervalTicks)
+{
+	unsigned nTicks = CTimer::GetClockTicks ();
+	if (nTicks - m_nLastDumpTicks < nIntervalTicks)
+	{
+		return;
+	}
+
+	unsigned nEvents = m_nEvents.load (std::memory_order_acquire);
+	unsigned nNewEvents = nEvents - m_nEventsLogged;
+	if (!nNewEvents)
+	{
+		return;
+	}
+
+	m_nLastDumpTicks = nTicks;
+	m_nEventsLogged = nEvents;
+
+	LOGWARN ("%u dropouts (%u underruns, %u overruns since start)", nNewEvents,
+		 GetCount (XRunUnderrun), GetCount (XRunOverrun));
+
+	// oldest first
+	unsigned nIndex = nNewEvents < MaxEvents ? nNewEvents : MaxEvents;
+	while (nIndex--)
+	{
+		TEvent Event;
+		if (GetEvent (nIndex, &Event))
+		{
+			LOGNOTE ("%s %ums ago: chunk %uus, %u voices, %u frames queued",
+				 XRunName[Event.Type], (nTicks - Event.nTicks) / (CLOCKHZ / 1000),
+				 Event.nChunkMicros, Event.nActiveVoices, Event.nQueueFrames);
+		}
+	}
+}
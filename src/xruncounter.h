@@ -0,0 +1,76 @@
+//
+// xruncounter.h
+//
+// MiniDexed - Dexed FM synthesizer for bare metal Raspberry Pi
+// Copyright (C) 2022  The MiniDexed Team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _xruncounter_h
+#define _xruncounter_h
+
+#include <atomic>
+#include <circle/timer.h>
+#include <circle/types.h>
+
+// Counts the dropouts of the sound output and keeps the last events with the
+// state of the audio path at that time. Record() is called from the audio
+// path only and does not lock or log. The events are logged from the main
+// loop with Dump() and can be read from any core.
+
+class CXRunCounter
+{
+public:
+	enum TXRun
+	{
+		XRunUnderrun,			// the queue ran empty before the chunk was written
+		XRunOverrun,			// the chunk did not fit into the queue
+		XRunUnknown
+	};
+
+	struct TEvent
+	{
+		TXRun Type;
+		unsigned nTicks;		// clock ticks, when it was detected
+		unsigned nChunkMicros;		// processing time of the chunk until then
+		unsigned nActiveVoices;
+		unsigned nQueueFrames;		// frames in the sound queue
+	};
+
+	static const unsigned MaxEvents = 8;
+
+public:
+	CXRunCounter (void);
+
+	void Record (TXRun Type, unsigned nChunkMicros, unsigned nActiveVoices, unsigned nQueueFrames);
+
+	unsigned GetCount (TXRun Type) const;
+
+	// index 0 is the most recent event, returns false if there is no such event
+	bool GetEvent (unsigned nIndex, TEvent *pEvent) const;
+
+	// logs the events recorded since the previous call, at most once per interval
+	void Dump (unsigned nIntervalTicks = CLOCKHZ);
+
+private:
+	std::atomic<unsigned> m_nCount[XRunUnknown];
+
+	TEvent m_Event[MaxEvents];			// ring, written by Record() only
+	std::atomic<unsigned> m_nEvents;		// recorded since start
+
+	unsigned m_nEventsLogged;
+	unsigned m_nLastDumpTicks;
+};
+
+#endif
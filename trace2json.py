@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Converts the audio trace of MiniDexed (built with "make TRACE=1") to the
+Chrome trace format, which can be opened in chrome://tracing or
+https://ui.perfetto.dev. Each core is shown as a thread.
+
+Receive the trace from MiniDexed (NetworkSyslogServerIPAddress must point
+to this host) until Ctrl-C is pressed:
+
+    ./trace2json.py -l trace.json
+
+Convert a trace file written with "minidexed_host -T file.trace":
+
+    ./trace2json.py file.trace trace.json
+"""
+
+import argparse
+import json
+import socket
+import statistics
+import struct
+import sys
+
+TRACE_PORT = 8515
+
+HEADER = struct.Struct('<IBBHI')	# magic, version, core, records, lost
+RECORD = struct.Struct('<II')		# ticks, event | arg << 8
+MAGIC = 0x5254444D
+VERSION = 1
+
+# TTraceEvent in src/trace.h: name, phase (B/E for a stage, i for an event)
+EVENTS = [
+    (None, None),
+    ('Chunk', 'B'), ('Chunk', 'E'),
+    ('Wait', 'B'), ('Wait', 'E'),
+    ('Render', 'B'), ('Render', 'E'),
+    ('Mix', 'B'), ('Mix', 'E'),
+    ('Reverb', 'B'), ('Reverb', 'E'),
+    ('Write', 'B'), ('Write', 'E'),
+    ('MIDI', 'i'),
+    ('KeyDown', 'i'),
+    ('KeyUp', 'i'),
+    ('Applied', 'i'),
+    ('XRun', 'i'),
+    ('CoreStart', 'i'),
+]
+
+# TEventType in src/dexedadapter.h
+APPLIED_EVENTS = ['KeyDown', 'KeyUp', 'Sustain', 'Sostenuto', 'Hold', 'Panic',
+                  'NotesOff', 'ControllersRefresh', 'StealVoice', 'Pitchbend',
+                  'ModWheel', 'BreathController', 'FootController', 'Aftertouch',
+                  'LoadVoice']
+
+
+def parse_packets(data, packets):
+    """Splits a byte stream of packets, returns the unused rest."""
+    while len(data) >= HEADER.size:
+        magic, version, core, records, lost = HEADER.unpack_from(data)
+        if magic != MAGIC or version != VERSION:
+            raise ValueError('Invalid trace packet')
+        size = HEADER.size + records * RECORD.size
+        if len(data) < size:
+            break
+        packets.append(data[:size])
+        data = data[size:]
+    return data
+
+
+def receive(port):
+    server = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    server.bind(('0.0.0.0', port))
+    server.settimeout(0.5)
+    print(f'Receiving trace on port {port}, press Ctrl-C to stop', file=sys.stderr)
+
+    packets = []
+    try:
+        while True:
+            try:
+                data, _ = server.recvfrom(65536)
+            except socket.timeout:
+                continue
+            parse_packets(data, packets)
+    except KeyboardInterrupt:
+        pass
+    return packets
+
+
+def format_arg(name, arg):
+    if name == 'MIDI':
+        return {'message': ' '.join(f'{(arg >> shift) & 0xFF:02X}' for shift in (0, 8, 16))}
+    if name == 'Applied':
+        event = arg & 0xFF
+        return {'event': APPLIED_EVENTS[event] if event < len(APPLIED_EVENTS) else event,
+                'pitch': arg >> 8}
+    if name in ('KeyDown', 'KeyUp'):
+        return {'pitch': arg}
+    if name == 'Render':
+        return {'tg': arg + 1}
+    if name == 'Write':
+        return {'queued': arg}
+    if name == 'XRun':
+        return {'type': 'overrun' if arg else 'underrun'}
+    return {'arg': arg}
+
+
+def convert(packets):
+    events = []
+    cores = set()
+    last_ticks = {}
+    wrap = {}
+    key_down = {}
+    latencies = []
+    lost_total = 0
+
+    for packet in packets:
+        _, _, core, records, lost = HEADER.unpack_from(packet)
+        cores.add(core)
+
+        for i in range(records):
+            ticks, event_arg = RECORD.unpack_from(packet, HEADER.size + i * RECORD.size)
+
+            # the 32-bit clock wraps after about 71 minutes
+            if ticks < last_ticks.get(core, 0) - 0x80000000:
+                wrap[core] = wrap.get(core, 0) + 0x100000000
+            last_ticks[core] = ticks
+            ts = ticks + wrap.get(core, 0)
+
+            event, arg = event_arg & 0xFF, event_arg >> 8
+            if event == 0 or event >= len(EVENTS):
+                continue
+            name, phase = EVENTS[event]
+
+            record = {'name': name, 'ph': phase, 'ts': ts, 'pid': 0, 'tid': core,
+                      'args': format_arg(name, arg)}
+            if phase == 'i':
+                record['s'] = 't'
+            events.append(record)
+
+            # latency from queueing a key down to applying it while rendering
+            if name == 'KeyDown':
+                key_down.setdefault(arg, []).append(ts)
+            elif name == 'Applied' and (arg & 0xFF) == 0:
+                pending = key_down.get(arg >> 8)
+                if pending:
+                    latencies.append(ts - pending.pop(0))
+
+        if lost:
+            lost_total += lost
+            events.append({'name': f'{lost} records lost', 'ph': 'i', 's': 't',
+                           'ts': last_ticks.get(core, 0) + wrap.get(core, 0),
+                           'pid': 0, 'tid': core})
+
+    for core in sorted(cores):
+        events.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': core,
+                       'args': {'name': f'Core {core}'}})
+
+    print(f'{len(events)} events from {len(cores)} cores, {lost_total} records lost',
+          file=sys.stderr)
+    if latencies:
+        print(f'Key down to render latency: median {statistics.median(latencies):.0f}us, '
+              f'max {max(latencies)}us ({len(latencies)} notes)', file=sys.stderr)
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert a MiniDexed audio trace to Chrome trace JSON')
+    parser.add_argument('-l', '--listen', action='store_true', help='receive the trace via UDP')
+    parser.add_argument('-p', '--port', type=int, default=TRACE_PORT, help='UDP port (default %(default)s)')
+    parser.add_argument('files', nargs='+', metavar='FILE', help='[trace file] output JSON file')
+    args = parser.parse_args()
+
+    if args.listen:
+        if len(args.files) != 1:
+            parser.error('only the output file is expected with -l')
+        packets = receive(args.port)
+    else:
+        if len(args.files) != 2:
+            parser.error('a trace file and the output file are expected')
+        with open(args.files[0], 'rb') as trace_file:
+            packets = []
+            if parse_packets(trace_file.read(), packets):
+                print('Trace file is truncated', file=sys.stderr)
+
+    with open(args.files[-1], 'w') as json_file:
+        json.dump(convert(packets), json_file)
+
+
+if __name__ == '__main__':
+    main()